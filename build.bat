@@ -4,8 +4,10 @@ if not exist build mkdir build
 
 set compiler_flags=-std=c99 -g -Wall -Wextra -Werror -Wvla -Wno-unused-function
 set linker_flags=-lkernel32 -luser32 -lgdi32
-set defines=-D_DEBUG -D_CRT_SECURE_NO_WARNINGS
+set defines=-D_DEBUG -D_CRT_SECURE_NO_WARNINGS -DTGUI_PROFILE
 set include_path=code/
 
 clang code/tgui_win32.c -o build/tgui.exe -I%include_path% %compiler_flags% %defines% %linker_flags%
+clang code/tgui_packer.c -o build/tgui_packer.exe -I%include_path% %compiler_flags% %defines% -lkernel32
+clang code/tgui_replay.c -o build/tgui_replay.exe -I%include_path% %compiler_flags% %defines% -lkernel32
 rem  -fsanitize=address
@@ -0,0 +1,13 @@
+#!/bin/sh
+
+mkdir -p build
+
+compiler_flags="-std=c99 -g -Wall -Wextra -Werror -Wvla -Wno-unused-function"
+linker_flags="-lpthread -lm"
+defines="-D_DEBUG -DTGUI_PROFILE"
+include_path=code/
+
+cc code/tgui_linux.c -o build/tgui -I$include_path $compiler_flags $defines $linker_flags -lX11
+cc code/tgui_packer.c -o build/tgui_packer -I$include_path $compiler_flags $defines $linker_flags
+cc code/tgui_replay.c -o build/tgui_replay -I$include_path $compiler_flags $defines $linker_flags
+# -fsanitize=address
@@ -6,6 +6,27 @@
 #include <string.h>
 #include <math.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TGUI_SSE2 1
+#endif
+
+// NOTE: only acquire/release is needed to publish data between threads
+#define TGUI_ATOMIC_LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define TGUI_ATOMIC_STORE(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+
 // TODO: Maybe the state should be provided by the application?
 TGuiState tgui_global_state;
 
@@ -73,7 +94,7 @@ inline static f32 tgui_v2_lenght_sqrt(TGuiV2 v)
     return result;
 }
 
-inline static TGuiRect tgui_rect_xywh(f32 x, f32 y, f32 width, f32 height)
+TGuiRect tgui_rect_xywh(f32 x, f32 y, f32 width, f32 height)
 {
     TGuiRect result;
     result.x = x;
@@ -97,13 +118,26 @@ inline static TGuiV2 tgui_v2_normalize(TGuiV2 v)
     return result;
 }
 
-static b32 tgui_point_inside_rect(TGuiV2 point, TGuiRect rect)
+b32 tgui_point_inside_rect(TGuiV2 point, TGuiRect rect)
 {
     b32 result = point.x >= rect.x && point.x < (rect.x + rect.width) &&
                  point.y >= rect.y && point.y < (rect.y + rect.height);
     return result;
 }
 
+// NOTE: only the widgets use this one, so the hit tests can be counted
+inline static b32 tgui_mouse_hit_test(TGuiV2 mouse, TGuiRect rect)
+{
+    TGUI_PROFILE_COUNT(TGUI_COUNTER_HIT_TESTS, 1);
+    return tgui_point_inside_rect(mouse, rect);
+}
+
+// NOTE: the widgets that change with the time ask for a frame at that time, tgui_update return the earliest
+inline static void tgui_request_deadline(TGuiState *state, f64 time)
+{
+    if(state->deadline == 0 || time < state->deadline) state->deadline = time;
+}
+
 typedef struct TGuiClipResult
 {
     i32 min_x; 
@@ -158,32 +192,17 @@ static TGuiClipResult tgui_clip_rect(i32 min_x, i32 min_y, i32 max_x, i32 max_y,
 // NOTE: GUI lib functions
 //-----------------------------------------------------
 
-static void tgui_safe_memcpy(void *dst, void *src, u64 number_bytes)
+// NOTE: the workers of the layout can move widgets too, so it is atomic
+inline static void tgui_layout_changed(void)
 {
-    if(dst < src)
-    {
-        for(u64 index = 0; index < number_bytes; ++index)
-        {
-            u8 *dst_ptr = (u8 *)dst + index;
-            u8 *src_ptr = (u8 *)src + index;
-            *dst_ptr = *src_ptr;
-        }
-    }
-    else if(dst > src)
-    {
-        for(u64 index = 0; index < number_bytes; ++index)
-        {
-            u8 *dst_ptr = (u8 *)(dst + (number_bytes - 1)) - index;
-            u8 *src_ptr = (u8 *)(src + (number_bytes - 1)) - index;
-            *dst_ptr = *src_ptr;
-        }
-    }
+    __atomic_fetch_add(&tgui_global_state.layout_version, 1, __ATOMIC_RELAXED);
 }
 
 inline static TGuiWidget *tgui_create_widget(TGuiHandle *handle)
 {
     TGuiState *state = &tgui_global_state;
     *handle = tgui_widget_allocator_pool(&state->widget_allocator);
+    tgui_layout_changed();
     TGuiWidget *widget = tgui_widget_get(*handle);
     memset(widget, 0, sizeof(TGuiWidget));
     widget->header.handle = *handle;
@@ -191,6 +210,83 @@ inline static TGuiWidget *tgui_create_widget(TGuiHandle *handle)
     return widget;
 }
 
+// NOTE: the types of the application are after the types of TGUI_WIDGET_TYPES
+static TGuiWidgetClass *tgui_widget_class(TGuiWidgetType type)
+{
+    TGuiWidgetRegistry *registry = &tgui_global_state.registry;
+    u32 class_index = (u32)type - TGUI_COUNT;
+    ASSERT(type >= TGUI_COUNT && class_index < registry->class_count);
+    return registry->classes + class_index;
+}
+
+// NOTE: the size of every type from its own data, the size of the containers is set by the layout
+static TGuiV2 tgui_container_measure(TGuiWidgetContainer *container)
+{
+    return container->header.size;
+}
+
+static TGuiV2 tgui_end_container_measure(TGuiWidgetEndContainer *end_container)
+{
+    UNUSED_VAR(end_container);
+    return tgui_v2(0, 0);
+}
+
+static TGuiV2 tgui_button_measure(TGuiWidgetButton *button)
+{
+    UNUSED_VAR(button);
+    return tgui_v2(100, 30);
+}
+
+static TGuiV2 tgui_checkbox_measure(TGuiWidgetCheckBox *checkbox)
+{
+    TGuiV2 size = checkbox->box_dimension;
+    size.x += checkbox->text.size.x+5;
+    return size;
+}
+
+static TGuiV2 tgui_slider_measure(TGuiWidgetSlider *slider)
+{
+    return tgui_v2(120, slider->grip_dimension.y);
+}
+
+static TGuiV2 tgui_textbox_measure(TGuiWidgetTextBox *textbox)
+{
+    return tgui_v2_add(textbox->dimension, tgui_v2(textbox->margin*2, textbox->margin*2));
+}
+
+static TGuiV2 tgui_textview_measure(TGuiWidgetTextView *textview)
+{
+    return tgui_v2_add(textview->dimension, tgui_v2(textview->margin*2, textview->margin*2));
+}
+
+static TGuiV2 tgui_plot_measure(TGuiWidgetPlot *plot)
+{
+    return plot->dimension;
+}
+
+static TGuiV2 tgui_grid_measure(TGuiWidgetGrid *grid)
+{
+    return grid->dimension;
+}
+
+static TGuiV2 tgui_tree_measure(TGuiWidgetTree *tree)
+{
+    return tree->dimension;
+}
+
+static TGuiV2 tgui_widget_measure(TGuiWidget *widget)
+{
+    switch(widget->header.type)
+    {
+#define TGUI_WIDGET_MEASURE(type, name, type_struct) case type: return tgui_##name##_measure((type_struct *)widget);
+        TGUI_WIDGET_TYPES(TGUI_WIDGET_MEASURE)
+#undef TGUI_WIDGET_MEASURE
+        default: break;
+    }
+    TGuiWidgetClass *widget_class = tgui_widget_class(widget->header.type);
+    return widget_class->measure ? widget_class->measure(widget) : widget->header.size;
+}
+
 inline static TGuiHandle tgui_create_end_container(void)
 {
     TGuiHandle handle = TGUI_INVALID_HANDLE;
@@ -253,9 +349,9 @@ TGuiHandle tgui_create_button(char *label)
     TGuiHandle handle = TGUI_INVALID_HANDLE;
     TGuiWidget *widget = tgui_create_widget(&handle); 
     widget->header.type = TGUI_BUTTON;
-    widget->header.size = tgui_v2(100, 30);
     widget->button.pressed = false;
     tgui_widget_set_text(&widget->button.text, label);
+    widget->header.size = tgui_button_measure(&widget->button);
     return handle;
 }
 
@@ -266,8 +362,7 @@ TGuiHandle tgui_create_checkbox(char *label)
     widget->header.type = TGUI_CHECKBOX;
     widget->checkbox.box_dimension = tgui_v2(20, 20);
     tgui_widget_set_text(&widget->checkbox.text, label);
-    widget->header.size = widget->checkbox.box_dimension;
-    widget->header.size.x += widget->checkbox.text.size.x+5;
+    widget->header.size = tgui_checkbox_measure(&widget->checkbox);
     return handle;
 }
 
@@ -279,7 +374,7 @@ TGuiHandle tgui_create_slider(void)
     widget->slider.ratio = 0.5f;
     widget->slider.value = 0.5f;
     widget->slider.grip_dimension = tgui_v2(15, 15);
-    widget->header.size = tgui_v2(120, widget->slider.grip_dimension.y);
+    widget->header.size = tgui_slider_measure(&widget->slider);
     return handle;
 }
 
@@ -293,16 +388,138 @@ TGuiHandle tgui_create_textbox(u32 width, u32 height)
     widget->textbox.margin = 10;
     widget->textbox.dimension = tgui_v2_sub(tgui_v2(width, height), tgui_v2(widget->textbox.margin*2, widget->textbox.margin*2));
     widget->textbox.cursor_position = tgui_v2i(0, 0);
-    tgui_line_allocator_create(&widget->textbox.allocator);
-    tgui_line_allocator_pull(&widget->textbox.allocator);
+    tgui_text_buffer_create(&widget->textbox.text);
+    
+    return handle;
+}
+
+static void tgui_textview_index_add_checkpoint(TGuiTextViewIndex *index, u64 checkpoint, u64 offset);
+static void tgui_textview_index_thread(void *data);
+
+static void tgui_textview_open(TGuiWidgetTextView *textview, char *path)
+{
+    u32 path_size = (u32)strlen(path);
+    textview->path = (char *)malloc(path_size + 1);
+    memcpy(textview->path, path, path_size + 1);
+
+    // NOTE: the index is not store in the widget, the widget buffer can be reallocated while the thread is running
+    textview->index = (TGuiTextViewIndex *)malloc(sizeof(TGuiTextViewIndex));
+    memset(textview->index, 0, sizeof(TGuiTextViewIndex));
+    // NOTE: the line 0 always start at offset 0, so the view can be render before the thread start
+    tgui_textview_index_add_checkpoint(textview->index, 0, 0);
+    textview->index->checkpoint_count = 1;
+    textview->index->line_count = 1;
+    if(tgui_platform_map_file(&textview->file, path))
+    {
+        textview->index->data = textview->file.data;
+        textview->index->size = textview->file.size;
+        textview->index_thread = tgui_platform_thread_create(tgui_textview_index_thread, textview->index);
+        if(!textview->index_thread)
+        {
+            // NOTE: if the thread cant be create the file is index here, before the create function return
+            tgui_textview_index_thread(textview->index);
+        }
+    }
+    else
+    {
+        // TODO: create a log to print errors
+        textview->index->done = true;
+    }
+}
+
+TGuiHandle tgui_create_textview(char *path, u32 width, u32 height)
+{
+    TGuiHandle handle = TGUI_INVALID_HANDLE;
+    TGuiWidget *widget = tgui_create_widget(&handle); 
+    widget->header.type = TGUI_TEXTVIEW;
+    widget->header.size = tgui_v2(width, height);
+    
+    TGuiWidgetTextView *textview = &widget->textview;
+    textview->margin = 10;
+    textview->dimension = tgui_v2_sub(tgui_v2(width, height), tgui_v2(textview->margin*2, textview->margin*2));
+    tgui_textview_open(textview, path);
+
+    return handle;
+}
+
+TGuiHandle tgui_create_plot(u32 width, u32 height)
+{
+    TGuiHandle handle = TGUI_INVALID_HANDLE;
+    TGuiWidget *widget = tgui_create_widget(&handle); 
+    widget->header.type = TGUI_PLOT;
     
+    TGuiWidgetPlot *plot = &widget->plot;
+    plot->dimension = tgui_v2(width, height);
+    plot->view_count = width;
+    plot->min_value = 0;
+    plot->max_value = 1;
+    plot->color = TGUI_ORANGE;
+    widget->header.size = tgui_plot_measure(plot);
+
+    return handle;
+}
+
+TGuiHandle tgui_create_grid(u32 width, u32 height)
+{
+    TGuiHandle handle = TGUI_INVALID_HANDLE;
+    TGuiWidget *widget = tgui_create_widget(&handle); 
+    widget->header.type = TGUI_GRID;
+    widget->grid.dimension = tgui_v2(width, height);
+    widget->header.size = tgui_grid_measure(&widget->grid);
+
+    return handle;
+}
+
+TGuiHandle tgui_create_tree(u32 width, u32 height)
+{
+    TGuiHandle handle = TGUI_INVALID_HANDLE;
+    TGuiWidget *widget = tgui_create_widget(&handle); 
+    widget->header.type = TGUI_TREE;
+    widget->tree.dimension = tgui_v2(width, height);
+    widget->tree.hot_row = TGUI_TREE_NONE;
+    widget->header.size = tgui_tree_measure(&widget->tree);
+
     return handle;
 }
 
+TGuiWidgetType tgui_register_widget_type(TGuiWidgetClass *widget_class)
+{
+    TGuiWidgetRegistry *registry = &tgui_global_state.registry;
+    if(registry->class_count == registry->class_size)
+    {
+        u32 new_class_size = registry->class_size ? registry->class_size*2 : 8;
+        TGuiWidgetClass *new_classes = (TGuiWidgetClass *)malloc(new_class_size*sizeof(TGuiWidgetClass));
+        memcpy(new_classes, registry->classes, registry->class_count*sizeof(TGuiWidgetClass));
+        free(registry->classes);
+        registry->classes = new_classes;
+        registry->class_size = new_class_size;
+    }
+    registry->classes[registry->class_count] = *widget_class;
+    return (TGuiWidgetType)(TGUI_COUNT + registry->class_count++);
+}
+
+TGuiHandle tgui_create_custom(TGuiWidgetType type, void *data)
+{
+    TGuiHandle handle = TGUI_INVALID_HANDLE;
+    TGuiWidget *widget = tgui_create_widget(&handle); 
+    widget->header.type = type;
+    widget->custom.data = data;
+    widget->header.size = tgui_widget_measure(widget);
+    return handle;
+}
+
+void *tgui_widget_get_custom_data(TGuiHandle handle)
+{
+    TGuiWidget *widget = tgui_widget_get(handle);
+    ASSERT(widget->header.type >= TGUI_COUNT);
+    return widget->custom.data;
+}
+
 void tgui_widget_to_root(TGuiHandle widget_handle)
 {
     TGuiState *state = &tgui_global_state;
     TGuiWidget *widget = tgui_widget_get(widget_handle);
+    tgui_layout_changed();
     if(!state->last_root)
     {
         state->last_root = widget_handle;
@@ -321,6 +538,7 @@ void tgui_set_widget_position(TGuiHandle widget_handle, f32 x, f32 y)
 {
     TGuiWidget *widget = tgui_widget_get(widget_handle);
     widget->header.position = tgui_v2(x, y);
+    tgui_layout_changed();
 }
 
 TGuiV2 tgui_widget_abs_pos(TGuiHandle handle)
@@ -412,16 +630,27 @@ static void tgui_container_set_container_total_size(TGuiWidgetContainer *contain
 
 static void tgui_container_recalculate_dimension(TGuiWidgetContainer *container)
 {
+    TGUI_PROFILE_BEGIN(layout);
     while(container)
     {
         TGuiWidget *first_child = tgui_widget_get(container->header.child_first);
         if(first_child)
         {
+            TGUI_SPAN_BEGIN(container_size);
             tgui_container_set_container_total_size(container, first_child);
+            TGUI_SPAN_END(container_size, container->header.handle, 0);
         }
         TGuiWidget *parent = tgui_widget_get(container->header.parent);
         container = &parent->container;
     }
+    TGUI_PROFILE_END(layout, timers[TGUI_TIMER_LAYOUT]);
+}
+
+// NOTE: the scroll is snap to whole pixels, so the content can be moved copying its pixels
+static TGuiV2 tgui_container_scroll_offset(TGuiWidgetContainer *container)
+{
+    TGuiV2 view_port_dimension = tgui_v2_sub(container->total_dimension, container->dimension);
+    return tgui_v2(floorf(container->horizontal_value * view_port_dimension.x), floorf(container->vertical_value * view_port_dimension.y));
 }
 
 static void tgui_container_set_childs_position(TGuiWidgetContainer *container, TGuiWidget *widget)
@@ -433,9 +662,10 @@ static void tgui_container_set_childs_position(TGuiWidgetContainer *container, T
     {
         TGuiWidget *widget_prev = tgui_widget_get(widget->header.sibling_prev);
         TGuiWidget *widget_next = tgui_widget_get(widget->header.sibling_next);
+        TGuiV2 old_position = widget->header.position;
         if((widget->header.type != TGUI_END_CONTAINER))
         {
-            TGuiV2 view_port_dimension = tgui_v2_sub(container->total_dimension, container->dimension);
+            TGuiV2 scroll_offset = tgui_container_scroll_offset(container);
             if(container->layout.type == TGUI_LAYOUT_VERTICAL)
             {
                 if(widget->header.handle != container_first_child) 
@@ -446,9 +676,9 @@ static void tgui_container_set_childs_position(TGuiWidgetContainer *container, T
                 else
                 {
                     widget->header.position.y = container->layout.padding;
-                    widget->header.position.y -= container->vertical_value * view_port_dimension.y;
+                    widget->header.position.y -= scroll_offset.y;
                     widget->header.position.x = container->layout.padding;
-                    widget->header.position.x -= container->horizontal_value * view_port_dimension.x;
+                    widget->header.position.x -= scroll_offset.x;
                 }
             }
             if(container->layout.type == TGUI_LAYOUT_HORIZONTAL)
@@ -461,28 +691,58 @@ static void tgui_container_set_childs_position(TGuiWidgetContainer *container, T
                 else
                 {
                     widget->header.position.x = container->layout.padding;
-                    widget->header.position.x -= container->horizontal_value * view_port_dimension.x;
+                    widget->header.position.x -= scroll_offset.x;
                     widget->header.position.y = container->layout.padding;
-                    widget->header.position.y -= container->vertical_value * view_port_dimension.y;
+                    widget->header.position.y -= scroll_offset.y;
                 }
             }
         }
+        if(old_position.x != widget->header.position.x || old_position.y != widget->header.position.y)
+        {
+            tgui_layout_changed();
+        }
         widget = widget_next;
     }
 }
 
 static void tgui_container_recalculate_widget_position(TGuiWidgetContainer *container)
 {
+    TGUI_PROFILE_BEGIN(layout);
     while(container)
     {
         TGuiWidget *last_child = tgui_widget_get(container->header.child_last);
         if(last_child)
         {
+            TGUI_SPAN_BEGIN(container_layout);
             tgui_container_set_childs_position(container, last_child);
+            TGUI_SPAN_END(container_layout, container->header.handle, 0);
         }
         TGuiWidget *parent = tgui_widget_get(container->header.parent);
         container = (TGuiWidgetContainer *)parent;
     }
+    TGUI_PROFILE_END(layout, timers[TGUI_TIMER_LAYOUT]);
+}
+
+// NOTE: lay out every container of the subtree once, the position of the childs of a container only
+// depend on its own scroll and the size of the childs so the order is not important
+static void tgui_container_layout_subtree(TGuiWidgetContainer *container)
+{
+    TGuiWidget *child = tgui_widget_get(container->header.child_first);
+    while(child)
+    {
+        if(child->header.type == TGUI_CONTAINER)
+        {
+            tgui_container_layout_subtree(&child->container);
+        }
+        child = tgui_widget_get(child->header.sibling_next);
+    }
+    TGuiWidget *last_child = tgui_widget_get(container->header.child_last);
+    if(last_child)
+    {
+        TGUI_SPAN_BEGIN(container_layout);
+        tgui_container_set_childs_position(container, last_child);
+        TGUI_SPAN_END(container_layout, container->header.handle, 0);
+    }
 }
 
 void tgui_container_add_widget(TGuiHandle container_handle, TGuiHandle widget_handle)
@@ -506,6 +766,7 @@ void tgui_container_add_widget(TGuiHandle container_handle, TGuiHandle widget_ha
     }
     widget->header.sibling_prev = container->header.child_last; 
     container->header.child_last = widget_handle;
+    tgui_layout_changed();
     
     // NOTE: recalculate the dimensions
     tgui_container_recalculate_dimension(container);
@@ -513,31 +774,103 @@ void tgui_container_add_widget(TGuiHandle container_handle, TGuiHandle widget_ha
     tgui_container_recalculate_widget_position(container);
 }
 
-static TGuiRect tgui_widget_get_collision_box(TGuiWidget *widget)
+// NOTE: the collision box of every type, it start at the absolute position of the widget
+static TGuiRect tgui_container_collision_box(TGuiWidgetContainer *container, TGuiV2 abs_pos)
 {
     TGuiRect collision_box = {0};
-    collision_box.pos = tgui_widget_abs_pos(widget->header.handle);
-    if(widget->header.type == TGUI_CHECKBOX)
-    {
-        collision_box.dim = widget->checkbox.box_dimension;
-    }
-    else if(widget->header.type == TGUI_SLIDER)
-    {
-        collision_box.x += (widget->slider.value * widget->header.size.x) - (widget->slider.grip_dimension.x*0.5f); 
-        collision_box.dim = widget->slider.grip_dimension;
-    }
-    else if(widget->header.type == TGUI_CONTAINER)
-    {
-        collision_box.dim = widget->container.dimension;
-    }
-    else if(widget->header.type == TGUI_BUTTON)
-    {
-        collision_box.dim = widget->header.size;
-    }
-    else
+    collision_box.pos = abs_pos;
+    collision_box.dim = container->dimension;
+    return collision_box;
+}
+
+static TGuiRect tgui_end_container_collision_box(TGuiWidgetEndContainer *end_container, TGuiV2 abs_pos)
+{
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.dim = end_container->header.size;
+    return collision_box;
+}
+
+static TGuiRect tgui_button_collision_box(TGuiWidgetButton *button, TGuiV2 abs_pos)
+{
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.dim = button->header.size;
+    return collision_box;
+}
+
+static TGuiRect tgui_checkbox_collision_box(TGuiWidgetCheckBox *checkbox, TGuiV2 abs_pos)
+{
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.dim = checkbox->box_dimension;
+    return collision_box;
+}
+
+static TGuiRect tgui_slider_collision_box(TGuiWidgetSlider *slider, TGuiV2 abs_pos)
+{
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.x += (slider->value * slider->header.size.x) - (slider->grip_dimension.x*0.5f); 
+    collision_box.dim = slider->grip_dimension;
+    return collision_box;
+}
+
+static TGuiRect tgui_textbox_collision_box(TGuiWidgetTextBox *textbox, TGuiV2 abs_pos)
+{
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.dim = textbox->header.size;
+    return collision_box;
+}
+
+static TGuiRect tgui_textview_collision_box(TGuiWidgetTextView *textview, TGuiV2 abs_pos)
+{
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.dim = textview->header.size;
+    return collision_box;
+}
+
+static TGuiRect tgui_plot_collision_box(TGuiWidgetPlot *plot, TGuiV2 abs_pos)
+{
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.dim = plot->header.size;
+    return collision_box;
+}
+
+static TGuiRect tgui_grid_collision_box(TGuiWidgetGrid *grid, TGuiV2 abs_pos)
+{
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.dim = grid->header.size;
+    return collision_box;
+}
+
+static TGuiRect tgui_tree_collision_box(TGuiWidgetTree *tree, TGuiV2 abs_pos)
+{
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.dim = tree->header.size;
+    return collision_box;
+}
+
+static TGuiRect tgui_widget_get_collision_box(TGuiWidget *widget)
+{
+    TGuiV2 abs_pos = tgui_widget_abs_pos(widget->header.handle);
+    switch(widget->header.type)
     {
-        collision_box.dim = widget->header.size;
+#define TGUI_WIDGET_COLLISION_BOX(type, name, type_struct) case type: return tgui_##name##_collision_box((type_struct *)widget, abs_pos);
+        TGUI_WIDGET_TYPES(TGUI_WIDGET_COLLISION_BOX)
+#undef TGUI_WIDGET_COLLISION_BOX
+        default: break;
     }
+    TGuiWidgetClass *widget_class = tgui_widget_class(widget->header.type);
+    if(widget_class->collision_box) return widget_class->collision_box(widget, abs_pos);
+    TGuiRect collision_box = {0};
+    collision_box.pos = abs_pos;
+    collision_box.dim = widget->header.size;
     return collision_box;
 }
 
@@ -591,14 +924,9 @@ static b32 tgui_widget_is_active(TGuiHandle handle)
     return true;
 }
 
-static b32 tgui_mouse_is_in_parent(TGuiHandle handle)
+// NOTE: the part of the container that is visible, clipped by all its parents
+static TGuiRect tgui_container_visible_rect(TGuiWidget *parent)
 {
-    TGuiState *state = &tgui_global_state;
-    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
-    TGuiWidget *widget = tgui_widget_get(handle);
-    if(!widget->header.parent) return true;
-    
-    TGuiWidget *parent = tgui_widget_get(widget->header.parent);
     ASSERT(parent->header.type == TGUI_CONTAINER);
     TGuiRect parent_rect = {0};
     parent_rect.pos = tgui_widget_abs_pos(parent->header.handle);
@@ -626,12 +954,59 @@ static b32 tgui_mouse_is_in_parent(TGuiHandle handle)
     parent_rect.y = clip_result.min_y;
     parent_rect.width =  (clip_result.max_x - clip_result.min_x);
     parent_rect.height = (clip_result.max_y - clip_result.min_y);
+    return parent_rect;
+}
+
+static b32 tgui_mouse_is_in_parent(TGuiHandle handle)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
+    TGuiWidget *widget = tgui_widget_get(handle);
+    if(!widget->header.parent) return true;
+    
+    TGuiRect parent_rect = tgui_container_visible_rect(tgui_widget_get(widget->header.parent));
+    return tgui_mouse_hit_test(mouse, parent_rect);
+}
 
+inline static b32 tgui_bit_get(u32 *bits, u32 index)
+{
+    return (bits[index >> 5] >> (index & 31)) & 1;
+}
 
-    return tgui_point_inside_rect(mouse, parent_rect);
+inline static void tgui_bit_set(u32 *bits, u32 index, b32 value)
+{
+    u32 mask = 1u << (index & 31);
+    if(value) bits[index >> 5] |= mask;
+    else bits[index >> 5] &= ~mask;
 }
 
-static b32 tgui_container_update(TGuiState *state, TGuiWidgetContainer *container)
+// NOTE: the index of the widget in the hit batch, the batch is only use while the layout is the same
+// that when it was build, if something move in the middle of the update the widgets after it do the hit test
+static u32 tgui_hit_batch_index(TGuiState *state, TGuiHandle handle)
+{
+    TGuiHitBatch *batch = &state->hit_batch;
+    if(!batch->enabled || !batch->valid || handle >= batch->index_count) return TGUI_HIT_BATCH_NONE;
+    if(batch->layout_version != __atomic_load_n(&state->layout_version, __ATOMIC_RELAXED)) return TGUI_HIT_BATCH_NONE;
+    return batch->indices[handle];
+}
+
+// NOTE: same hot test for the buttons and the checkboxes, from the hit batch if the widget is in it
+static b32 tgui_widget_is_hot(TGuiState *state, TGuiWidget *widget, u32 batch_index)
+{
+    if(batch_index != TGUI_HIT_BATCH_NONE) return tgui_bit_get(state->hit_batch.hot, batch_index);
+    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
+    TGuiRect widget_box = tgui_widget_get_collision_box(widget);  
+    return tgui_mouse_hit_test(mouse, widget_box) && tgui_mouse_is_in_parent(widget->header.handle);
+}
+
+static void tgui_hit_batch_store(TGuiState *state, u32 batch_index, b32 active, b32 pressed)
+{
+    if(batch_index == TGUI_HIT_BATCH_NONE) return;
+    tgui_bit_set(state->hit_batch.active, batch_index, active);
+    tgui_bit_set(state->hit_batch.pressed, batch_index, pressed);
+}
+
+static b32 tgui_container_update_hot(TGuiState *state, TGuiWidgetContainer *container)
 {
     TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
     TGuiV2 widget_abs_pos = tgui_widget_abs_pos(container->header.handle);
@@ -639,7 +1014,7 @@ static b32 tgui_container_update(TGuiState *state, TGuiWidgetContainer *containe
     TGuiRect container_box = {0};
     container_box.pos = widget_abs_pos;
     container_box.dim = container->header.size;
-    if(tgui_point_inside_rect(mouse, container_box))
+    if(tgui_mouse_hit_test(mouse, container_box))
     {
         container->hot = true;
     }
@@ -668,6 +1043,8 @@ static void tgui_container_update_scroll(TGuiState *state, TGuiWidgetContainer *
     // TODO: use tgui_widget_get_collision_box here
     TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
     TGuiV2 widget_abs_pos = tgui_widget_abs_pos(container->header.handle);
+    f32 vertical_value = container->vertical_value;
+    f32 horizontal_value = container->horizontal_value;
     
     if(container->flags & TGUI_CONTAINER_V_SCROLL)
     {
@@ -684,7 +1061,7 @@ static void tgui_container_update_scroll(TGuiState *state, TGuiWidgetContainer *
             grip_pos.y = container->vertical_value * (container->dimension.y - grip.dim.y);
             grip.pos = tgui_v2_add(widget_abs_pos, grip_pos);
             
-            if(tgui_point_inside_rect(mouse, grip) && state->mouse_down)
+            if(tgui_mouse_hit_test(mouse, grip) && state->mouse_down)
             {
                 container->grabbing_y = true; 
                 state->widget_active = container->header.handle;
@@ -727,7 +1104,7 @@ static void tgui_container_update_scroll(TGuiState *state, TGuiWidgetContainer *
             grip_pos.x = container->horizontal_value * (container->dimension.x - grip.dim.x);
             grip.pos = tgui_v2_add(widget_abs_pos, grip_pos);
             
-            if(tgui_point_inside_rect(mouse, grip) && state->mouse_down)
+            if(tgui_mouse_hit_test(mouse, grip) && state->mouse_down)
             {
                 container->grabbing_x = true; 
                 state->widget_active = container->header.handle;
@@ -753,7 +1130,10 @@ static void tgui_container_update_scroll(TGuiState *state, TGuiWidgetContainer *
         }
     }
     // TODO: only recalculate child positions
-    tgui_container_recalculate_widget_position(container);
+    if(!state->jobs.layout_done || container->vertical_value != vertical_value || container->horizontal_value != horizontal_value)
+    {
+        tgui_container_recalculate_widget_position(container);
+    }
 }
 
 static void tgui_container_update_dragg_position(TGuiState *state, TGuiWidgetContainer *container)
@@ -768,7 +1148,7 @@ static void tgui_container_update_dragg_position(TGuiState *state, TGuiWidgetCon
         TGuiRect container_box = {0};
         container_box.pos = widget_abs_pos;
         container_box.dim = container->dimension;
-        if(tgui_point_inside_rect(mouse, container_box) && state->mouse_down)
+        if(tgui_mouse_hit_test(mouse, container_box) && state->mouse_down)
         {
             container->dragging = true; 
             state->widget_active = container->header.handle;
@@ -784,16 +1164,31 @@ static void tgui_container_update_dragg_position(TGuiState *state, TGuiWidgetCon
             TGuiV2 last_mouse_rel = tgui_v2_sub(last_mouse, widget_abs_pos);
             TGuiV2 mouse_offset = tgui_v2_sub(mouse_rel, last_mouse_rel);
             container->header.position = tgui_v2_add(container->header.position, mouse_offset);
+            if(mouse_offset.x != 0 || mouse_offset.y != 0) tgui_layout_changed();
         }
     }
 }
 
+static b32 tgui_container_update(TGuiState *state, TGuiWidgetContainer *container)
+{
+    // TODO: IMPORTANT: with orverlapping scrollbars get pick the one inside container need to consiget the scrollbar in the dimensionbox
+    b32 result = tgui_container_update_hot(state, container);
+    tgui_container_update_scroll(state, container);
+    tgui_container_update_dragg_position(state, container);
+    return result;
+}
+
+static b32 tgui_end_container_update(TGuiState *state, TGuiWidgetEndContainer *end_container)
+{
+    UNUSED_VAR(state);
+    UNUSED_VAR(end_container);
+    return false;
+}
+
 static b32 tgui_button_update(TGuiState *state, TGuiWidgetButton *button)
 {
-    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
-    
-    TGuiRect button_box = tgui_widget_get_collision_box((TGuiWidget *)button);  
-    if(tgui_point_inside_rect(mouse, button_box) && tgui_mouse_is_in_parent(button->header.handle))
+    u32 batch_index = tgui_hit_batch_index(state, button->header.handle);
+    if(tgui_widget_is_hot(state, (TGuiWidget *)button, batch_index))
     {
         button->hot = true;
     }
@@ -819,12 +1214,14 @@ static b32 tgui_button_update(TGuiState *state, TGuiWidgetButton *button)
         button->pressed = true;
         button->active = false;
         state->widget_active = TGUI_INVALID_HANDLE;
+        tgui_hit_batch_store(state, batch_index, false, true);
         return true;
     }
     else
     {
         button->pressed = false;
     }
+    tgui_hit_batch_store(state, batch_index, button->active, false);
 
     if(button->active || button->hot)
     {
@@ -835,10 +1232,8 @@ static b32 tgui_button_update(TGuiState *state, TGuiWidgetButton *button)
 
 static b32 tgui_checkbox_update(TGuiState *state, TGuiWidgetCheckBox *checkbox)
 {
-    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
-    
-    TGuiRect checkbox_box = tgui_widget_get_collision_box((TGuiWidget *)checkbox);  
-    if(tgui_point_inside_rect(mouse, checkbox_box) && tgui_mouse_is_in_parent(checkbox->header.handle))
+    u32 batch_index = tgui_hit_batch_index(state, checkbox->header.handle);
+    if(tgui_widget_is_hot(state, (TGuiWidget *)checkbox, batch_index))
     {
         checkbox->hot = true;
     }
@@ -864,8 +1259,10 @@ static b32 tgui_checkbox_update(TGuiState *state, TGuiWidgetCheckBox *checkbox)
         checkbox->checked = !checkbox->checked;
         checkbox->active = false;
         state->widget_active = TGUI_INVALID_HANDLE;
+        tgui_hit_batch_store(state, batch_index, false, true);
         return true;
     }
+    tgui_hit_batch_store(state, batch_index, checkbox->active, false);
 
     if(checkbox->active || checkbox->hot)
     {
@@ -879,7 +1276,7 @@ static b32 tgui_slider_update(TGuiState *state, TGuiWidgetSlider *slider)
     TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
     TGuiRect slider_box = tgui_widget_get_collision_box((TGuiWidget *)slider);  
     
-    if(tgui_point_inside_rect(mouse, slider_box) && tgui_mouse_is_in_parent(slider->header.handle))
+    if(tgui_mouse_hit_test(mouse, slider_box) && tgui_mouse_is_in_parent(slider->header.handle))
     {
         slider->hot = true;
     }
@@ -917,933 +1314,5891 @@ static b32 tgui_slider_update(TGuiState *state, TGuiWidgetSlider *slider)
     return false;
 }
 
-inline static TGuiCharacterAllocator *tgui_textbox_get_cursor_prev_line(TGuiWidgetTextBox *textbox)
+inline static u32 tgui_textbox_get_cursor_offset(TGuiWidgetTextBox *textbox)
 {
-    i32 prev_line_pos = textbox->cursor_position.y - 1;
-    TGuiCharacterAllocator *line = 0;
-    if(prev_line_pos >= 0)
-    {
-        line = textbox->allocator.buffer + prev_line_pos;
-    }
-    return line;
+    u32 result = tgui_text_buffer_line_start(&textbox->text, textbox->cursor_position.y) + textbox->cursor_position.x;
+    return result;
 }
 
-inline static TGuiCharacterAllocator *tgui_textbox_get_cursor_line(TGuiWidgetTextBox *textbox)
+inline static TGuiV2i tgui_textbox_get_visible_size(TGuiState *state, TGuiWidgetTextBox *textbox)
 {
-    // TODO: check for buffer overflow and underflow
-    TGuiCharacterAllocator *line = textbox->allocator.buffer + textbox->cursor_position.y;
-    return line;
+    // NOTE: number of columns (x) and lines (y) that fit in the view port, count the partial ones
+    TGuiV2i result;
+    result.x = ((i32)textbox->dimension.x + state->font_width - 1) / state->font_width;
+    result.y = ((i32)textbox->dimension.y + state->font_height - 1) / state->font_height;
+    return result;
 }
 
-inline static TGuiCharacterAllocator *tgui_textbox_get_cursor_next_line(TGuiWidgetTextBox *textbox)
+static void tgui_textbox_scroll_to_cursor(TGuiState *state, TGuiWidgetTextBox *textbox)
 {
-    i32 next_line_pos = textbox->cursor_position.y + 1;
-    TGuiCharacterAllocator *line = 0;
-    if((u32)next_line_pos < textbox->allocator.count)
+    // NOTE: only full visible columns and lines count here, the cursor should never be cut
+    i32 columns = (i32)textbox->dimension.x / (i32)state->font_width;
+    i32 lines = (i32)textbox->dimension.y / (i32)state->font_height;
+    if(columns < 1) columns = 1;
+    if(lines < 1) lines = 1;
+    
+    if(textbox->cursor_position.x < textbox->scroll.x)
+    {
+        textbox->scroll.x = textbox->cursor_position.x;
+    }
+    else if(textbox->cursor_position.x >= textbox->scroll.x + columns)
+    {
+        textbox->scroll.x = textbox->cursor_position.x - columns + 1;
+    }
+    if(textbox->cursor_position.y < textbox->scroll.y)
+    {
+        textbox->scroll.y = textbox->cursor_position.y;
+    }
+    else if(textbox->cursor_position.y >= textbox->scroll.y + lines)
     {
-        line = textbox->allocator.buffer + next_line_pos;
+        textbox->scroll.y = textbox->cursor_position.y - lines + 1;
     }
-    return line;
 }
 
 static void tgui_textbox_move_cursor_left(TGuiWidgetTextBox *textbox)
 {
-    i32 new_position_x = textbox->cursor_position.x - 1;
-    if(new_position_x < 0)
+    if(textbox->cursor_position.x > 0)
     {
-        TGuiCharacterAllocator *prev_line = tgui_textbox_get_cursor_prev_line(textbox);
-        if(prev_line)
-        {
-            textbox->cursor_position.x = prev_line->count + (new_position_x + 1);
-            --textbox->cursor_position.y;
-        }
+        --textbox->cursor_position.x;
     }
-    else
+    else if(textbox->cursor_position.y > 0)
     {
-        textbox->cursor_position.x = new_position_x;
+        --textbox->cursor_position.y;
+        textbox->cursor_position.x = tgui_text_buffer_line_size(&textbox->text, textbox->cursor_position.y);
     }
 }
 
 static void tgui_textbox_move_cursor_right(TGuiWidgetTextBox *textbox)
 {
-    TGuiCharacterAllocator *line = tgui_textbox_get_cursor_line(textbox);
-    i32 new_position_x = textbox->cursor_position.x + 1;
-    if((u32)new_position_x > line->count) 
+    u32 line_size = tgui_text_buffer_line_size(&textbox->text, textbox->cursor_position.y);
+    if((u32)textbox->cursor_position.x < line_size)
     {
-        TGuiCharacterAllocator *next_line = tgui_textbox_get_cursor_next_line(textbox);
-        if(next_line)
-        {
-            textbox->cursor_position.x = (new_position_x - 1) - (i32)line->count;
-            ++textbox->cursor_position.y;
-        }
+        ++textbox->cursor_position.x;
     }
-    else
+    else if((u32)textbox->cursor_position.y + 1 < tgui_text_buffer_line_count(&textbox->text))
     {
-        textbox->cursor_position.x = new_position_x;
+        ++textbox->cursor_position.y;
+        textbox->cursor_position.x = 0;
     }
 }
 
 static void tgui_textbox_move_cursor_up(TGuiWidgetTextBox *textbox)
 {
-    TGuiCharacterAllocator *prev_line = tgui_textbox_get_cursor_prev_line(textbox);
-    if(prev_line)
+    if(textbox->cursor_position.y > 0)
     {
-        if((u32)textbox->cursor_position.x > prev_line->count)
+        --textbox->cursor_position.y;
+        u32 line_size = tgui_text_buffer_line_size(&textbox->text, textbox->cursor_position.y);
+        if((u32)textbox->cursor_position.x > line_size)
         {
-            textbox->cursor_position.x = prev_line->count;
+            textbox->cursor_position.x = line_size;
         }
-        --textbox->cursor_position.y;
     }
 }
 
 static void tgui_textbox_move_cursor_down(TGuiWidgetTextBox *textbox)
 {
-    TGuiCharacterAllocator *next_line = tgui_textbox_get_cursor_next_line(textbox);
-    if(next_line)
+    if((u32)textbox->cursor_position.y + 1 < tgui_text_buffer_line_count(&textbox->text))
     {
-        if((u32)textbox->cursor_position.x > next_line->count)
+        ++textbox->cursor_position.y;
+        u32 line_size = tgui_text_buffer_line_size(&textbox->text, textbox->cursor_position.y);
+        if((u32)textbox->cursor_position.x > line_size)
+        {
+            textbox->cursor_position.x = line_size;
+        }
+    }
+}
+
+inline static TGuiWidgetTextBox *tgui_textbox_get(TGuiHandle textbox_handle)
+{
+    TGuiWidget *widget = tgui_widget_get(textbox_handle);
+    ASSERT(widget->header.type == TGUI_TEXTBOX);
+    return &widget->textbox;
+}
+
+static void tgui_textbox_set_cursor_offset(TGuiWidgetTextBox *textbox, u32 offset)
+{
+    u32 line = tgui_text_buffer_find_line(&textbox->text, offset);
+    textbox->cursor_position.y = line;
+    textbox->cursor_position.x = offset - tgui_text_buffer_line_start(&textbox->text, line);
+    tgui_textbox_scroll_to_cursor(&tgui_global_state, textbox);
+}
+
+void tgui_textbox_replace_range(TGuiHandle textbox_handle, u32 start, u32 end, char *text, u32 text_size)
+{
+    TGuiWidgetTextBox *textbox = tgui_textbox_get(textbox_handle);
+    u32 cursor_offset = tgui_textbox_get_cursor_offset(textbox);
+    tgui_text_buffer_delete(&textbox->text, start, end);
+    tgui_text_buffer_insert(&textbox->text, start, (u8 *)text, text_size);
+    
+    // NOTE: the cursor keep its place in the text, if it was inside the range it go to the end of the new text
+    if(cursor_offset >= end)
+    {
+        cursor_offset = cursor_offset - (end - start) + text_size;
+    }
+    else if(cursor_offset > start)
+    {
+        cursor_offset = start + text_size;
+    }
+    tgui_textbox_set_cursor_offset(textbox, cursor_offset);
+}
+
+void tgui_textbox_insert(TGuiHandle textbox_handle, u32 offset, char *text, u32 text_size)
+{
+    tgui_textbox_replace_range(textbox_handle, offset, offset, text, text_size);
+}
+
+void tgui_textbox_append(TGuiHandle textbox_handle, char *text, u32 text_size)
+{
+    u32 offset = tgui_textbox_get_size(textbox_handle);
+    tgui_textbox_replace_range(textbox_handle, offset, offset, text, text_size);
+}
+
+void tgui_textbox_set_text(TGuiHandle textbox_handle, char *text, u32 text_size)
+{
+    TGuiWidgetTextBox *textbox = tgui_textbox_get(textbox_handle);
+    tgui_text_buffer_clear(&textbox->text);
+    tgui_text_buffer_insert(&textbox->text, 0, (u8 *)text, text_size);
+    textbox->scroll = tgui_v2i(0, 0);
+    tgui_textbox_set_cursor_offset(textbox, 0);
+}
+
+u32 tgui_textbox_get_size(TGuiHandle textbox_handle)
+{
+    TGuiWidgetTextBox *textbox = tgui_textbox_get(textbox_handle);
+    return tgui_text_buffer_size(&textbox->text);
+}
+
+static void tgui_textview_index_add_checkpoint(TGuiTextViewIndex *index, u64 checkpoint, u64 offset)
+{
+    u64 page = checkpoint / TGUI_TEXTVIEW_INDEX_PAGE_SIZE;
+    if(page >= TGUI_TEXTVIEW_INDEX_MAX_PAGES) return;
+    if(!index->pages[page])
+    {
+        index->pages[page] = (u64 *)malloc(TGUI_TEXTVIEW_INDEX_PAGE_SIZE*sizeof(u64));
+    }
+    index->pages[page][checkpoint % TGUI_TEXTVIEW_INDEX_PAGE_SIZE] = offset;
+}
+
+static u64 tgui_textview_index_chunk(TGuiTextViewIndex *index, u64 start, u64 end, u64 line_count)
+{
+    // NOTE: every new line start a line, save a checkpoint every TGUI_TEXTVIEW_INDEX_STRIDE lines
+    u8 *data = index->data;
+    u64 offset = start;
+#if TGUI_SSE2
+    __m128i newline = _mm_set1_epi8('\n');
+    for(; offset + 16 <= end; offset += 16)
+    {
+        __m128i characters = _mm_loadu_si128((__m128i *)(data + offset));
+        u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(characters, newline));
+        while(mask)
+        {
+            u32 bit = (u32)__builtin_ctz(mask);
+            mask &= mask - 1;
+            ++line_count;
+            if((line_count % TGUI_TEXTVIEW_INDEX_STRIDE) == 0)
+            {
+                tgui_textview_index_add_checkpoint(index, line_count / TGUI_TEXTVIEW_INDEX_STRIDE, offset + bit + 1);
+            }
+        }
+    }
+#endif
+    for(; offset < end; ++offset)
+    {
+        if(data[offset] == '\n')
+        {
+            ++line_count;
+            if((line_count % TGUI_TEXTVIEW_INDEX_STRIDE) == 0)
+            {
+                tgui_textview_index_add_checkpoint(index, line_count / TGUI_TEXTVIEW_INDEX_STRIDE, offset + 1);
+            }
+        }
+    }
+    return line_count;
+}
+
+static void tgui_textview_index_thread(void *data)
+{
+    TGuiTextViewIndex *index = (TGuiTextViewIndex *)data;
+    // NOTE: line_count count the new lines, the checkpoint of line 0 is added when the widget is created
+    u64 line_count = 0;
+    for(u64 start = 0; start < index->size; start += TGUI_TEXTVIEW_INDEX_CHUNK_SIZE)
+    {
+        if(TGUI_ATOMIC_LOAD(&index->stop)) break;
+        u64 end = start + TGUI_TEXTVIEW_INDEX_CHUNK_SIZE;
+        if(end > index->size) end = index->size;
+        line_count = tgui_textview_index_chunk(index, start, end, line_count);
+        // NOTE: the scanned pages are not needed any more, keep the resident memory bounded
+        tgui_platform_release_pages(index->data + start, end - start);
+        // NOTE: the checkpoints after the last page are not store, the lines after it are find with memchr
+        u64 checkpoint_count = line_count / TGUI_TEXTVIEW_INDEX_STRIDE + 1;
+        if(checkpoint_count > TGUI_TEXTVIEW_INDEX_MAX_CHECKPOINTS) checkpoint_count = TGUI_TEXTVIEW_INDEX_MAX_CHECKPOINTS;
+        TGUI_ATOMIC_STORE(&index->checkpoint_count, checkpoint_count);
+        TGUI_ATOMIC_STORE(&index->line_count, line_count + 1);
+    }
+    TGUI_ATOMIC_STORE(&index->done, true);
+}
+
+static u64 tgui_textview_get_line_offset(TGuiTextViewIndex *index, u64 line)
+{
+    // NOTE: start from the nearest checkpoint and find the rest of the lines
+    u64 checkpoint = line / TGUI_TEXTVIEW_INDEX_STRIDE;
+    u64 checkpoint_count = TGUI_ATOMIC_LOAD(&index->checkpoint_count);
+    if(checkpoint >= checkpoint_count) checkpoint = checkpoint_count - 1;
+    u64 offset = index->pages[checkpoint / TGUI_TEXTVIEW_INDEX_PAGE_SIZE][checkpoint % TGUI_TEXTVIEW_INDEX_PAGE_SIZE];
+    for(u64 line_index = checkpoint * TGUI_TEXTVIEW_INDEX_STRIDE; line_index < line; ++line_index)
+    {
+        u8 *newline = (u8 *)memchr(index->data + offset, '\n', index->size - offset);
+        if(!newline) return index->size;
+        offset = (u64)(newline - index->data) + 1;
+    }
+    return offset;
+}
+
+static void tgui_textview_destroy(TGuiWidgetTextView *textview)
+{
+    if(textview->index_thread)
+    {
+        TGUI_ATOMIC_STORE(&textview->index->stop, true);
+        tgui_platform_thread_join(textview->index_thread);
+        textview->index_thread = 0;
+    }
+    for(u32 page = 0; page < TGUI_TEXTVIEW_INDEX_MAX_PAGES; ++page)
+    {
+        free(textview->index->pages[page]);
+    }
+    free(textview->index);
+    textview->index = 0;
+    if(textview->file.data)
+    {
+        tgui_platform_unmap_file(&textview->file);
+    }
+    free(textview->path);
+    textview->path = 0;
+}
+
+inline static TGuiWidgetTextView *tgui_textview_get(TGuiHandle textview_handle)
+{
+    TGuiWidget *widget = tgui_widget_get(textview_handle);
+    ASSERT(widget->header.type == TGUI_TEXTVIEW);
+    return &widget->textview;
+}
+
+u64 tgui_textview_get_line_count(TGuiHandle textview_handle)
+{
+    TGuiWidgetTextView *textview = tgui_textview_get(textview_handle);
+    return TGUI_ATOMIC_LOAD(&textview->index->line_count);
+}
+
+b32 tgui_textview_is_indexed(TGuiHandle textview_handle)
+{
+    TGuiWidgetTextView *textview = tgui_textview_get(textview_handle);
+    return TGUI_ATOMIC_LOAD(&textview->index->done);
+}
+
+static void tgui_textview_scroll(TGuiWidgetTextView *textview, i64 lines, i32 columns)
+{
+    // NOTE: the lines that are not index yet cannot be reach
+    u64 line_count = TGUI_ATOMIC_LOAD(&textview->index->line_count);
+    i64 scroll_line = (i64)textview->scroll_line + lines;
+    if(scroll_line >= (i64)line_count) scroll_line = (i64)line_count - 1;
+    if(scroll_line < 0) scroll_line = 0;
+    textview->scroll_line = (u64)scroll_line;
+    
+    i32 scroll_column = (i32)textview->scroll_column + columns;
+    if(scroll_column < 0) scroll_column = 0;
+    textview->scroll_column = (u32)scroll_column;
+}
+
+void tgui_textview_scroll_to_line(TGuiHandle textview_handle, u64 line)
+{
+    TGuiWidgetTextView *textview = tgui_textview_get(textview_handle);
+    textview->scroll_line = 0;
+    tgui_textview_scroll(textview, (i64)line, 0);
+}
+
+inline static TGuiWidgetPlot *tgui_plot_get(TGuiHandle plot_handle)
+{
+    TGuiWidget *widget = tgui_widget_get(plot_handle);
+    ASSERT(widget->header.type == TGUI_PLOT);
+    return &widget->plot;
+}
+
+// NOTE: the columns of the cache are from the samples of the last bind, a new bind start again
+static void tgui_plot_cache_clear(TGuiPlotCache *cache)
+{
+    if(!cache) return;
+    for(u32 level_index = 0; level_index < TGUI_PLOT_CACHE_LEVELS; ++level_index)
+    {
+        TGuiPlotLevel *level = cache->levels + level_index;
+        level->samples_per_column = 0;
+        level->first_column = 0;
+        level->end_column = 0;
+    }
+}
+
+static void tgui_plot_destroy(TGuiWidgetPlot *plot)
+{
+    TGuiPlotCache *cache = plot->cache;
+    if(!cache) return;
+    for(u32 level_index = 0; level_index < TGUI_PLOT_CACHE_LEVELS; ++level_index)
+    {
+        free(cache->levels[level_index].columns);
+    }
+    free(cache->spans);
+    free(cache);
+    plot->cache = 0;
+}
+
+void tgui_plot_bind(TGuiHandle plot_handle, f32 *samples, u64 capacity, u64 sample_count)
+{
+    TGuiWidgetPlot *plot = tgui_plot_get(plot_handle);
+    plot->samples = samples;
+    plot->capacity = capacity;
+    plot->sample_count = sample_count;
+    tgui_plot_cache_clear(plot->cache);
+}
+
+void tgui_plot_append(TGuiHandle plot_handle, u64 count)
+{
+    TGuiWidgetPlot *plot = tgui_plot_get(plot_handle);
+    plot->sample_count += count;
+}
+
+void tgui_plot_set_view(TGuiHandle plot_handle, u64 view_count)
+{
+    TGuiWidgetPlot *plot = tgui_plot_get(plot_handle);
+    plot->view_count = view_count;
+}
+
+void tgui_plot_set_range(TGuiHandle plot_handle, f32 min_value, f32 max_value)
+{
+    TGuiWidgetPlot *plot = tgui_plot_get(plot_handle);
+    plot->min_value = min_value;
+    plot->max_value = max_value;
+}
+
+// NOTE: min and max of the samples, 8 at the time with SSE2
+static void tgui_plot_min_max(f32 *samples, u64 count, f32 *min_value, f32 *max_value)
+{
+    f32 min = *min_value;
+    f32 max = *max_value;
+    u64 index = 0;
+#if TGUI_SSE2
+    if(count >= 8)
+    {
+        __m128 min_a = _mm_loadu_ps(samples);
+        __m128 min_b = _mm_loadu_ps(samples + 4);
+        __m128 max_a = min_a;
+        __m128 max_b = min_b;
+        for(index = 8; index + 8 <= count; index += 8)
+        {
+            __m128 a = _mm_loadu_ps(samples + index);
+            __m128 b = _mm_loadu_ps(samples + index + 4);
+            min_a = _mm_min_ps(min_a, a);
+            min_b = _mm_min_ps(min_b, b);
+            max_a = _mm_max_ps(max_a, a);
+            max_b = _mm_max_ps(max_b, b);
+        }
+        __m128 min_4 = _mm_min_ps(min_a, min_b);
+        __m128 max_4 = _mm_max_ps(max_a, max_b);
+        min_4 = _mm_min_ps(min_4, _mm_shuffle_ps(min_4, min_4, _MM_SHUFFLE(1, 0, 3, 2)));
+        max_4 = _mm_max_ps(max_4, _mm_shuffle_ps(max_4, max_4, _MM_SHUFFLE(1, 0, 3, 2)));
+        min_4 = _mm_min_ps(min_4, _mm_shuffle_ps(min_4, min_4, _MM_SHUFFLE(2, 3, 0, 1)));
+        max_4 = _mm_max_ps(max_4, _mm_shuffle_ps(max_4, max_4, _MM_SHUFFLE(2, 3, 0, 1)));
+        min = TGUI_MIN(min, _mm_cvtss_f32(min_4));
+        max = TGUI_MAX(max, _mm_cvtss_f32(max_4));
+    }
+#endif
+    for(; index < count; ++index)
+    {
+        min = TGUI_MIN(min, samples[index]);
+        max = TGUI_MAX(max, samples[index]);
+    }
+    *min_value = min;
+    *max_value = max;
+}
+
+// NOTE: the samples of the column that are still in the ring, return false if there are none
+static b32 tgui_plot_column(TGuiWidgetPlot *plot, u64 column, u64 samples_per_column, TGuiPlotColumn *result)
+{
+    u64 oldest = plot->sample_count > plot->capacity ? plot->sample_count - plot->capacity : 0;
+    u64 start = TGUI_MAX(column*samples_per_column, oldest);
+    u64 end = TGUI_MIN((column + 1)*samples_per_column, plot->sample_count);
+    if(start >= end) return false;
+    
+    result->min = plot->samples[start % plot->capacity];
+    result->max = result->min;
+    result->last = plot->samples[(end - 1) % plot->capacity];
+    while(start < end)
+    {
+        u64 ring_index = start % plot->capacity;
+        u64 count = TGUI_MIN(end - start, plot->capacity - ring_index);
+        tgui_plot_min_max(plot->samples + ring_index, count, &result->min, &result->max);
+        start += count;
+    }
+    return true;
+}
+
+// NOTE: the level of the zoom, if it is not in the cache the one that is not use for longer is replace.
+// Only the columns that are complete since the last frame are calculate
+static TGuiPlotLevel *tgui_plot_level(TGuiWidgetPlot *plot, u64 samples_per_column)
+{
+    TGuiPlotCache *cache = plot->cache;
+    TGuiPlotLevel *level = 0;
+    for(u32 level_index = 0; level_index < TGUI_PLOT_CACHE_LEVELS; ++level_index)
+    {
+        TGuiPlotLevel *candidate = cache->levels + level_index;
+        if(candidate->samples_per_column == samples_per_column)
+        {
+            level = candidate;
+            break;
+        }
+        if(!level || candidate->last_use < level->last_use) level = candidate;
+    }
+    if(level->samples_per_column != samples_per_column)
+    {
+        level->samples_per_column = samples_per_column;
+        level->first_column = 0;
+        level->end_column = 0;
+    }
+    level->last_use = ++cache->use_count;
+
+    u64 oldest = plot->sample_count > plot->capacity ? plot->sample_count - plot->capacity : 0;
+    u64 complete_end = plot->sample_count / samples_per_column;
+    u64 start = TGUI_MAX(level->end_column, oldest / samples_per_column);
+    if(start < complete_end && complete_end - start > cache->column_size) start = complete_end - cache->column_size;
+    if(start > level->end_column) level->first_column = start;
+    for(u64 column = start; column < complete_end; ++column)
+    {
+        tgui_plot_column(plot, column, samples_per_column, level->columns + column % cache->column_size);
+    }
+    level->end_column = TGUI_MAX(level->end_column, complete_end);
+    if(level->end_column - level->first_column > cache->column_size) level->first_column = level->end_column - cache->column_size;
+    return level;
+}
+
+inline static TGuiWidgetGrid *tgui_grid_get(TGuiHandle grid_handle)
+{
+    TGuiWidget *widget = tgui_widget_get(grid_handle);
+    ASSERT(widget->header.type == TGUI_GRID);
+    return &widget->grid;
+}
+
+static TGuiGridData *tgui_grid_data(TGuiWidgetGrid *grid)
+{
+    if(!grid->data)
+    {
+        grid->data = (TGuiGridData *)malloc(sizeof(TGuiGridData));
+        memset(grid->data, 0, sizeof(TGuiGridData));
+    }
+    return grid->data;
+}
+
+// NOTE: the cache is allocate again by the render with the size of the visible cells
+static void tgui_grid_cache_clear(TGuiGridData *data)
+{
+    free(data->cells);
+    data->cells = 0;
+    data->cell_size = 0;
+}
+
+static void tgui_grid_destroy(TGuiWidgetGrid *grid)
+{
+    TGuiGridData *data = grid->data;
+    if(!data) return;
+    free(data->columns);
+    free(data->cells);
+    free(data->run);
+    free(data);
+    grid->data = 0;
+}
+
+static void tgui_grid_scroll(TGuiWidgetGrid *grid, i64 rows, i32 columns)
+{
+    // NOTE: the last row and column can be scroll to the top left
+    u64 scroll_rows = grid->row_count > grid->fixed_rows ? grid->row_count - grid->fixed_rows : 0;
+    i64 scroll_row = (i64)grid->scroll_row + rows;
+    if(scroll_row >= (i64)scroll_rows) scroll_row = (i64)scroll_rows - 1;
+    if(scroll_row < 0) scroll_row = 0;
+    grid->scroll_row = (u64)scroll_row;
+
+    u32 column_count = grid->data ? grid->data->column_count : 0;
+    u32 scroll_columns = column_count > grid->fixed_columns ? column_count - grid->fixed_columns : 0;
+    i32 scroll_column = (i32)grid->scroll_column + columns;
+    if(scroll_column >= (i32)scroll_columns) scroll_column = (i32)scroll_columns - 1;
+    if(scroll_column < 0) scroll_column = 0;
+    grid->scroll_column = (u32)scroll_column;
+}
+
+void tgui_grid_set_columns(TGuiHandle grid_handle, TGuiGridColumn *columns, u32 column_count)
+{
+    TGuiWidgetGrid *grid = tgui_grid_get(grid_handle);
+    TGuiGridData *data = tgui_grid_data(grid);
+    free(data->columns);
+    data->columns = (TGuiGridColumn *)malloc(column_count*sizeof(TGuiGridColumn));
+    memcpy(data->columns, columns, column_count*sizeof(TGuiGridColumn));
+    data->column_count = column_count;
+    // NOTE: the cells of the old columns can have the same version than the new ones
+    tgui_grid_cache_clear(data);
+    tgui_grid_scroll(grid, 0, 0);
+}
+
+void tgui_grid_set_row_count(TGuiHandle grid_handle, u64 row_count)
+{
+    TGuiWidgetGrid *grid = tgui_grid_get(grid_handle);
+    grid->row_count = row_count;
+    tgui_grid_scroll(grid, 0, 0);
+}
+
+void tgui_grid_set_fixed(TGuiHandle grid_handle, u32 fixed_rows, u32 fixed_columns)
+{
+    TGuiWidgetGrid *grid = tgui_grid_get(grid_handle);
+    grid->fixed_rows = fixed_rows;
+    grid->fixed_columns = fixed_columns;
+    tgui_grid_scroll(grid, 0, 0);
+}
+
+void tgui_grid_set_size(TGuiHandle grid_handle, u32 width, u32 height)
+{
+    TGuiWidgetGrid *grid = tgui_grid_get(grid_handle);
+    grid->dimension = tgui_v2(width, height);
+    grid->header.size = tgui_grid_measure(grid);
+    tgui_layout_changed();
+    if(grid->header.parent)
+    {
+        TGuiWidgetContainer *container = &tgui_widget_get(grid->header.parent)->container;
+        tgui_container_recalculate_dimension(container);
+        tgui_container_recalculate_widget_position(container);
+    }
+}
+
+void tgui_grid_scroll_to(TGuiHandle grid_handle, u64 row, u32 column)
+{
+    TGuiWidgetGrid *grid = tgui_grid_get(grid_handle);
+    grid->scroll_row = 0;
+    grid->scroll_column = 0;
+    tgui_grid_scroll(grid, (i64)row, (i32)column);
+}
+
+void tgui_grid_invalidate(TGuiHandle grid_handle, u32 column)
+{
+    TGuiWidgetGrid *grid = tgui_grid_get(grid_handle);
+    if(!grid->data) return;
+    for(u32 column_index = 0; column_index < grid->data->column_count; ++column_index)
+    {
+        if(column == TGUI_GRID_ALL_COLUMNS || column == column_index) ++grid->data->columns[column_index].version;
+    }
+}
+
+// NOTE: the text of the cell from the cache, if it is not in its bucket it is format again in the cell
+// that was draw first
+static TGuiGridCell *tgui_grid_cell(TGuiGridData *data, u64 row, u32 column)
+{
+    TGuiGridColumn *grid_column = data->columns + column;
+    u64 hash = row*0x9E3779B97F4A7C15ull ^ (u64)column*0xC2B2AE3D27D4EB4Full;
+    hash ^= hash >> 32;
+    TGuiGridCell *bucket = data->cells + ((hash*TGUI_GRID_CACHE_WAYS) & (data->cell_size - 1));
+    TGuiGridCell *cell = bucket;
+    for(u32 way = 0; way < TGUI_GRID_CACHE_WAYS; ++way)
+    {
+        TGuiGridCell *entry = bucket + way;
+        if(entry->row == row && entry->column == column)
+        {
+            entry->frame = data->frame;
+            if(entry->version == grid_column->version)
+            {
+                ++data->cache_hits;
+                return entry;
+            }
+            cell = entry;
+            break;
+        }
+        if((u32)(data->frame - entry->frame) > (u32)(data->frame - cell->frame)) cell = entry;
+    }
+    ++data->cache_misses;
+    cell->frame = data->frame;
+    cell->row = row;
+    cell->column = column;
+    cell->version = grid_column->version;
+    
+    i32 size = 0;
+    switch(grid_column->type)
+    {
+        case TGUI_GRID_COLUMN_F32:
+        {
+            size = snprintf(cell->text, TGUI_GRID_CELL_TEXT_MAX, "%.3f", ((f32 *)grid_column->data)[row]);
+        } break;
+        case TGUI_GRID_COLUMN_I32:
+        {
+            size = snprintf(cell->text, TGUI_GRID_CELL_TEXT_MAX, "%d", ((i32 *)grid_column->data)[row]);
+        } break;
+        case TGUI_GRID_COLUMN_STRING:
+        {
+            char *string = ((char **)grid_column->data)[row];
+            while(string && string[size] && size < TGUI_GRID_CELL_TEXT_MAX - 1)
+            {
+                cell->text[size] = string[size];
+                ++size;
+            }
+        } break;
+        case TGUI_GRID_COLUMN_CALLBACK:
+        {
+            if(grid_column->format) size = (i32)grid_column->format(grid_column->data, row, cell->text, TGUI_GRID_CELL_TEXT_MAX);
+        } break;
+    }
+    // NOTE: snprintf return the size without truncate
+    cell->text_size = (u32)TGUI_MAX(0, TGUI_MIN(size, TGUI_GRID_CELL_TEXT_MAX - 1));
+    return cell;
+}
+
+inline static TGuiWidgetTree *tgui_tree_get(TGuiHandle tree_handle)
+{
+    TGuiWidget *widget = tgui_widget_get(tree_handle);
+    ASSERT(widget->header.type == TGUI_TREE);
+    return &widget->tree;
+}
+
+static void tgui_tree_destroy(TGuiWidgetTree *tree)
+{
+    TGuiTreeData *data = tree->data;
+    if(!data) return;
+    free(data->expanded);
+    free(data->nodes);
+    free(data->levels);
+    free(data);
+    tree->data = 0;
+}
+
+static u32 tgui_tree_push_node(TGuiTreeData *data)
+{
+    if(data->free_node != TGUI_TREE_NONE)
+    {
+        u32 entry = data->free_node;
+        data->free_node = data->nodes[entry].next_sibling;
+        return entry;
+    }
+    if(data->node_size == data->node_capacity)
+    {
+        u32 node_capacity = data->node_capacity ? data->node_capacity*2 : 16;
+        TGuiTreeNode *nodes = (TGuiTreeNode *)malloc(node_capacity*sizeof(TGuiTreeNode));
+        if(data->nodes) memcpy(nodes, data->nodes, data->node_size*sizeof(TGuiTreeNode));
+        free(data->nodes);
+        free(data->levels);
+        data->nodes = nodes;
+        data->levels = (TGuiTreeLevel *)malloc(node_capacity*sizeof(TGuiTreeLevel));
+        data->node_capacity = node_capacity;
+        TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, node_capacity*(sizeof(TGuiTreeNode) + sizeof(TGuiTreeLevel)));
+    }
+    return data->node_size++;
+}
+
+// NOTE: only the entry and its parents change, the children are not ask until they are visible
+static void tgui_tree_expand(TGuiTreeData *data, u32 parent, u32 index)
+{
+    TGuiTreeSource *source = &data->source;
+    u32 node = source->child(source->data, data->nodes[parent].node, index);
+    if(node >= data->node_count) return;
+    u32 child_count = source->child_count(source->data, node);
+    if(!child_count) return;
+
+    u32 entry = tgui_tree_push_node(data);
+    TGuiTreeNode *tree_node = data->nodes + entry;
+    tree_node->node = node;
+    tree_node->parent = parent;
+    tree_node->index = index;
+    tree_node->child_count = child_count;
+    tree_node->visible = child_count;
+    tree_node->first_child = TGUI_TREE_NONE;
+    
+    // NOTE: the expanded children of a node are a list sort by index
+    u32 *link = &data->nodes[parent].first_child;
+    while(*link != TGUI_TREE_NONE && data->nodes[*link].index < index) link = &data->nodes[*link].next_sibling;
+    tree_node->next_sibling = *link;
+    *link = entry;
+    
+    tgui_bit_set(data->expanded, node, true);
+    for(u32 ancestor = parent; ancestor != TGUI_TREE_NONE; ancestor = data->nodes[ancestor].parent)
+    {
+        data->nodes[ancestor].visible += child_count;
+    }
+}
+
+static void tgui_tree_remove(TGuiTreeData *data, u32 entry)
+{
+    u32 child = data->nodes[entry].first_child;
+    while(child != TGUI_TREE_NONE)
+    {
+        u32 next_child = data->nodes[child].next_sibling;
+        tgui_tree_remove(data, child);
+        child = next_child;
+    }
+    tgui_bit_set(data->expanded, data->nodes[entry].node, false);
+    data->nodes[entry].next_sibling = data->free_node;
+    data->free_node = entry;
+}
+
+// NOTE: the expanded children are forget too, collapse a node always show it closed again
+static void tgui_tree_collapse(TGuiTreeData *data, u32 entry)
+{
+    TGuiTreeNode *tree_node = data->nodes + entry;
+    for(u32 ancestor = tree_node->parent; ancestor != TGUI_TREE_NONE; ancestor = data->nodes[ancestor].parent)
+    {
+        data->nodes[ancestor].visible -= tree_node->visible;
+    }
+    u32 *link = &data->nodes[tree_node->parent].first_child;
+    while(*link != entry) link = &data->nodes[*link].next_sibling;
+    *link = tree_node->next_sibling;
+    tgui_tree_remove(data, entry);
+}
+
+// NOTE: write in the levels of data the path to the row and return the depth. Every level skip its rows
+// with the expanded children, it dont depend on the number of children
+static u32 tgui_tree_find_row(TGuiTreeData *data, u32 row)
+{
+    u32 depth = 0;
+    u32 entry = 0;
+    for(;;)
+    {
+        TGuiTreeLevel *level = data->levels + depth++;
+        level->entry = entry;
+        level->child = data->nodes[entry].first_child;
+        level->index = TGUI_TREE_NONE;
+        u32 rows_before = 0;
+        while(level->child != TGUI_TREE_NONE)
+        {
+            TGuiTreeNode *tree_node = data->nodes + level->child;
+            u32 child_row = tree_node->index + rows_before;
+            if(row < child_row) break;
+            if(row <= child_row + tree_node->visible)
+            {
+                level->index = tree_node->index;
+                row -= child_row;
+                break;
+            }
+            rows_before += tree_node->visible;
+            level->child = tree_node->next_sibling;
+        }
+        // NOTE: the row is a node of this level or is inside the subtree of the child
+        if(level->index == TGUI_TREE_NONE)
+        {
+            level->index = row - rows_before;
+            return depth;
+        }
+        if(row == 0) return depth;
+        row -= 1;
+        entry = level->child;
+    }
+}
+
+inline static u32 tgui_tree_level_node(TGuiTreeData *data, TGuiTreeLevel *level)
+{
+    TGuiTreeSource *source = &data->source;
+    return source->child(source->data, data->nodes[level->entry].node, level->index);
+}
+
+// NOTE: the entry of the node in the level if it is expanded
+inline static u32 tgui_tree_level_entry(TGuiTreeData *data, TGuiTreeLevel *level)
+{
+    if(level->child != TGUI_TREE_NONE && data->nodes[level->child].index == level->index) return level->child;
+    return TGUI_TREE_NONE;
+}
+
+// NOTE: move the levels to the next row, return false at the end of the tree
+static b32 tgui_tree_next_row(TGuiTreeData *data, u32 *depth)
+{
+    TGuiTreeLevel *level = data->levels + *depth - 1;
+    u32 entry = tgui_tree_level_entry(data, level);
+    if(entry != TGUI_TREE_NONE)
+    {
+        TGuiTreeLevel *child_level = data->levels + (*depth)++;
+        child_level->entry = entry;
+        child_level->index = 0;
+        child_level->child = data->nodes[entry].first_child;
+        return true;
+    }
+    ++level->index;
+    while(level->index >= data->nodes[level->entry].child_count)
+    {
+        if(*depth == 1) return false;
+        --(*depth);
+        level = data->levels + *depth - 1;
+        ++level->index;
+        level->child = data->nodes[level->child].next_sibling;
+    }
+    return true;
+}
+
+static void tgui_tree_scroll(TGuiWidgetTree *tree, i64 rows)
+{
+    i64 row_count = tree->data ? (i64)tree->data->nodes[0].visible : 0;
+    i64 scroll_row = (i64)tree->scroll_row + rows;
+    if(scroll_row >= row_count) scroll_row = row_count - 1;
+    if(scroll_row < 0) scroll_row = 0;
+    tree->scroll_row = (u32)scroll_row;
+}
+
+void tgui_tree_bind(TGuiHandle tree_handle, TGuiTreeSource *source, u32 node_count, u32 root)
+{
+    TGuiWidgetTree *tree = tgui_tree_get(tree_handle);
+    tgui_tree_destroy(tree);
+    TGuiTreeData *data = (TGuiTreeData *)malloc(sizeof(TGuiTreeData));
+    memset(data, 0, sizeof(TGuiTreeData));
+    data->source = *source;
+    data->node_count = node_count;
+    data->free_node = TGUI_TREE_NONE;
+    u32 expanded_size = ((node_count + 31) / 32)*sizeof(u32);
+    data->expanded = (u32 *)malloc(expanded_size);
+    memset(data->expanded, 0, expanded_size);
+    TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, expanded_size);
+    
+    u32 root_entry = tgui_tree_push_node(data);
+    TGuiTreeNode *root_node = data->nodes + root_entry;
+    root_node->node = root;
+    root_node->parent = TGUI_TREE_NONE;
+    root_node->index = 0;
+    root_node->child_count = source->child_count(source->data, root);
+    root_node->visible = root_node->child_count;
+    root_node->first_child = TGUI_TREE_NONE;
+    root_node->next_sibling = TGUI_TREE_NONE;
+    if(root < node_count) tgui_bit_set(data->expanded, root, true);
+    tree->data = data;
+    tree->scroll_row = 0;
+}
+
+void tgui_tree_toggle_row(TGuiHandle tree_handle, u32 row)
+{
+    TGuiWidgetTree *tree = tgui_tree_get(tree_handle);
+    TGuiTreeData *data = tree->data;
+    if(!data || row >= data->nodes[0].visible) return;
+    u32 depth = tgui_tree_find_row(data, row);
+    TGuiTreeLevel *level = data->levels + depth - 1;
+    u32 entry = tgui_tree_level_entry(data, level);
+    if(entry != TGUI_TREE_NONE)
+    {
+        tgui_tree_collapse(data, entry);
+        tgui_tree_scroll(tree, 0);
+    }
+    else
+    {
+        tgui_tree_expand(data, level->entry, level->index);
+    }
+}
+
+void tgui_tree_scroll_to(TGuiHandle tree_handle, u32 row)
+{
+    TGuiWidgetTree *tree = tgui_tree_get(tree_handle);
+    tree->scroll_row = 0;
+    tgui_tree_scroll(tree, (i64)row);
+}
+
+u32 tgui_tree_get_row_count(TGuiHandle tree_handle)
+{
+    TGuiWidgetTree *tree = tgui_tree_get(tree_handle);
+    return tree->data ? tree->data->nodes[0].visible : 0;
+}
+
+u32 tgui_tree_get_row_node(TGuiHandle tree_handle, u32 row)
+{
+    TGuiWidgetTree *tree = tgui_tree_get(tree_handle);
+    TGuiTreeData *data = tree->data;
+    if(!data || row >= data->nodes[0].visible) return TGUI_TREE_NONE;
+    u32 depth = tgui_tree_find_row(data, row);
+    return tgui_tree_level_node(data, data->levels + depth - 1);
+}
+
+static void tgui_textbox_push_character(TGuiWidgetTextBox *textbox, u8 character)
+{
+    u32 offset = tgui_textbox_get_cursor_offset(textbox);
+    tgui_text_buffer_insert(&textbox->text, offset, &character, 1);
+    textbox->cursor_position.x++;
+}
+
+static void tgui_textbox_push_newline(TGuiWidgetTextBox *textbox)
+{
+    u8 newline = '\n';
+    u32 offset = tgui_textbox_get_cursor_offset(textbox);
+    tgui_text_buffer_insert(&textbox->text, offset, &newline, 1);
+    textbox->cursor_position.y++;
+    textbox->cursor_position.x = 0;
+}
+
+static void tgui_textbox_delete_current_character(TGuiWidgetTextBox *textbox)
+{
+    u32 offset = tgui_textbox_get_cursor_offset(textbox);
+    if(textbox->cursor_position.x > 0)
+    {
+        tgui_text_buffer_delete(&textbox->text, offset - 1, offset);
+        textbox->cursor_position.x--;
+    }
+    else if(textbox->cursor_position.y > 0)
+    {
+        // NOTE: delete the new line character, the current line is join with the previous one
+        u32 prev_line_size = tgui_text_buffer_line_size(&textbox->text, textbox->cursor_position.y - 1);
+        tgui_text_buffer_delete(&textbox->text, offset - 1, offset);
+        textbox->cursor_position.y--;
+        textbox->cursor_position.x = prev_line_size;
+    }
+}
+
+static b32 tgui_textbox_update(TGuiState *state, TGuiWidgetTextBox *textbox)
+{
+    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
+    TGuiV2 widget_abs_pos = tgui_widget_abs_pos(textbox->header.handle);
+
+    TGuiRect text_box = {0};
+    text_box.pos = widget_abs_pos;
+    text_box.dim = textbox->header.size;
+    if(tgui_mouse_hit_test(mouse, text_box))
+    {
+        textbox->hot = true;
+    }
+    else
+    {
+        textbox->hot = false;
+    }
+
+    if(textbox->hot && state->mouse_down)
+    {
+        state->widget_active = textbox->header.handle;
+        textbox->blink_start = state->time;
+    }
+    
+    if(state->mouse_up && !tgui_mouse_hit_test(mouse, text_box))
+    {
+        state->widget_active = TGUI_INVALID_HANDLE;
+    }
+    
+    if(textbox->hot) return true;
+    
+    return false;
+}
+
+static b32 tgui_textview_update(TGuiState *state, TGuiWidgetTextView *textview)
+{
+    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
+    TGuiV2 widget_abs_pos = tgui_widget_abs_pos(textview->header.handle);
+
+    TGuiRect text_box = {0};
+    text_box.pos = widget_abs_pos;
+    text_box.dim = textview->header.size;
+    textview->hot = tgui_mouse_hit_test(mouse, text_box);
+
+    if(textview->hot && state->mouse_down)
+    {
+        state->widget_active = textview->header.handle;
+    }
+    
+    if(state->mouse_up && !textview->hot)
+    {
+        state->widget_active = TGUI_INVALID_HANDLE;
+    }
+    
+    if(textview->hot) return true;
+    
+    return false;
+}
+
+static b32 tgui_grid_update(TGuiState *state, TGuiWidgetGrid *grid)
+{
+    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
+    TGuiRect grid_box = tgui_widget_get_collision_box((TGuiWidget *)grid);
+    grid->hot = tgui_mouse_hit_test(mouse, grid_box) && tgui_mouse_is_in_parent(grid->header.handle);
+
+    // NOTE: the active grid is scroll with the arrows
+    if(grid->hot && state->mouse_down)
+    {
+        state->widget_active = grid->header.handle;
+    }
+    
+    if(state->mouse_up && !grid->hot)
+    {
+        state->widget_active = TGUI_INVALID_HANDLE;
+    }
+    
+    return grid->hot;
+}
+
+static b32 tgui_tree_update(TGuiState *state, TGuiWidgetTree *tree)
+{
+    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
+    TGuiRect tree_box = tgui_widget_get_collision_box((TGuiWidget *)tree);
+    tree->hot = tgui_mouse_hit_test(mouse, tree_box) && tgui_mouse_is_in_parent(tree->header.handle);
+    tree->hot_row = TGUI_TREE_NONE;
+    if(tree->hot && tree->data)
+    {
+        u32 row = tree->scroll_row + (u32)(mouse.y - tree_box.y) / (state->font_height + TGUI_TREE_ROW_PADDING);
+        if(row < tree->data->nodes[0].visible) tree->hot_row = row;
+    }
+
+    // NOTE: a click expand or collapse the row, the active tree is scroll with the arrows
+    if(tree->hot && state->mouse_down)
+    {
+        state->widget_active = tree->header.handle;
+        if(tree->hot_row != TGUI_TREE_NONE) tgui_tree_toggle_row(tree->header.handle, tree->hot_row);
+    }
+    
+    if(state->mouse_up && !tree->hot)
+    {
+        state->widget_active = TGUI_INVALID_HANDLE;
+    }
+    
+    return tree->hot;
+}
+
+static b32 tgui_plot_update(TGuiState *state, TGuiWidgetPlot *plot)
+{
+    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
+    TGuiRect plot_box = tgui_widget_get_collision_box((TGuiWidget *)plot);
+    plot->hot = tgui_mouse_hit_test(mouse, plot_box) && tgui_mouse_is_in_parent(plot->header.handle);
+    return plot->hot;
+}
+
+b32 tgui_widget_update(TGuiHandle handle)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiWidget *widget = tgui_widget_get(handle);
+    TGUI_PROFILE_COUNT(TGUI_COUNTER_WIDGETS_VISITED, 1);
+
+    if(!tgui_widget_is_active(handle))
+    {
+        return false;
+    }
+    
+    if(state->widget_active == handle)
+    {
+        tgui_container_set_to_top(widget);
+    }
+    
+    switch(widget->header.type)
+    {
+#define TGUI_WIDGET_UPDATE(type, name, type_struct) case type: return tgui_##name##_update(state, (type_struct *)widget);
+        TGUI_WIDGET_TYPES(TGUI_WIDGET_UPDATE)
+#undef TGUI_WIDGET_UPDATE
+        default: break;
+    }
+    TGuiWidgetClass *widget_class = tgui_widget_class(widget->header.type);
+    return widget_class->update ? widget_class->update(widget) : false;
+}
+
+static void tgui_occlusion_push_root(TGuiOcclusion *occlusion, TGuiHandle handle, u32 first);
+
+static void tgui_container_render(TGuiState *state, TGuiWidgetContainer *container, TGuiV2 widget_abs_pos)
+{
+    UNUSED_VAR(state);
+    if(container->flags & TGUI_CONTAINER_CACHED)
+    {
+        TGuiDrawCommand begin_layer_cmd = {0};
+        begin_layer_cmd.type = TGUI_DRAWCMD_BEGIN_LAYER;
+        begin_layer_cmd.descriptor.pos = widget_abs_pos;
+        begin_layer_cmd.descriptor.dim = container->header.size;
+        tgui_push_draw_command(begin_layer_cmd);
+    }
+
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_RECT;
+    u32 color = TGUI_DRAK_BLACK;
+    if(container->flags & TGUI_CONTAINER_DYNAMIC) color = TGUI_BLACK;
+    draw_cmd.descriptor.pos = widget_abs_pos;
+    // TODO: maybe create a tgui_get_container_dimension function
+    draw_cmd.descriptor.dim = container->dimension;
+    draw_cmd.color = color;
+    tgui_push_draw_command(draw_cmd);
+    
+    if(container->flags & TGUI_CONTAINER_V_SCROLL)
+    {
+        TGuiDrawCommand back_grip_cmd = {0};
+        back_grip_cmd.type = TGUI_DRAWCMD_RECT;
+        back_grip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, container->vertical_grip.pos);
+        back_grip_cmd.descriptor.dim = container->vertical_grip.dim;
+        back_grip_cmd.color = TGUI_ORANGE;
+        tgui_push_draw_command(back_grip_cmd);
+
+        TGuiDrawCommand grip_cmd = {0};
+        grip_cmd.type = TGUI_DRAWCMD_RECT;
+        grip_cmd.ratio = 4;
+
+        TGuiV2 grip_pos = container->vertical_grip.pos;
+        grip_cmd.descriptor.dim = container->vertical_grip.dim;
+        if(container->total_dimension.y)
+        {
+            f32 grip_ratio = (container->dimension.y / container->total_dimension.y);
+            if(grip_ratio > 1.0f) grip_ratio = 1.0f; 
+            grip_cmd.descriptor.dim.y = grip_ratio * container->vertical_grip.height;
+        }
+        grip_pos.y = container->vertical_value * (container->dimension.y - grip_cmd.descriptor.dim.y);
+        grip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, grip_pos);
+        grip_cmd.color = TGUI_GREEN;
+        tgui_push_draw_command(grip_cmd);
+    }
+    if(container->flags & TGUI_CONTAINER_H_SCROLL)
+    {
+        TGuiDrawCommand back_grip_cmd = {0};
+        back_grip_cmd.type = TGUI_DRAWCMD_RECT;
+        back_grip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, container->horizontal_grip.pos);
+        back_grip_cmd.descriptor.dim = container->horizontal_grip.dim;
+        back_grip_cmd.color = TGUI_ORANGE;
+        tgui_push_draw_command(back_grip_cmd);
+
+        TGuiDrawCommand grip_cmd = {0};
+        grip_cmd.type = TGUI_DRAWCMD_RECT;
+        grip_cmd.ratio = 4;
+
+        TGuiV2 grip_pos = container->horizontal_grip.pos;
+        grip_cmd.descriptor.dim = container->horizontal_grip.dim;
+        if(container->total_dimension.x)
+        {
+            f32 grip_ratio = (container->dimension.x / container->total_dimension.x);
+            if(grip_ratio > 1.0f) grip_ratio = 1.0f; 
+            grip_cmd.descriptor.dim.x = grip_ratio  * container->horizontal_grip.width;
+        }
+        grip_pos.x = container->horizontal_value * (container->dimension.x - grip_cmd.descriptor.dim.x);
+        grip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, grip_pos);
+        grip_cmd.color = TGUI_GREEN;
+        tgui_push_draw_command(grip_cmd);
+    }
+
+    TGuiDrawCommand start_clip_cmd = {0};
+    start_clip_cmd.type = TGUI_DRAWCMD_START_CLIPPING;
+    start_clip_cmd.descriptor.pos = widget_abs_pos;
+    start_clip_cmd.descriptor.dim = container->dimension;
+    if(container->flags & (TGUI_CONTAINER_V_SCROLL|TGUI_CONTAINER_H_SCROLL))
+    {
+        TGuiV2 scroll_offset = tgui_container_scroll_offset(container);
+        start_clip_cmd.scroll = true;
+        start_clip_cmd.scroll_x = (i32)scroll_offset.x;
+        start_clip_cmd.scroll_y = (i32)scroll_offset.y;
+    }
+    tgui_push_draw_command(start_clip_cmd);
+}
+
+static void tgui_end_container_render(TGuiState *state, TGuiWidgetEndContainer *end_container, TGuiV2 widget_abs_pos)
+{
+    UNUSED_VAR(state);
+    UNUSED_VAR(widget_abs_pos);
+    TGuiDrawCommand end_clip_cmd = {0};
+    end_clip_cmd.type = TGUI_DRAWCMD_END_CLIPPING;
+    tgui_push_draw_command(end_clip_cmd);
+
+    TGuiWidget *container = tgui_widget_get(end_container->header.parent);
+    if(container && (container->container.flags & TGUI_CONTAINER_CACHED))
+    {
+        TGuiDrawCommand end_layer_cmd = {0};
+        end_layer_cmd.type = TGUI_DRAWCMD_END_LAYER;
+        tgui_push_draw_command(end_layer_cmd);
+    }
+}
+
+static void tgui_button_render(TGuiState *state, TGuiWidgetButton *button, TGuiV2 widget_abs_pos)
+{
+    UNUSED_VAR(state);
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_RECT;
+    draw_cmd.descriptor.pos = widget_abs_pos;
+    draw_cmd.descriptor.dim = button->header.size;
+    
+    u32 color = TGUI_GREY;
+    if(button->hot) color = TGUI_ORANGE;
+    if(button->active) color = TGUI_GREEN;
+    if(button->pressed) color = TGUI_RED;
+    draw_cmd.color = color;
+    tgui_push_draw_command(draw_cmd);
+        
+    TGuiRect text_rect;
+    text_rect.dim = button->text.size;
+    text_rect.pos = tgui_v2_sub(tgui_v2_add(widget_abs_pos, tgui_v2_scale(button->header.size, 0.5f)), tgui_v2_scale(button->text.size, 0.5f));
+
+    TGuiDrawCommand text_cmd = {0};
+    text_cmd.type = TGUI_DRAWCMD_TEXT;
+    text_cmd.descriptor = text_rect;
+    text_cmd.text = button->text.text;
+    text_cmd.text_size = strlen(button->text.text);
+    tgui_push_draw_command(text_cmd);
+}
+
+static void tgui_checkbox_render(TGuiState *state, TGuiWidgetCheckBox *checkbox, TGuiV2 widget_abs_pos)
+{
+    UNUSED_VAR(state);
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_RECT;
+    
+    draw_cmd.descriptor.pos = widget_abs_pos;
+    draw_cmd.descriptor.dim = checkbox->box_dimension;
+    draw_cmd.ratio = 4;
+
+    u32 color = TGUI_RED; 
+    if(checkbox->checked)
+    {
+        color = TGUI_GREEN;
+    }
+    draw_cmd.color = color;
+    tgui_push_draw_command(draw_cmd);
+        
+    TGuiRect text_rect;
+    text_rect.dim = checkbox->text.size;
+    text_rect.pos = widget_abs_pos;
+    text_rect.pos.y += checkbox->box_dimension.y*0.5f - checkbox->text.size.y*0.5f;
+    text_rect.pos.x += checkbox->box_dimension.x + 5;
+    TGuiDrawCommand text_cmd = {0};
+    text_cmd.type = TGUI_DRAWCMD_TEXT;
+    text_cmd.descriptor = text_rect;
+    text_cmd.text = checkbox->text.text;
+    text_cmd.text_size = strlen(checkbox->text.text);
+    tgui_push_draw_command(text_cmd);
+}
+
+static void tgui_slider_render(TGuiState *state, TGuiWidgetSlider *slider, TGuiV2 widget_abs_pos)
+{
+    UNUSED_VAR(state);
+    TGuiDrawCommand line_cmd = {0};
+    line_cmd.type = TGUI_DRAWCMD_RECT;
+    line_cmd.descriptor.pos = widget_abs_pos;
+    line_cmd.descriptor.pos.y += (slider->header.size.y * (0.5f*slider->ratio));
+    line_cmd.descriptor.dim = slider->header.size;
+    line_cmd.descriptor.dim.y *= slider->ratio;
+    line_cmd.color = TGUI_ORANGE;
+    tgui_push_draw_command(line_cmd);
+
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_RECT;
+    draw_cmd.descriptor.pos = widget_abs_pos;
+    draw_cmd.descriptor.dim = slider->grip_dimension;
+    draw_cmd.descriptor.x += (slider->value * slider->header.size.x) - (0.5f*slider->grip_dimension.x);
+    draw_cmd.ratio = 4;
+    draw_cmd.color = TGUI_GREY;
+    tgui_push_draw_command(draw_cmd);
+}
+
+static void tgui_textbox_render(TGuiState *state, TGuiWidgetTextBox *textbox, TGuiV2 widget_abs_pos)
+{
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_RECT;
+    draw_cmd.descriptor.pos = widget_abs_pos;
+    draw_cmd.descriptor.dim = textbox->header.size;
+    draw_cmd.color = TGUI_DRAK_BLACK;
+    tgui_push_draw_command(draw_cmd);
+
+    TGuiDrawCommand start_clip_cmd = {0};
+    start_clip_cmd.type = TGUI_DRAWCMD_START_CLIPPING;
+    start_clip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, tgui_v2(textbox->margin, textbox->margin));
+    start_clip_cmd.descriptor.dim = textbox->dimension;
+    tgui_push_draw_command(start_clip_cmd);
+
+    // NOTE: only the lines and columns inside the view port are emitted
+    TGuiTextBuffer *text_buffer = &textbox->text;
+    TGuiV2i visible = tgui_textbox_get_visible_size(state, textbox);
+    u32 line_count = tgui_text_buffer_line_count(text_buffer);
+    u32 first_line = textbox->scroll.y;
+    u32 last_line = first_line + visible.y;
+    if(last_line > line_count) last_line = line_count;
+    for(u32 line_index = first_line; line_index < last_line; ++line_index)
+    {
+        u32 line_start = tgui_text_buffer_line_start(text_buffer, line_index);
+        u32 line_size = tgui_text_buffer_line_size(text_buffer, line_index);
+        if(line_size <= (u32)textbox->scroll.x) continue;
+        line_start += textbox->scroll.x;
+        line_size -= textbox->scroll.x;
+        if(line_size > (u32)visible.x) line_size = visible.x;
+
+        TGuiDrawCommand text_cmd = {0};
+        text_cmd.type = TGUI_DRAWCMD_TEXT;
+        text_cmd.descriptor.x = widget_abs_pos.x + textbox->margin;
+        text_cmd.descriptor.y = widget_abs_pos.y + (state->font_height * (line_index - first_line)) + textbox->margin;
+        text_cmd.text = (char *)tgui_text_buffer_get_text(text_buffer, line_start, line_size, &state->draw_command_buffer.arena);
+        text_cmd.text_size = line_size;
+        tgui_push_draw_command(text_cmd);
+    }
+    
+    // NOTE: only the active textbox show the cursor, it is visible the first half of every blink
+    // and the next frame is requested for the time it change
+    if(state->widget_active == textbox->header.handle)
+    {
+        if(state->time < textbox->blink_start) textbox->blink_start = state->time;
+        u64 blink = (u64)((state->time - textbox->blink_start) / TGUI_CURSOR_BLINK_TIME);
+        tgui_request_deadline(state, textbox->blink_start + (f64)(blink + 1)*TGUI_CURSOR_BLINK_TIME);
+        if((blink & 1) == 0)
+        {
+            TGuiV2i cursor_position = tgui_v2i_sub(textbox->cursor_position, textbox->scroll);
+            TGuiDrawCommand cursor_cmd = {0};
+            cursor_cmd.type = TGUI_DRAWCMD_RECT;
+            cursor_cmd.descriptor.x = widget_abs_pos.x + (state->font_width * cursor_position.x) + textbox->margin;
+            cursor_cmd.descriptor.y = widget_abs_pos.y + (state->font_height * cursor_position.y) + textbox->margin;
+            cursor_cmd.descriptor.width = 2;
+            cursor_cmd.descriptor.height = state->font_height;
+            cursor_cmd.color = TGUI_GREEN;
+            tgui_push_draw_command(cursor_cmd);
+        }
+    }
+
+    TGuiDrawCommand end_clip_cmd = {0};
+    end_clip_cmd.type = TGUI_DRAWCMD_END_CLIPPING;
+    tgui_push_draw_command(end_clip_cmd);
+}
+
+static void tgui_textview_render(TGuiState *state, TGuiWidgetTextView *textview, TGuiV2 widget_abs_pos)
+{
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_RECT;
+    draw_cmd.descriptor.pos = widget_abs_pos;
+    draw_cmd.descriptor.dim = textview->header.size;
+    draw_cmd.color = TGUI_DRAK_BLACK;
+    tgui_push_draw_command(draw_cmd);
+
+    TGuiDrawCommand start_clip_cmd = {0};
+    start_clip_cmd.type = TGUI_DRAWCMD_START_CLIPPING;
+    start_clip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, tgui_v2(textview->margin, textview->margin));
+    start_clip_cmd.descriptor.dim = textview->dimension;
+    tgui_push_draw_command(start_clip_cmd);
+    
+    // NOTE: only the lines and columns inside the view port are emitted, the text is read from the file mapping
+    TGuiTextViewIndex *index = textview->index;
+    u32 visible_columns = ((u32)textview->dimension.x + state->font_width - 1) / state->font_width;
+    u32 visible_lines = ((u32)textview->dimension.y + state->font_height - 1) / state->font_height;
+    u64 line_count = TGUI_ATOMIC_LOAD(&index->line_count);
+    // NOTE: the lines that the index thread find are shown in the next frames
+    if(!TGUI_ATOMIC_LOAD(&index->done))
+    {
+        tgui_request_deadline(state, state->time + TGUI_TEXTVIEW_INDEX_POLL_TIME);
+    }
+    u64 offset = index->size ? tgui_textview_get_line_offset(index, textview->scroll_line) : 0;
+    for(u32 line_index = 0; (line_index < visible_lines) && (textview->scroll_line + line_index < line_count) && (offset < index->size); ++line_index)
+    {
+        u8 *line = index->data + offset;
+        u8 *newline = (u8 *)memchr(line, '\n', index->size - offset);
+        u64 line_size = newline ? (u64)(newline - line) : (index->size - offset);
+        offset += line_size + 1;
+        if(line_size && line[line_size - 1] == '\r') --line_size;
+        if(line_size <= textview->scroll_column) continue;
+        line += textview->scroll_column;
+        line_size -= textview->scroll_column;
+        if(line_size > visible_columns) line_size = visible_columns;
+
+        TGuiDrawCommand text_cmd = {0};
+        text_cmd.type = TGUI_DRAWCMD_TEXT;
+        text_cmd.descriptor.x = widget_abs_pos.x + textview->margin;
+        text_cmd.descriptor.y = widget_abs_pos.y + (state->font_height * line_index) + textview->margin;
+        text_cmd.text = (char *)line;
+        text_cmd.text_size = (u32)line_size;
+        tgui_push_draw_command(text_cmd);
+    }
+
+    TGuiDrawCommand end_clip_cmd = {0};
+    end_clip_cmd.type = TGUI_DRAWCMD_END_CLIPPING;
+    tgui_push_draw_command(end_clip_cmd);
+}
+
+static TGuiPlotCache *tgui_plot_cache_create(u32 column_size)
+{
+    TGuiPlotCache *cache = (TGuiPlotCache *)malloc(sizeof(TGuiPlotCache));
+    memset(cache, 0, sizeof(TGuiPlotCache));
+    cache->column_size = column_size;
+    for(u32 level_index = 0; level_index < TGUI_PLOT_CACHE_LEVELS; ++level_index)
+    {
+        cache->levels[level_index].columns = (TGuiPlotColumn *)malloc(column_size*sizeof(TGuiPlotColumn));
+    }
+    cache->spans = (TGuiSpan *)malloc(column_size*sizeof(TGuiSpan));
+    TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, sizeof(TGuiPlotCache) + column_size*(TGUI_PLOT_CACHE_LEVELS*sizeof(TGuiPlotColumn) + sizeof(TGuiSpan)));
+    return cache;
+}
+
+// NOTE: y of the value from the top of the plot, the values out of the range are put in the border
+inline static f32 tgui_plot_y(TGuiWidgetPlot *plot, f32 value, f32 scale)
+{
+    f32 y = (plot->max_value - value)*scale;
+    return TGUI_MAX(-1.0f, TGUI_MIN(y, plot->dimension.y + 1.0f));
+}
+
+static void tgui_plot_render(TGuiState *state, TGuiWidgetPlot *plot, TGuiV2 widget_abs_pos)
+{
+    UNUSED_VAR(state);
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_RECT;
+    draw_cmd.descriptor.pos = widget_abs_pos;
+    draw_cmd.descriptor.dim = plot->header.size;
+    draw_cmd.color = TGUI_DRAK_BLACK;
+    tgui_push_draw_command(draw_cmd);
+
+    u32 column_count = (u32)plot->dimension.x;
+    if(!plot->samples || !plot->capacity || !plot->sample_count || !column_count) return;
+    if(!plot->cache) plot->cache = tgui_plot_cache_create(column_count);
+    TGuiPlotCache *cache = plot->cache;
+    
+    // NOTE: one column for every pixel, the newest sample is in the right border
+    u64 view_count = plot->view_count ? plot->view_count : column_count;
+    u64 samples_per_column = (view_count + column_count - 1) / column_count;
+    TGuiPlotLevel *level = tgui_plot_level(plot, samples_per_column);
+    // NOTE: the columns with samples that are not in the ring any more are not show, so the plot is the same
+    // with or without the cache
+    u64 oldest = plot->sample_count > plot->capacity ? plot->sample_count - plot->capacity : 0;
+    u64 last_column = (plot->sample_count - 1) / samples_per_column;
+    u64 first_column = last_column + 1 > column_count ? last_column + 1 - column_count : 0;
+    first_column = TGUI_MAX(first_column, (oldest + samples_per_column - 1) / samples_per_column);
+    first_column = TGUI_MAX(first_column, level->first_column);
+    
+    f32 range = plot->max_value - plot->min_value;
+    f32 scale = range != 0 ? plot->dimension.y / range : 0;
+    u32 span_count = 0;
+    f32 last_y = 0;
+    for(u64 column = first_column; column <= last_column; ++column)
+    {
+        // NOTE: the last column can be incomplete, it is not in the cache
+        TGuiPlotColumn plot_column;
+        if(column < level->end_column) plot_column = level->columns[column % cache->column_size];
+        else if(!tgui_plot_column(plot, column, samples_per_column, &plot_column)) break;
+        
+        // NOTE: the column join with the last sample of the column before, so the line dont have holes
+        f32 min_y = tgui_plot_y(plot, plot_column.max, scale);
+        f32 max_y = tgui_plot_y(plot, plot_column.min, scale);
+        if(span_count)
+        {
+            min_y = TGUI_MIN(min_y, last_y);
+            max_y = TGUI_MAX(max_y, last_y);
+        }
+        last_y = tgui_plot_y(plot, plot_column.last, scale);
+        if(max_y - min_y < 1.0f)
+        {
+            min_y -= (1.0f - (max_y - min_y))*0.5f;
+            max_y = min_y + 1.0f;
+        }
+        cache->spans[span_count].min_y = min_y;
+        cache->spans[span_count].max_y = max_y;
+        ++span_count;
+    }
+    if(!span_count) return;
+
+    TGuiDrawCommand start_clip_cmd = {0};
+    start_clip_cmd.type = TGUI_DRAWCMD_START_CLIPPING;
+    start_clip_cmd.descriptor.pos = widget_abs_pos;
+    start_clip_cmd.descriptor.dim = plot->dimension;
+    tgui_push_draw_command(start_clip_cmd);
+
+    TGuiDrawCommand spans_cmd = {0};
+    spans_cmd.type = TGUI_DRAWCMD_SPANS;
+    spans_cmd.descriptor.x = widget_abs_pos.x + (column_count - (u32)(last_column - first_column + 1));
+    spans_cmd.descriptor.y = widget_abs_pos.y;
+    spans_cmd.descriptor.width = span_count;
+    spans_cmd.descriptor.height = plot->dimension.y;
+    spans_cmd.color = plot->color;
+    spans_cmd.text = (char *)cache->spans;
+    spans_cmd.text_size = span_count*sizeof(TGuiSpan);
+    tgui_push_draw_command(spans_cmd);
+
+    TGuiDrawCommand end_clip_cmd = {0};
+    end_clip_cmd.type = TGUI_DRAWCMD_END_CLIPPING;
+    tgui_push_draw_command(end_clip_cmd);
+}
+
+// NOTE: a row of cells is one TEXT command, every cell is cut to the width of its column less one
+// character and fill with spaces, the header row has the names of the columns. Return the size without
+// the spaces at the end
+static u32 tgui_grid_run(TGuiGridData *data, u32 *columns, u32 column_count, u64 row, b32 header)
+{
+    u32 size = 0;
+    u32 text_end = 0;
+    for(u32 column_index = 0; column_index < column_count; ++column_index)
+    {
+        TGuiGridColumn *grid_column = data->columns + columns[column_index];
+        u32 text_size = 0;
+        char *text = 0;
+        if(header)
+        {
+            text = grid_column->name;
+            while(text && text[text_size]) ++text_size;
+        }
+        else
+        {
+            TGuiGridCell *cell = tgui_grid_cell(data, row, columns[column_index]);
+            text = cell->text;
+            text_size = cell->text_size;
+        }
+        u32 width = grid_column->width;
+        if(text_size + 1 > width) text_size = width ? width - 1 : 0;
+        memcpy(data->run + size, text, text_size);
+        memset(data->run + size + text_size, ' ', width - text_size);
+        if(text_size) text_end = size + text_size;
+        size += width;
+    }
+    return text_end;
+}
+
+static void tgui_grid_render(TGuiState *state, TGuiWidgetGrid *grid, TGuiV2 widget_abs_pos)
+{
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_RECT;
+    draw_cmd.descriptor.pos = widget_abs_pos;
+    draw_cmd.descriptor.dim = grid->header.size;
+    draw_cmd.color = TGUI_DRAK_BLACK;
+    tgui_push_draw_command(draw_cmd);
+
+    TGuiGridData *data = grid->data;
+    if(!data || !data->column_count) return;
+    
+    // NOTE: the fixed columns and then the ones after the scroll until the width is full
+    u32 visible_chars = ((u32)grid->dimension.x + state->font_width - 1) / state->font_width;
+    u32 *columns = (u32 *)tgui_arena_push(&state->draw_command_buffer.arena, data->column_count*sizeof(u32));
+    u32 column_count = 0;
+    u32 run_size = 0;
+    u32 fixed_chars = 0;
+    for(u32 column = 0; column < data->column_count && run_size < visible_chars; ++column)
+    {
+        if(column == grid->fixed_columns) fixed_chars = run_size;
+        if(column >= grid->fixed_columns && column < grid->fixed_columns + grid->scroll_column) continue;
+        columns[column_count++] = column;
+        run_size += data->columns[column].width;
+    }
+    if(grid->fixed_columns >= data->column_count) fixed_chars = run_size;
+    if(run_size > data->run_size)
+    {
+        free(data->run);
+        data->run_size = run_size*2;
+        data->run = (char *)malloc(data->run_size);
+        TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, data->run_size);
+    }
+
+    // NOTE: the first line is the header, the cache has space for the visible cells
+    u32 row_height = state->font_height + TGUI_GRID_ROW_PADDING;
+    u32 line_count = ((u32)grid->dimension.y + row_height - 1) / row_height;
+    u32 visible_cells = line_count*column_count;
+    if(data->cell_size < visible_cells*2)
+    {
+        u32 cell_size = 64;
+        while(cell_size < visible_cells*4) cell_size *= 2;
+        free(data->cells);
+        data->cells = (TGuiGridCell *)malloc(cell_size*sizeof(TGuiGridCell));
+        memset(data->cells, 0, cell_size*sizeof(TGuiGridCell));
+        // NOTE: no column has this index so the empty cells never match
+        for(u32 cell_index = 0; cell_index < cell_size; ++cell_index) data->cells[cell_index].column = TGUI_GRID_ALL_COLUMNS;
+        data->cell_size = cell_size;
+        TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, cell_size*sizeof(TGuiGridCell));
+    }
+
+    ++data->frame;
+
+    TGuiDrawCommand start_clip_cmd = {0};
+    start_clip_cmd.type = TGUI_DRAWCMD_START_CLIPPING;
+    start_clip_cmd.descriptor.pos = widget_abs_pos;
+    start_clip_cmd.descriptor.dim = grid->dimension;
+    tgui_push_draw_command(start_clip_cmd);
+
+    TGuiDrawCommand header_cmd = {0};
+    header_cmd.type = TGUI_DRAWCMD_RECT;
+    header_cmd.descriptor.pos = widget_abs_pos;
+    header_cmd.descriptor.width = grid->dimension.x;
+    header_cmd.descriptor.height = row_height;
+    header_cmd.color = TGUI_BLACK;
+    tgui_push_draw_command(header_cmd);
+    
+    for(u32 line = 0; line < line_count; ++line)
+    {
+        u64 row = 0;
+        if(line > 0)
+        {
+            row = line - 1;
+            if(row >= grid->fixed_rows) row += grid->scroll_row;
+            if(row >= grid->row_count) break;
+        }
+        TGuiDrawCommand text_cmd = {0};
+        text_cmd.type = TGUI_DRAWCMD_TEXT;
+        text_cmd.descriptor.x = widget_abs_pos.x;
+        text_cmd.descriptor.y = widget_abs_pos.y + line*row_height + TGUI_GRID_ROW_PADDING/2;
+        text_cmd.text = data->run;
+        text_cmd.text_size = tgui_grid_run(data, columns, column_count, row, line == 0);
+        if(text_cmd.text_size) tgui_push_draw_command(text_cmd);
+    }
+
+    // NOTE: lines after the header, the fixed rows and the fixed columns
+    TGuiDrawCommand line_cmd = {0};
+    line_cmd.type = TGUI_DRAWCMD_RECT;
+    line_cmd.color = TGUI_GREY;
+    line_cmd.descriptor = tgui_rect_xywh(widget_abs_pos.x, widget_abs_pos.y + row_height - 1, grid->dimension.x, 1);
+    tgui_push_draw_command(line_cmd);
+    if(grid->fixed_rows)
+    {
+        u32 fixed_rows = (u32)TGUI_MIN(grid->fixed_rows, grid->row_count);
+        line_cmd.descriptor.y = widget_abs_pos.y + (fixed_rows + 1)*row_height - 1;
+        tgui_push_draw_command(line_cmd);
+    }
+    if(grid->fixed_columns && fixed_chars)
+    {
+        line_cmd.descriptor = tgui_rect_xywh(widget_abs_pos.x + fixed_chars*state->font_width - state->font_width/2, widget_abs_pos.y, 1, grid->dimension.y);
+        tgui_push_draw_command(line_cmd);
+    }
+
+    TGuiDrawCommand end_clip_cmd = {0};
+    end_clip_cmd.type = TGUI_DRAWCMD_END_CLIPPING;
+    tgui_push_draw_command(end_clip_cmd);
+}
+
+// NOTE: the visible rows are walk from the first one, only its nodes are ask to the application
+static void tgui_tree_render(TGuiState *state, TGuiWidgetTree *tree, TGuiV2 widget_abs_pos)
+{
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_RECT;
+    draw_cmd.descriptor.pos = widget_abs_pos;
+    draw_cmd.descriptor.dim = tree->header.size;
+    draw_cmd.color = TGUI_DRAK_BLACK;
+    tgui_push_draw_command(draw_cmd);
+
+    TGuiTreeData *data = tree->data;
+    if(!data || tree->scroll_row >= data->nodes[0].visible) return;
+    
+    TGuiDrawCommand start_clip_cmd = {0};
+    start_clip_cmd.type = TGUI_DRAWCMD_START_CLIPPING;
+    start_clip_cmd.descriptor.pos = widget_abs_pos;
+    start_clip_cmd.descriptor.dim = tree->dimension;
+    tgui_push_draw_command(start_clip_cmd);
+
+    TGuiTreeSource *source = &data->source;
+    u32 row_height = state->font_height + TGUI_TREE_ROW_PADDING;
+    u32 line_count = ((u32)tree->dimension.y + row_height - 1) / row_height;
+    u32 line_size = ((u32)tree->dimension.x + state->font_width - 1) / state->font_width;
+    char *line_text = (char *)tgui_arena_push(&state->draw_command_buffer.arena, line_size + 2);
+    
+    u32 depth = tgui_tree_find_row(data, tree->scroll_row);
+    for(u32 line = 0; line < line_count; ++line)
+    {
+        u32 node = tgui_tree_level_node(data, data->levels + depth - 1);
+        if(tree->scroll_row + line == tree->hot_row)
+        {
+            TGuiDrawCommand hot_cmd = {0};
+            hot_cmd.type = TGUI_DRAWCMD_RECT;
+            hot_cmd.descriptor = tgui_rect_xywh(widget_abs_pos.x, widget_abs_pos.y + line*row_height, tree->dimension.x, row_height);
+            hot_cmd.color = TGUI_BLACK;
+            tgui_push_draw_command(hot_cmd);
+        }
+        
+        // NOTE: the indent, + for closed nodes with children and - for the open ones, and the label
+        u32 text_size = TGUI_MIN((depth - 1)*TGUI_TREE_INDENT, line_size);
+        memset(line_text, ' ', text_size + 2);
+        if(node < data->node_count && tgui_bit_get(data->expanded, node)) line_text[text_size] = '-';
+        else if(source->child_count(source->data, node)) line_text[text_size] = '+';
+        text_size += 2;
+        if(text_size < line_size && source->label)
+        {
+            text_size += TGUI_MIN(source->label(source->data, node, line_text + text_size, line_size - text_size), line_size - text_size);
+        }
+
+        TGuiDrawCommand text_cmd = {0};
+        text_cmd.type = TGUI_DRAWCMD_TEXT;
+        text_cmd.descriptor.x = widget_abs_pos.x;
+        text_cmd.descriptor.y = widget_abs_pos.y + line*row_height + TGUI_TREE_ROW_PADDING/2;
+        text_cmd.text = line_text;
+        text_cmd.text_size = TGUI_MIN(text_size, line_size);
+        tgui_push_draw_command(text_cmd);
+        
+        if(!tgui_tree_next_row(data, &depth)) break;
+    }
+
+    TGuiDrawCommand end_clip_cmd = {0};
+    end_clip_cmd.type = TGUI_DRAWCMD_END_CLIPPING;
+    tgui_push_draw_command(end_clip_cmd);
+}
+
+b32 tgui_widget_render(TGuiHandle handle)
+{
+    tgui_global_state.render_handle = handle;
+    TGuiWidget *widget = tgui_widget_get(handle);
+    if(!widget->header.parent)
+    {
+        TGuiDrawCommandBuffer *buffer = &tgui_global_state.draw_command_buffer;
+        tgui_occlusion_push_root(&buffer->occlusion, handle, buffer->count);
+    }
+    TGuiV2 widget_abs_pos = tgui_widget_abs_pos(handle);
+    TGUI_PROFILE_COUNT(TGUI_COUNTER_WIDGETS_VISITED, 1);
+    
+    switch(widget->header.type)
+    {
+#define TGUI_WIDGET_RENDER(type, name, type_struct) case type: tgui_##name##_render(&tgui_global_state, (type_struct *)widget, widget_abs_pos); return false;
+        TGUI_WIDGET_TYPES(TGUI_WIDGET_RENDER)
+#undef TGUI_WIDGET_RENDER
+        default: break;
+    }
+    TGuiWidgetClass *widget_class = tgui_widget_class(widget->header.type);
+    if(widget_class->render) widget_class->render(widget, widget_abs_pos);
+    return false;
+}
+
+static void tgui_widget_gather_recursive(TGuiHandle handle, TGuiWidgetType type, TGuiHandle *handles, u32 max_count, u32 *count)
+{
+    TGuiWidget *widget = tgui_widget_get(handle);
+    while(widget)
+    {
+        if(widget->header.child_first)
+        {
+            tgui_widget_gather_recursive(widget->header.child_first, type, handles, max_count, count);
+        }
+        if(widget->header.type == type)
+        {
+            if(*count < max_count) handles[*count] = widget->header.handle;
+            ++*count;
+        }
+        widget = tgui_widget_get(widget->header.sibling_next);
+    }
+}
+
+u32 tgui_widget_gather(TGuiWidgetType type, TGuiHandle *handles, u32 max_count)
+{
+    u32 count = 0;
+    tgui_widget_gather_recursive(tgui_global_state.first_root, type, handles, max_count, &count);
+    return count;
+}
+
+//-----------------------------------------------------
+// NOTE: recursive functions TODO: change to use STAKS
+//-----------------------------------------------------
+b32 tgui_widget_recursive_descent_pre_first_to_last(TGuiHandle handle, TGuiWidgetFP function)
+{
+    TGuiWidget *widget = tgui_widget_get(handle);
+    while(widget)
+    {
+        if(function(widget->header.handle))
+        {
+            // NOTE: if the return true we dont need to keep calling it
+            return true;
+        }
+        if(widget->header.child_first)
+        {
+            if(tgui_widget_recursive_descent_pos_first_to_last(widget->header.child_first, function))
+            {
+                return true;
+            }
+        }
+        widget = tgui_widget_get(widget->header.sibling_next);
+    }
+    return false;
+}
+
+b32 tgui_widget_recursive_descent_pos_first_to_last(TGuiHandle handle, TGuiWidgetFP function)
+{
+    TGuiWidget *widget = tgui_widget_get(handle);
+    while(widget)
+    {
+        if(widget->header.child_first)
+        {
+            if(tgui_widget_recursive_descent_pos_first_to_last(widget->header.child_first, function))
+            {
+                return true;
+            }
+        }
+        if(function(widget->header.handle))
+        {
+            // NOTE: if the return true we dont need to keep calling it
+            return true;
+        }
+        widget = tgui_widget_get(widget->header.sibling_next);
+    }
+    return false;
+}
+
+b32 tgui_widget_recursive_descent_pre_last_to_first(TGuiHandle handle, TGuiWidgetFP function)
+{
+    TGuiWidget *widget = tgui_widget_get(handle);
+    while(widget)
+    {
+        if(function(widget->header.handle))
+        {
+            // NOTE: if the return true we dont need to keep calling it
+            return true;
+        }
+        if(widget->header.child_last)
+        {
+            if(tgui_widget_recursive_descent_pre_last_to_first(widget->header.child_last, function))
+            {
+                return true;
+            }
+        }
+        widget = tgui_widget_get(widget->header.sibling_prev);
+    }
+    return false;
+}
+
+b32 tgui_widget_recursive_descent_pos_last_to_first(TGuiHandle handle, TGuiWidgetFP function)
+{
+    TGuiWidget *widget = tgui_widget_get(handle);
+    while(widget)
+    {
+        if(widget->header.child_last)
+        {
+            if(tgui_widget_recursive_descent_pre_last_to_first(widget->header.child_last, function))
+            {
+                return true;
+            }
+        }
+        if(function(widget->header.handle))
+        {
+            // NOTE: if the return true we dont need to keep calling it
+            return true;
+        }
+        widget = tgui_widget_get(widget->header.sibling_prev);
+    }
+    return false;
+}
+
+//-----------------------------------------------------
+//  NOTE: memory management functions
+//-----------------------------------------------------
+void tgui_text_buffer_create(TGuiTextBuffer *buffer)
+{
+    TGuiGapBuffer *text = &buffer->text;
+    text->buffer_size = TGUI_DEFAULT_GAP_BUFFER_SIZE;
+    text->buffer = (u8 *)malloc(text->buffer_size*sizeof(u8));
+    text->gap_start = 0;
+    text->gap_end = text->buffer_size;
+
+    // NOTE: the text always have at least one line that start at 0
+    TGuiLineIndex *lines = &buffer->lines;
+    lines->buffer_size = TGUI_DEFAULT_LINE_INDEX_SIZE;
+    lines->buffer = (u32 *)malloc(lines->buffer_size*sizeof(u32));
+    lines->buffer[0] = 0;
+    lines->gap_start = 1;
+    lines->gap_end = lines->buffer_size;
+}
+
+void tgui_text_buffer_destroy(TGuiTextBuffer *buffer)
+{
+    free(buffer->text.buffer);
+    free(buffer->lines.buffer);
+    memset(buffer, 0, sizeof(TGuiTextBuffer));
+}
+
+void tgui_text_buffer_clear(TGuiTextBuffer *buffer)
+{
+    buffer->text.gap_start = 0;
+    buffer->text.gap_end = buffer->text.buffer_size;
+    buffer->lines.buffer[0] = 0;
+    buffer->lines.gap_start = 1;
+    buffer->lines.gap_end = buffer->lines.buffer_size;
+}
+
+u32 tgui_text_buffer_size(TGuiTextBuffer *buffer)
+{
+    TGuiGapBuffer *text = &buffer->text;
+    u32 result = text->buffer_size - (text->gap_end - text->gap_start);
+    return result;
+}
+
+u32 tgui_text_buffer_line_count(TGuiTextBuffer *buffer)
+{
+    TGuiLineIndex *lines = &buffer->lines;
+    u32 result = lines->buffer_size - (lines->gap_end - lines->gap_start);
+    return result;
+}
+
+u32 tgui_text_buffer_line_start(TGuiTextBuffer *buffer, u32 line)
+{
+    TGuiLineIndex *lines = &buffer->lines;
+    ASSERT(line < tgui_text_buffer_line_count(buffer));
+    if(line < lines->gap_start)
+    {
+        return lines->buffer[line];
+    }
+    u32 from_end = lines->buffer[line + (lines->gap_end - lines->gap_start)];
+    return tgui_text_buffer_size(buffer) - from_end;
+}
+
+u32 tgui_text_buffer_line_size(TGuiTextBuffer *buffer, u32 line)
+{
+    u32 line_start = tgui_text_buffer_line_start(buffer, line);
+    if(line + 1 < tgui_text_buffer_line_count(buffer))
+    {
+        // NOTE: dont count the new line character
+        return tgui_text_buffer_line_start(buffer, line + 1) - line_start - 1;
+    }
+    return tgui_text_buffer_size(buffer) - line_start;
+}
+
+u32 tgui_text_buffer_find_line(TGuiTextBuffer *buffer, u32 offset)
+{
+    // NOTE: binary search the last line that start before or at offset
+    u32 low = 0;
+    u32 high = tgui_text_buffer_line_count(buffer);
+    while(high - low > 1)
+    {
+        u32 middle = low + (high - low) / 2;
+        if(tgui_text_buffer_line_start(buffer, middle) <= offset)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static void tgui_gap_buffer_move_gap(TGuiGapBuffer *text, u32 offset)
+{
+    if(offset < text->gap_start)
+    {
+        u32 size = text->gap_start - offset;
+        memmove(text->buffer + text->gap_end - size, text->buffer + offset, size);
+        text->gap_start -= size;
+        text->gap_end -= size;
+    }
+    else if(offset > text->gap_start)
+    {
+        u32 size = offset - text->gap_start;
+        memmove(text->buffer + text->gap_start, text->buffer + text->gap_end, size);
+        text->gap_start += size;
+        text->gap_end += size;
+    }
+}
+
+static void tgui_gap_buffer_reserve(TGuiGapBuffer *text, u32 size)
+{
+    u32 gap_size = text->gap_end - text->gap_start;
+    if(gap_size < size)
+    {
+        u32 new_buffer_size = text->buffer_size * 2;
+        while(new_buffer_size - (text->buffer_size - gap_size) < size)
+        {
+            new_buffer_size *= 2;
+        }
+        u32 after_gap_size = text->buffer_size - text->gap_end;
+        u8 *new_buffer = (u8 *)malloc(new_buffer_size*sizeof(u8));
+        TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, new_buffer_size*sizeof(u8));
+        memcpy(new_buffer, text->buffer, text->gap_start);
+        memcpy(new_buffer + new_buffer_size - after_gap_size, text->buffer + text->gap_end, after_gap_size);
+        free(text->buffer);
+        text->buffer = new_buffer;
+        text->buffer_size = new_buffer_size;
+        text->gap_end = new_buffer_size - after_gap_size;
+    }
+}
+
+static void tgui_line_index_move_gap(TGuiLineIndex *lines, u32 line, u32 text_size)
+{
+    // NOTE: entries that cross the gap need to change from absolute offset to offset from the end
+    while(line < lines->gap_start)
+    {
+        --lines->gap_start;
+        --lines->gap_end;
+        lines->buffer[lines->gap_end] = text_size - lines->buffer[lines->gap_start];
+    }
+    while(line > lines->gap_start)
+    {
+        lines->buffer[lines->gap_start] = text_size - lines->buffer[lines->gap_end];
+        ++lines->gap_start;
+        ++lines->gap_end;
+    }
+}
+
+static void tgui_line_index_reserve(TGuiLineIndex *lines, u32 count)
+{
+    u32 gap_size = lines->gap_end - lines->gap_start;
+    if(gap_size < count)
+    {
+        u32 new_buffer_size = lines->buffer_size * 2;
+        while(new_buffer_size - (lines->buffer_size - gap_size) < count)
+        {
+            new_buffer_size *= 2;
+        }
+        u32 after_gap_size = lines->buffer_size - lines->gap_end;
+        u32 *new_buffer = (u32 *)malloc(new_buffer_size*sizeof(u32));
+        TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, new_buffer_size*sizeof(u32));
+        memcpy(new_buffer, lines->buffer, lines->gap_start*sizeof(u32));
+        memcpy(new_buffer + new_buffer_size - after_gap_size, lines->buffer + lines->gap_end, after_gap_size*sizeof(u32));
+        free(lines->buffer);
+        lines->buffer = new_buffer;
+        lines->buffer_size = new_buffer_size;
+        lines->gap_end = new_buffer_size - after_gap_size;
+    }
+}
+
+void tgui_text_buffer_insert(TGuiTextBuffer *buffer, u32 offset, u8 *text, u32 text_size)
+{
+    ASSERT(offset <= tgui_text_buffer_size(buffer));
+    if(!text_size) return;
+    
+    // NOTE: put the lines gap after the line where the text is inserted
+    u32 line = tgui_text_buffer_find_line(buffer, offset);
+    tgui_line_index_move_gap(&buffer->lines, line + 1, tgui_text_buffer_size(buffer));
+    
+    tgui_gap_buffer_move_gap(&buffer->text, offset);
+    tgui_gap_buffer_reserve(&buffer->text, text_size);
+    memcpy(buffer->text.buffer + buffer->text.gap_start, text, text_size);
+    buffer->text.gap_start += text_size;
+
+    // NOTE: add the new lines, the lines after the gap are relative to the end so they are still valid
+    u8 *character = text;
+    u8 *last_character = text + text_size;
+    while((character = (u8 *)memchr(character, '\n', last_character - character)) != 0)
+    {
+        ++character;
+        tgui_line_index_reserve(&buffer->lines, 1);
+        buffer->lines.buffer[buffer->lines.gap_start++] = offset + (u32)(character - text);
+    }
+}
+
+void tgui_text_buffer_delete(TGuiTextBuffer *buffer, u32 start, u32 end)
+{
+    ASSERT(start <= end && end <= tgui_text_buffer_size(buffer));
+    if(start == end) return;
+
+    // NOTE: the lines that start inside the deleted range are just after the lines gap
+    u32 first_line = tgui_text_buffer_find_line(buffer, start);
+    u32 last_line = tgui_text_buffer_find_line(buffer, end);
+    tgui_line_index_move_gap(&buffer->lines, first_line + 1, tgui_text_buffer_size(buffer));
+    buffer->lines.gap_end += (last_line - first_line);
+
+    tgui_gap_buffer_move_gap(&buffer->text, start);
+    buffer->text.gap_end += (end - start);
+}
+
+void tgui_text_buffer_copy(TGuiTextBuffer *buffer, u32 start, u32 size, u8 *dst)
+{
+    TGuiGapBuffer *text = &buffer->text;
+    u32 end = start + size;
+    if(start < text->gap_start)
+    {
+        u32 before_gap_end = end < text->gap_start ? end : text->gap_start;
+        memcpy(dst, text->buffer + start, before_gap_end - start);
+        dst += before_gap_end - start;
+        start = before_gap_end;
+    }
+    if(start < end)
+    {
+        u32 gap_size = text->gap_end - text->gap_start;
+        memcpy(dst, text->buffer + start + gap_size, end - start);
+    }
+}
+
+u8 *tgui_text_buffer_get_text(TGuiTextBuffer *buffer, u32 start, u32 size, TGuiArena *arena)
+{
+    // NOTE: only the text that is split by the gap need to be copy
+    TGuiGapBuffer *text = &buffer->text;
+    if(start + size <= text->gap_start)
+    {
+        return text->buffer + start;
+    }
+    if(start >= text->gap_start)
+    {
+        return text->buffer + start + (text->gap_end - text->gap_start);
+    }
+    u8 *result = (u8 *)tgui_arena_push(arena, size);
+    tgui_text_buffer_copy(buffer, start, size, result);
+    return result;
+}
+
+static TGuiArenaBlock *tgui_arena_block_create(u64 size)
+{
+    TGuiArenaBlock *block = (TGuiArenaBlock *)malloc(sizeof(TGuiArenaBlock));
+    block->buffer_size = size;
+    block->buffer = (u8 *)malloc(block->buffer_size);
+    block->used = 0;
+    block->next = 0;
+    return block;
+}
+
+void tgui_arena_create(TGuiArena *arena)
+{
+    arena->first = tgui_arena_block_create(TGUI_DEFAULT_ARENA_BLOCK_SIZE);
+    arena->current = arena->first;
+}
+
+void tgui_arena_destroy(TGuiArena *arena)
+{
+    TGuiArenaBlock *block = arena->first;
+    while(block)
+    {
+        TGuiArenaBlock *next = block->next;
+        free(block->buffer);
+        free(block);
+        block = next;
+    }
+    arena->first = 0;
+    arena->current = 0;
+}
+
+void *tgui_arena_push(TGuiArena *arena, u64 size)
+{
+    // NOTE: keep every allocation 8 bytes aligned
+    size = (size + 7) & ~(u64)7;
+    TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, size);
+    TGuiArenaBlock *block = arena->current;
+    if(block->used + size > block->buffer_size)
+    {
+        // NOTE: blocks are never freed on clear, so try to reuse the next one first
+        TGuiArenaBlock *next = block->next;
+        if(next && size <= next->buffer_size)
+        {
+            next->used = 0;
+        }
+        else
+        {
+            u64 new_block_size = TGUI_DEFAULT_ARENA_BLOCK_SIZE;
+            if(size > new_block_size) new_block_size = size;
+            TGuiArenaBlock *new_block = tgui_arena_block_create(new_block_size);
+            new_block->next = block->next;
+            block->next = new_block;
+            next = new_block;
+        }
+        arena->current = next;
+        block = next;
+    }
+    void *result = block->buffer + block->used;
+    block->used += size;
+    return result;
+}
+
+void *tgui_arena_push_copy(TGuiArena *arena, void *data, u64 size)
+{
+    void *result = tgui_arena_push(arena, size);
+    memcpy(result, data, size);
+    return result;
+}
+
+void tgui_arena_clear(TGuiArena *arena)
+{
+    // NOTE: O(1) the rest of the blocks are reset when the arena reach them again
+    arena->current = arena->first;
+    arena->first->used = 0;
+}
+
+void tgui_draw_command_buffer_create(TGuiDrawCommandBuffer *buffer)
+{
+    buffer->head = 0;
+    buffer->count = 0;
+    tgui_arena_create(&buffer->arena);
+}
+
+void tgui_draw_command_buffer_destroy(TGuiDrawCommandBuffer *buffer)
+{
+    tgui_arena_destroy(&buffer->arena);
+    buffer->head = 0;
+    buffer->count = 0;
+}
+
+void tgui_draw_command_buffer_clear(TGuiDrawCommandBuffer *buffer)
+{
+    buffer->head = 0;
+    buffer->count = 0;
+    tgui_arena_clear(&buffer->arena);
+}
+
+// NOTE: move the commands of src to dst, the arenas are swap so the text is not copy. src is empty after it
+static void tgui_draw_command_buffer_move(TGuiDrawCommandBuffer *dst, TGuiDrawCommandBuffer *src)
+{
+    memcpy(dst->buffer, src->buffer, src->count*sizeof(TGuiDrawCommand));
+    dst->head = src->head;
+    dst->count = src->count;
+    dst->handle_count = src->handle_count;
+    dst->occlusion = src->occlusion;
+    TGuiArena arena = dst->arena;
+    dst->arena = src->arena;
+    src->arena = arena;
+    tgui_draw_command_buffer_clear(src);
+}
+
+// NOTE: the layers of the containers that are not in the frame are release, so a container that is free
+// or not cached any more dont keep its bitmap
+static void tgui_layer_cache_begin_frame(TGuiLayerCache *cache, TGuiDrawCommandBuffer *buffer)
+{
+    for(u32 layer_index = 0; layer_index < cache->count; ++layer_index)
+    {
+        cache->layers[layer_index].used = false;
+    }
+    for(u32 command_index = buffer->head; command_index < buffer->count; ++command_index)
+    {
+        TGuiDrawCommand *draw_cmd = buffer->buffer + command_index;
+        if(draw_cmd->type != TGUI_DRAWCMD_BEGIN_LAYER) continue;
+        for(u32 layer_index = 0; layer_index < cache->count; ++layer_index)
+        {
+            if(cache->layers[layer_index].handle == draw_cmd->handle) cache->layers[layer_index].used = true;
+        }
+    }
+    u32 count = 0;
+    for(u32 layer_index = 0; layer_index < cache->count; ++layer_index)
+    {
+        TGuiLayer *layer = cache->layers + layer_index;
+        if(layer->used)
+        {
+            cache->layers[count++] = *layer;
+        }
+        else
+        {
+            free(layer->bitmap.pixels);
+        }
+    }
+    cache->count = count;
+}
+
+static TGuiLayer *tgui_layer_cache_get(TGuiLayerCache *cache, TGuiHandle handle)
+{
+    for(u32 layer_index = 0; layer_index < cache->count; ++layer_index)
+    {
+        if(cache->layers[layer_index].handle == handle) return cache->layers + layer_index;
+    }
+    if(cache->count == cache->size)
+    {
+        u32 new_size = cache->size ? cache->size*2 : 8;
+        TGuiLayer *new_layers = (TGuiLayer *)malloc(new_size*sizeof(TGuiLayer));
+        if(cache->layers) memcpy(new_layers, cache->layers, cache->count*sizeof(TGuiLayer));
+        free(cache->layers);
+        cache->layers = new_layers;
+        cache->size = new_size;
+    }
+    TGuiLayer *layer = cache->layers + cache->count++;
+    memset(layer, 0, sizeof(TGuiLayer));
+    layer->handle = handle;
+    layer->used = true;
+    return layer;
+}
+
+static void tgui_layer_cache_destroy(TGuiLayerCache *cache)
+{
+    for(u32 layer_index = 0; layer_index < cache->count; ++layer_index)
+    {
+        free(cache->layers[layer_index].bitmap.pixels);
+    }
+    free(cache->layers);
+    memset(cache, 0, sizeof(TGuiLayerCache));
+}
+
+static u64 tgui_hash_bytes(u64 hash, void *data, u64 size)
+{
+    // NOTE: FNV-1a
+    u8 *bytes = (u8 *)data;
+    for(u64 index = 0; index < size; ++index)
+    {
+        hash ^= bytes[index];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// NOTE: the descriptor of this commands is not a position, they dont move with the widget
+inline static b32 tgui_draw_command_has_position(TGuiDrawCommandType type)
+{
+    return type != TGUI_DRAWCMD_CLEAR && type != TGUI_DRAWCMD_END_CLIPPING && type != TGUI_DRAWCMD_END_LAYER;
+}
+
+// NOTE: index of the END_LAYER that close the layer, or last_index if the layer is not close
+static u32 tgui_layer_end(TGuiDrawCommandBuffer *buffer, u32 begin_index, u32 last_index)
+{
+    u32 depth = 0;
+    for(u32 command_index = begin_index; command_index < last_index; ++command_index)
+    {
+        TGuiDrawCommandType type = buffer->buffer[command_index].type;
+        if(type == TGUI_DRAWCMD_BEGIN_LAYER) ++depth;
+        else if(type == TGUI_DRAWCMD_END_LAYER && --depth == 0) return command_index;
+    }
+    return last_index;
+}
+
+// NOTE: the pointer is the same when the app change the pixels, the version is hash too
+inline static u64 tgui_hash_bitmap(u64 hash, TGuiBitmap *bitmap)
+{
+    hash = tgui_hash_bytes(hash, &bitmap, sizeof(bitmap));
+    if(bitmap) hash = tgui_hash_bytes(hash, &bitmap->version, sizeof(bitmap->version));
+    return hash;
+}
+
+// NOTE: hash of everything that change the pixels of the command, the position is relative to (origin_x, origin_y)
+static u64 tgui_draw_command_hash(u64 hash, TGuiDrawCommand *draw_cmd, i32 origin_x, i32 origin_y)
+{
+    TGuiRect descriptor = draw_cmd->descriptor;
+    if(tgui_draw_command_has_position(draw_cmd->type))
+    {
+        descriptor.x -= origin_x;
+        descriptor.y -= origin_y;
+    }
+    hash = tgui_hash_bytes(hash, &draw_cmd->type, sizeof(draw_cmd->type));
+    hash = tgui_hash_bytes(hash, &descriptor, sizeof(descriptor));
+    hash = tgui_hash_bitmap(hash, draw_cmd->bitmap);
+    hash = tgui_hash_bytes(hash, &draw_cmd->ratio, sizeof(draw_cmd->ratio));
+    hash = tgui_hash_bytes(hash, &draw_cmd->color, sizeof(draw_cmd->color));
+    hash = tgui_hash_bytes(hash, &draw_cmd->character, sizeof(draw_cmd->character));
+    if(draw_cmd->text)
+    {
+        hash = tgui_hash_bytes(hash, &draw_cmd->text_size, sizeof(draw_cmd->text_size));
+        hash = tgui_hash_bytes(hash, draw_cmd->text, draw_cmd->text_size);
+    }
+    return hash;
+}
+
+// NOTE: hash of everything that change the pixels of the commands, if two frames have
+// the same hash there is no need to draw the second one
+u64 tgui_draw_command_buffer_hash(TGuiDrawCommandBuffer *buffer)
+{
+    u64 hash = 0xCBF29CE484222325ull;
+    for(u32 command_index = buffer->head; command_index < buffer->count; ++command_index)
+    {
+        hash = tgui_draw_command_hash(hash, buffer->buffer + command_index, 0, 0);
+    }
+    return hash;
+}
+
+void tgui_widget_poll_allocator_create(TGuiWidgetPoolAllocator *allocator)
+{
+    allocator->buffer_size = TGUI_DEFAULT_POOL_SIZE;
+    allocator->buffer = (TGuiWidget *)malloc(allocator->buffer_size*sizeof(TGuiWidget));
+    // NOTE: because 0 is a INVALID HANDLE the first element in the pool is reserved
+    allocator->count = 1;
+    allocator->free_list = 0;
+}
+
+void tgui_widget_allocator_destroy(TGuiWidgetPoolAllocator *allocator)
+{
+    free(allocator->buffer);
+    allocator->buffer_size = 0;
+    allocator->count = 0;
+    allocator->free_list = 0;
+}
+
+TGuiHandle tgui_widget_allocator_pool(TGuiWidgetPoolAllocator *allocator)
+{
+    TGuiHandle handle = TGUI_INVALID_HANDLE;
+    if(allocator->free_list)
+    {
+        handle = allocator->free_list->handle;
+        allocator->free_list = allocator->free_list->next;
+        return handle;
+    }
+    
+    handle = allocator->count++;
+    if(handle >= allocator->buffer_size)
+    {
+        // NOTE: this is a dynamic pool allocator need to be reallocated here!
+        u32 new_buffer_size = allocator->buffer_size * 2;
+        TGuiWidget *new_buffer = (TGuiWidget *)malloc(new_buffer_size*sizeof(TGuiWidget));
+        TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, new_buffer_size*sizeof(TGuiWidget));
+        memcpy(new_buffer, allocator->buffer, allocator->buffer_size*sizeof(TGuiWidget));
+        free(allocator->buffer);
+        allocator->buffer = new_buffer;
+        allocator->buffer_size = new_buffer_size;
+    }
+    return handle;
+}
+
+static void tgui_widget_release_resources(TGuiWidget *widget)
+{
+    if(widget->header.type == TGUI_TEXTBOX)
+    {
+        tgui_text_buffer_destroy(&widget->textbox.text);
+    }
+    if(widget->header.type == TGUI_TEXTVIEW)
+    {
+        tgui_textview_destroy(&widget->textview);
+    }
+    if(widget->header.type == TGUI_PLOT)
+    {
+        tgui_plot_destroy(&widget->plot);
+    }
+    if(widget->header.type == TGUI_GRID)
+    {
+        tgui_grid_destroy(&widget->grid);
+    }
+    if(widget->header.type == TGUI_TREE)
+    {
+        tgui_tree_destroy(&widget->tree);
+    }
+    if(widget->header.type >= TGUI_COUNT)
+    {
+        TGuiWidgetClass *widget_class = tgui_widget_class(widget->header.type);
+        if(widget_class->release) widget_class->release(widget);
+    }
+}
+
+void tgui_widget_allocator_free(TGuiWidgetPoolAllocator *allocator, TGuiHandle *handle)
+{
+    ASSERT(*handle != TGUI_INVALID_HANDLE);
+    tgui_widget_release_resources(tgui_widget_get(*handle));
+    tgui_layout_changed();
+
+    TGuiWidgetFree *free_widget = (TGuiWidgetFree *)(allocator->buffer + *handle);
+    free_widget->handle = *handle;
+    free_widget->next = allocator->free_list;
+    allocator->free_list = free_widget;
+    *handle = TGUI_INVALID_HANDLE;
+}
+
+void tgui_widget_set(TGuiHandle handle, TGuiWidget widget)
+{
+    ASSERT(handle != TGUI_INVALID_HANDLE);
+    TGuiState *state = &tgui_global_state;
+    state->widget_allocator.buffer[handle] = widget;
+    tgui_layout_changed();
+}
+
+TGuiWidget *tgui_widget_get(TGuiHandle handle)
+{
+    TGuiWidget *result = 0;
+    if(handle != TGUI_INVALID_HANDLE)
+    {
+        TGuiState *state = &tgui_global_state;
+        result = state->widget_allocator.buffer + handle;
+    }
+    return result;
+}
+
+//-----------------------------------------------------
+//  NOTE: snapshot functions
+//-----------------------------------------------------
+
+typedef struct TGuiSnapshotWriter
+{
+    u8 *buffer;
+    u64 buffer_size;
+    u64 size;
+} TGuiSnapshotWriter;
+
+typedef struct TGuiSnapshotReader
+{
+    u8 *data;
+    u64 size;
+    u64 offset;
+} TGuiSnapshotReader;
+
+// NOTE: space for size bytes after the data, it is not add to the size until it is write
+static u8 *tgui_snapshot_reserve(TGuiSnapshotWriter *writer, u64 size)
+{
+    if(writer->size + size > writer->buffer_size)
+    {
+        u64 new_buffer_size = writer->buffer_size * 2;
+        while(writer->size + size > new_buffer_size) new_buffer_size *= 2;
+        u8 *new_buffer = (u8 *)malloc(new_buffer_size);
+        memcpy(new_buffer, writer->buffer, writer->size);
+        free(writer->buffer);
+        writer->buffer = new_buffer;
+        writer->buffer_size = new_buffer_size;
+    }
+    return writer->buffer + writer->size;
+}
+
+static void tgui_snapshot_write(TGuiSnapshotWriter *writer, void *data, u64 size)
+{
+    memcpy(tgui_snapshot_reserve(writer, size), data, size);
+    writer->size += size;
+}
+
+static void *tgui_snapshot_read(TGuiSnapshotReader *reader, u64 size)
+{
+    if(size > reader->size - reader->offset) return 0;
+    void *result = reader->data + reader->offset;
+    reader->offset += size;
+    return result;
+}
+
+// NOTE: the data after a label is not aligned, so the values are copy out
+static b32 tgui_snapshot_read_u32(TGuiSnapshotReader *reader, u32 *value)
+{
+    void *data = tgui_snapshot_read(reader, sizeof(u32));
+    if(data) memcpy(value, data, sizeof(u32));
+    return data != 0;
+}
+
+// NOTE: the custom widgets store the header and the pointer, its data is write by the save of its class.
+// The types that are not register have size 0
+static u32 tgui_widget_type_size(TGuiWidgetType type)
+{
+    switch(type)
+    {
+#define TGUI_WIDGET_TYPE_SIZE(type, name, type_struct) case type: return sizeof(type_struct);
+        TGUI_WIDGET_TYPES(TGUI_WIDGET_TYPE_SIZE)
+#undef TGUI_WIDGET_TYPE_SIZE
+        default: break;
+    }
+    if(type >= TGUI_COUNT && (u32)type - TGUI_COUNT < tgui_global_state.registry.class_count)
+    {
+        return sizeof(TGuiWidgetCustom);
+    }
+    return 0;
+}
+
+// NOTE: the data of a custom widget is its size and the bytes of the save of the class
+static b32 tgui_snapshot_write_custom(TGuiSnapshotWriter *writer, TGuiWidget *widget)
+{
+    TGuiWidgetClass *widget_class = tgui_widget_class(widget->header.type);
+    if(!widget_class->save || !widget_class->restore) return false;
+    u32 size = widget_class->save(widget, 0, 0);
+    u8 *buffer = tgui_snapshot_reserve(writer, sizeof(u32) + size);
+    u32 saved_size = widget_class->save(widget, buffer + sizeof(u32), size);
+    if(saved_size > size) return false;
+    memcpy(buffer, &saved_size, sizeof(u32));
+    writer->size += sizeof(u32) + saved_size;
+    return true;
+}
+
+// NOTE: the free widgets dont have a valid header, so walk the free list and mark them
+static u8 *tgui_widget_allocator_free_map(TGuiWidgetPoolAllocator *allocator, u32 *free_count)
+{
+    u8 *free_map = (u8 *)malloc(allocator->count);
+    memset(free_map, 0, allocator->count);
+    free_map[TGUI_INVALID_HANDLE] = true;
+    *free_count = 0;
+    for(TGuiWidgetFree *free_widget = allocator->free_list; free_widget; free_widget = free_widget->next)
+    {
+        free_map[free_widget->handle] = true;
+        ++(*free_count);
+    }
+    return free_map;
+}
+
+static void tgui_snapshot_write_string(TGuiSnapshotWriter *writer, char *text)
+{
+    u32 text_size = text ? (u32)strlen(text) : 0;
+    tgui_snapshot_write(writer, &text_size, sizeof(u32));
+    tgui_snapshot_write(writer, text, text_size);
+}
+
+static char *tgui_snapshot_read_string(TGuiSnapshotReader *reader, TGuiArena *arena, u32 *text_size)
+{
+    u32 size = 0;
+    if(!tgui_snapshot_read_u32(reader, &size)) return 0;
+    u8 *text = (u8 *)tgui_snapshot_read(reader, size);
+    if(!text) return 0;
+    char *result = (char *)tgui_arena_push(arena, size + 1);
+    memcpy(result, text, size);
+    result[size] = '\0';
+    *text_size = size;
+    return result;
+}
+
+// NOTE: the layout is the pool in handle order, only the live widgets are store and every
+// widget only use the size of its type. Pointers are not store, the textbox text, the labels,
+// the textview path and the data of the custom widgets are write after the widget that own them.
+// The samples of a plot, the columns of a grid and the nodes of a tree are not store
+//
+//  TGuiSnapshotHeader
+//  TGuiHandle free_handles[free_count]
+//  for each live widget: widget struct | out of line data
+TGuiSnapshot tgui_snapshot_save(void)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiWidgetPoolAllocator *allocator = &state->widget_allocator;
+    
+    TGuiSnapshotWriter writer = {0};
+    writer.buffer_size = sizeof(TGuiSnapshotHeader) + allocator->count*sizeof(TGuiWidget);
+    writer.buffer = (u8 *)malloc(writer.buffer_size);
+    
+    TGuiSnapshotHeader header = {0};
+    header.magic = TGUI_SNAPSHOT_MAGIC;
+    header.version = TGUI_SNAPSHOT_VERSION;
+    header.widget_size = sizeof(TGuiWidget);
+    header.widget_count = allocator->count;
+    header.first_root = state->first_root;
+    header.last_root = state->last_root;
+    header.widget_active = state->widget_active;
+    u8 *free_map = tgui_widget_allocator_free_map(allocator, &header.free_count);
+    tgui_snapshot_write(&writer, &header, sizeof(TGuiSnapshotHeader));
+    
+    for(TGuiWidgetFree *free_widget = allocator->free_list; free_widget; free_widget = free_widget->next)
+    {
+        tgui_snapshot_write(&writer, &free_widget->handle, sizeof(TGuiHandle));
+    }
+
+    TGuiArena *arena = &state->draw_command_buffer.arena;
+    b32 valid = true;
+    for(TGuiHandle handle = 1; valid && handle < allocator->count; ++handle)
+    {
+        if(free_map[handle]) continue;
+        TGuiWidget *widget = allocator->buffer + handle;
+        tgui_snapshot_write(&writer, widget, tgui_widget_type_size(widget->header.type));
+        if(widget->header.type >= TGUI_COUNT)
+        {
+            valid = tgui_snapshot_write_custom(&writer, widget);
+            continue;
+        }
+        switch(widget->header.type)
+        {
+            case TGUI_BUTTON:
+            {
+                tgui_snapshot_write_string(&writer, widget->button.text.text);
+            } break;
+            case TGUI_CHECKBOX:
+            {
+                tgui_snapshot_write_string(&writer, widget->checkbox.text.text);
+            } break;
+            case TGUI_TEXTBOX:
+            {
+                TGuiTextBuffer *text = &widget->textbox.text;
+                u32 text_size = tgui_text_buffer_size(text);
+                tgui_snapshot_write(&writer, &text_size, sizeof(u32));
+                // NOTE: close the gap into the frame arena, it is release at the start of the next frame
+                u8 *data = tgui_text_buffer_get_text(text, 0, text_size, arena);
+                tgui_snapshot_write(&writer, data, text_size);
+            } break;
+            case TGUI_TEXTVIEW:
+            {
+                tgui_snapshot_write_string(&writer, widget->textview.path);
+            } break;
+            default: break;
+        }
+    }
+    free(free_map);
+    
+    TGuiSnapshot result = {0};
+    if(!valid)
+    {
+        free(writer.buffer);
+        return result;
+    }
+    ((TGuiSnapshotHeader *)writer.buffer)->data_size = writer.size;
+
+    result.data = writer.buffer;
+    result.size = writer.size;
+    return result;
+}
+
+void tgui_snapshot_free(TGuiSnapshot *snapshot)
+{
+    free(snapshot->data);
+    snapshot->data = 0;
+    snapshot->size = 0;
+}
+
+// NOTE: restore the pool in one pass, the position and size of the widgets are the ones
+// in the snapshot, so no layout is done. If the snapshot is not valid the current tree is not touch
+b32 tgui_snapshot_restore(TGuiSnapshot snapshot)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiSnapshotReader reader = {0};
+    reader.data = snapshot.data;
+    reader.size = snapshot.size;
+    
+    TGuiSnapshotHeader *header = (TGuiSnapshotHeader *)tgui_snapshot_read(&reader, sizeof(TGuiSnapshotHeader));
+    if(!header ||
+       header->magic != TGUI_SNAPSHOT_MAGIC ||
+       header->version != TGUI_SNAPSHOT_VERSION ||
+       header->widget_size != sizeof(TGuiWidget) ||
+       header->data_size != snapshot.size ||
+       header->widget_count == 0 ||
+       header->free_count >= header->widget_count ||
+       header->first_root >= header->widget_count ||
+       header->last_root >= header->widget_count ||
+       header->widget_active >= header->widget_count)
+    {
+        return false;
+    }
+    
+    TGuiHandle *free_handles = (TGuiHandle *)tgui_snapshot_read(&reader, header->free_count*sizeof(TGuiHandle));
+    if(!free_handles) return false;
+
+    TGuiWidgetPoolAllocator allocator;
+    allocator.buffer_size = TGUI_DEFAULT_POOL_SIZE;
+    while(allocator.buffer_size < header->widget_count) allocator.buffer_size *= 2;
+    allocator.buffer = (TGuiWidget *)malloc(allocator.buffer_size*sizeof(TGuiWidget));
+    memset(allocator.buffer, 0, header->widget_count*sizeof(TGuiWidget));
+    allocator.count = header->widget_count;
+    allocator.free_list = 0;
+    
+    // NOTE: keep the order of the free list, so the next handles are the same as in the saved tree
+    u8 *free_map = (u8 *)malloc(allocator.count);
+    memset(free_map, 0, allocator.count);
+    free_map[TGUI_INVALID_HANDLE] = true;
+    b32 valid = true;
+    TGuiWidgetFree **free_tail = &allocator.free_list;
+    for(u32 free_index = 0; free_index < header->free_count; ++free_index)
+    {
+        TGuiHandle handle = free_handles[free_index];
+        if(handle == TGUI_INVALID_HANDLE || handle >= allocator.count || free_map[handle])
+        {
+            valid = false;
+            break;
+        }
+        free_map[handle] = true;
+        TGuiWidgetFree *free_widget = (TGuiWidgetFree *)(allocator.buffer + handle);
+        free_widget->handle = handle;
+        *free_tail = free_widget;
+        free_tail = &free_widget->next;
+    }
+
+    TGuiArena strings;
+    tgui_arena_create(&strings);
+    TGuiHandle handle = 1;
+    for(; valid && handle < allocator.count; ++handle)
+    {
+        if(free_map[handle]) continue;
+        TGuiWidget *widget = allocator.buffer + handle;
+        TGuiWidgetHeader widget_header;
+        u32 widget_size = 0;
+        if(reader.size - reader.offset >= sizeof(TGuiWidgetHeader))
+        {
+            memcpy(&widget_header, reader.data + reader.offset, sizeof(TGuiWidgetHeader));
+            if(widget_header.handle == handle) widget_size = tgui_widget_type_size(widget_header.type);
+        }
+        void *data = widget_size ? tgui_snapshot_read(&reader, widget_size) : 0;
+        if(!data)
+        {
+            valid = false;
+            break;
+        }
+        memcpy(widget, data, widget_size);
+        
+        TGuiWidgetHeader *links = &widget->header;
+        if(links->parent >= allocator.count || links->child_first >= allocator.count ||
+           links->child_last >= allocator.count || links->sibling_next >= allocator.count ||
+           links->sibling_prev >= allocator.count)
+        {
+            // NOTE: the type is change so the release below dont touch the invalid pointers
+            widget->header.type = TGUI_END_CONTAINER;
+            valid = false;
+            break;
+        }
+
+        u32 text_size = 0;
+        switch(widget->header.type)
+        {
+            case TGUI_BUTTON:
+            {
+                widget->button.text.text = tgui_snapshot_read_string(&reader, &strings, &text_size);
+                valid = widget->button.text.text != 0;
+            } break;
+            case TGUI_CHECKBOX:
+            {
+                widget->checkbox.text.text = tgui_snapshot_read_string(&reader, &strings, &text_size);
+                valid = widget->checkbox.text.text != 0;
+            } break;
+            case TGUI_TEXTBOX:
+            {
+                tgui_text_buffer_create(&widget->textbox.text);
+                u8 *text = 0;
+                if(tgui_snapshot_read_u32(&reader, &text_size))
+                {
+                    text = (u8 *)tgui_snapshot_read(&reader, text_size);
+                }
+                if(text)
+                {
+                    tgui_text_buffer_insert(&widget->textbox.text, 0, text, text_size);
+                }
+                valid = text != 0;
+            } break;
+            case TGUI_TEXTVIEW:
+            {
+                TGuiWidgetTextView *textview = &widget->textview;
+                textview->path = 0;
+                textview->index = 0;
+                textview->index_thread = 0;
+                memset(&textview->file, 0, sizeof(TGuiMappedFile));
+                char *path = tgui_snapshot_read_string(&reader, &strings, &text_size);
+                if(path)
+                {
+                    tgui_textview_open(textview, path);
+                }
+                else
+                {
+                    widget->header.type = TGUI_END_CONTAINER;
+                    valid = false;
+                }
+            } break;
+            case TGUI_PLOT:
+            {
+                // NOTE: the samples are of the application, the plot is empty until it is bind again
+                TGuiWidgetPlot *plot = &widget->plot;
+                plot->samples = 0;
+                plot->capacity = 0;
+                plot->sample_count = 0;
+                plot->cache = 0;
+            } break;
+            case TGUI_GRID:
+            {
+                // NOTE: the columns are of the application too
+                widget->grid.data = 0;
+                widget->grid.row_count = 0;
+                widget->grid.scroll_row = 0;
+                widget->grid.scroll_column = 0;
+            } break;
+            case TGUI_TREE:
+            {
+                // NOTE: and the nodes of the tree, it is empty until it is bind again
+                widget->tree.data = 0;
+                widget->tree.scroll_row = 0;
+                widget->tree.hot_row = TGUI_TREE_NONE;
+            } break;
+            default: break;
+        }
+        if(widget->header.type >= TGUI_COUNT)
+        {
+            // NOTE: the type size is only valid for the types that are register
+            u32 data_size = 0;
+            void *data = 0;
+            if(tgui_snapshot_read_u32(&reader, &data_size)) data = tgui_snapshot_read(&reader, data_size);
+            TGuiWidgetClass *widget_class = tgui_widget_class(widget->header.type);
+            widget->custom.data = 0;
+            if(!data || !widget_class->restore || !widget_class->restore(widget, data, data_size))
+            {
+                widget->header.type = TGUI_END_CONTAINER;
+                valid = false;
+            }
+        }
+    }
+    if(valid && reader.offset != reader.size) valid = false;
+    
+    if(!valid)
+    {
+        // NOTE: release everything that was created before the error
+        TGuiHandle last_handle = handle < allocator.count ? handle + 1 : allocator.count;
+        for(TGuiHandle release_handle = 1; release_handle < last_handle; ++release_handle)
+        {
+            if(!free_map[release_handle]) tgui_widget_release_resources(allocator.buffer + release_handle);
+        }
+        tgui_arena_destroy(&strings);
+        free(allocator.buffer);
+        free(free_map);
+        return false;
+    }
+    free(free_map);
+    
+    // NOTE: release the current tree and replace it
+    u32 free_count = 0;
+    free_map = tgui_widget_allocator_free_map(&state->widget_allocator, &free_count);
+    for(TGuiHandle release_handle = 1; release_handle < state->widget_allocator.count; ++release_handle)
+    {
+        if(!free_map[release_handle]) tgui_widget_release_resources(state->widget_allocator.buffer + release_handle);
+    }
+    free(free_map);
+    tgui_widget_allocator_destroy(&state->widget_allocator);
+    tgui_arena_destroy(&state->snapshot_strings);
+    
+    state->widget_allocator = allocator;
+    state->snapshot_strings = strings;
+    state->first_root = header->first_root;
+    state->last_root = header->last_root;
+    state->widget_active = header->widget_active;
+    tgui_layout_changed();
+    
+    return true;
+}
+
+//-----------------------------------------------------
+//  NOTE: record functions
+//-----------------------------------------------------
+
+static void tgui_record_write(TGuiRecorder *recorder, void *data, u64 size)
+{
+    fwrite(data, 1, size, (FILE *)recorder->file);
+}
+
+static void tgui_record_write_u32(TGuiRecorder *recorder, u32 value)
+{
+    tgui_record_write(recorder, &value, sizeof(u32));
+}
+
+static u32 tgui_record_bitmap_id(TGuiRecorder *recorder, TGuiBitmap *bitmap)
+{
+    if(!bitmap) return 0;
+    for(u32 bitmap_index = 0; bitmap_index < recorder->bitmap_count; ++bitmap_index)
+    {
+        if(recorder->bitmaps[bitmap_index] == bitmap) return bitmap_index + 1;
+    }
+    // TODO: create a log to print errors
+    if(recorder->bitmap_count >= TGUI_TRACE_MAX_BITMAPS) return 0;
+    
+    // NOTE: the bitmap is identify by its pointer, the pixels are write the first time is used
+    recorder->bitmaps[recorder->bitmap_count++] = bitmap;
+    u32 id = recorder->bitmap_count;
+    tgui_record_write_u32(recorder, TGUI_TRACE_BITMAP);
+    tgui_record_write_u32(recorder, id);
+    tgui_record_write_u32(recorder, bitmap->width);
+    tgui_record_write_u32(recorder, bitmap->height);
+    u8 *row = (u8 *)bitmap->pixels;
+    for(u32 y = 0; y < bitmap->height; ++y)
+    {
+        tgui_record_write(recorder, row, bitmap->width*sizeof(u32));
+        row += bitmap->pitch;
+    }
+    return id;
+}
+
+static void tgui_record_commands(TGuiRecorder *recorder, TGuiDrawCommandBuffer *buffer)
+{
+    // NOTE: the bitmap chunks need to be before the commands that use them
+    for(u32 command_index = 0; command_index < buffer->count; ++command_index)
+    {
+        tgui_record_bitmap_id(recorder, buffer->buffer[command_index].bitmap);
+    }
+    u32 host_count = buffer->count > recorder->update_count ? buffer->count - recorder->update_count : 0;
+    tgui_record_write_u32(recorder, TGUI_TRACE_COMMANDS);
+    tgui_record_write_u32(recorder, buffer->count);
+    tgui_record_write_u32(recorder, host_count);
+    for(u32 command_index = 0; command_index < buffer->count; ++command_index)
+    {
+        TGuiDrawCommand *draw_cmd = buffer->buffer + command_index;
+        TGuiTraceCommand command = {0};
+        command.type = draw_cmd->type;
+        command.descriptor = draw_cmd->descriptor;
+        command.ratio = draw_cmd->ratio;
+        command.color = draw_cmd->color;
+        command.character = draw_cmd->character;
+        command.text_size = draw_cmd->text ? draw_cmd->text_size : 0;
+        command.bitmap_id = tgui_record_bitmap_id(recorder, draw_cmd->bitmap);
+        tgui_record_write(recorder, &command, sizeof(TGuiTraceCommand));
+        tgui_record_write(recorder, draw_cmd->text, command.text_size);
+    }
+}
+
+// NOTE: called at the start of tgui_update, before the events are process
+static void tgui_record_frame(TGuiState *state)
+{
+    TGuiRecorder *recorder = &state->recorder;
+    if(recorder->frame_open)
+    {
+        tgui_record_commands(recorder, &state->draw_command_buffer);
+    }
+    tgui_record_write_u32(recorder, TGUI_TRACE_EVENTS);
+    tgui_record_write(recorder, &state->time, sizeof(f64));
+    tgui_record_write_u32(recorder, state->event_queue.count);
+    tgui_record_write(recorder, state->event_queue.queue, state->event_queue.count*sizeof(TGuiEvent));
+    recorder->frame_open = true;
+}
+
+b32 tgui_record_begin(char *path)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiRecorder *recorder = &state->recorder;
+    if(recorder->file) tgui_record_end();
+
+    FILE *file = fopen(path, "wb");
+    if(!file) return false;
+    memset(recorder, 0, sizeof(TGuiRecorder));
+    recorder->file = file;
+
+    TGuiSnapshot snapshot = tgui_snapshot_save();
+    if(!snapshot.data)
+    {
+        fclose(file);
+        recorder->file = 0;
+        return false;
+    }
+    TGuiTraceHeader header = {0};
+    header.magic = TGUI_TRACE_MAGIC;
+    header.version = TGUI_TRACE_VERSION;
+    header.backbuffer_width = state->backbuffer->width;
+    header.backbuffer_height = state->backbuffer->height;
+    header.mouse_x = state->mouse_x;
+    header.mouse_y = state->mouse_y;
+    header.mouse_is_down = state->mouse_is_down;
+    header.snapshot_size = (u32)snapshot.size;
+    header.optimizer = state->optimizer.enabled;
+    tgui_record_write(recorder, &header, sizeof(TGuiTraceHeader));
+    tgui_record_write(recorder, snapshot.data, snapshot.size);
+    tgui_snapshot_free(&snapshot);
+    return true;
+}
+
+void tgui_record_end(void)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiRecorder *recorder = &state->recorder;
+    if(!recorder->file) return;
+    if(recorder->frame_open)
+    {
+        tgui_record_commands(recorder, &state->draw_command_buffer);
+    }
+    fclose((FILE *)recorder->file);
+    memset(recorder, 0, sizeof(TGuiRecorder));
+}
+
+//-----------------------------------------------------
+//  NOTE: profile functions
+//-----------------------------------------------------
+
+// NOTE: the lock of the pipeline protect what the render thread publish at the end of its frames
+static void tgui_pipeline_lock(TGuiState *state)
+{
+    if(state->pipeline.thread) tgui_platform_sync_lock(state->pipeline.sync);
+}
+
+static void tgui_pipeline_unlock(TGuiState *state)
+{
+    if(state->pipeline.thread) tgui_platform_sync_unlock(state->pipeline.sync);
+}
+
+#if defined(TGUI_PROFILE)
+static void tgui_frame_stats_add(TGuiFrameStats *stats, TGuiFrameStats *other)
+{
+    for(u32 timer = 0; timer < TGUI_TIMER_COUNT; ++timer) stats->timers[timer] += other->timers[timer];
+    for(u32 type = 0; type < TGUI_DRAWCMD_COUNT; ++type) stats->kernels[type] += other->kernels[type];
+    for(u32 counter = 0; counter < TGUI_COUNTER_COUNT; ++counter) stats->counters[counter] += other->counters[counter];
+}
+
+// NOTE: the raster stats are from the frames that the rasterizer finish since the last update
+static void tgui_profile_next_frame(TGuiState *state)
+{
+    TGuiProfile *profile = &state->profile;
+    f64 now = tgui_platform_get_time();
+    if(profile->frame_start > 0)
+    {
+        profile->current.frame_ms = (now - profile->frame_start)*1000.0;
+    }
+    tgui_pipeline_lock(state);
+    tgui_frame_stats_add(&profile->current, &profile->raster_done);
+    memset(&profile->raster_done, 0, sizeof(TGuiFrameStats));
+    tgui_pipeline_unlock(state);
+    profile->last = profile->current;
+    memset(&profile->current, 0, sizeof(TGuiFrameStats));
+    profile->frame_start = now;
+}
+
+static char *tgui_profile_timer_names[TGUI_TIMER_COUNT] = {"events", "layout", "update", "render", "raster", "present"};
+static char *tgui_profile_counter_names[TGUI_COUNTER_COUNT] = {"widgets", "hit tests", "pixels", "clip pushes", "bytes alloc", "dropped events", "dropped cmds", "layer redraws", "culled cmds", "optimized cmds"};
+static char *tgui_draw_command_names[TGUI_DRAWCMD_COUNT] = {"clear", "clip", "end clip", "rect", "rounded rect", "bitmap", "text", "char", "layer", "end layer", "spans"};
+
+static void tgui_profile_push_line(i32 x, i32 *y, char *text, i32 text_size)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiDrawCommand draw_cmd = {0};
+    draw_cmd.type = TGUI_DRAWCMD_TEXT;
+    draw_cmd.descriptor = tgui_rect_xywh(x, *y, 0, state->font_height);
+    draw_cmd.text = text;
+    draw_cmd.text_size = text_size > 0 ? (u32)text_size : 0;
+    tgui_push_draw_command(draw_cmd);
+    *y += state->font_height + 2;
+}
+#endif
+
+#if defined(TGUI_PROFILE)
+void tgui_profile_end(char *name, f64 *stat, f64 start)
+{
+    TGuiState *state = &tgui_global_state;
+    f64 end = tgui_platform_get_time();
+    *stat += (end - start)*1000.0;
+    if(state->timeline.file)
+    {
+        tgui_timeline_push(name, start, TGUI_INVALID_HANDLE, 0);
+    }
+}
+
+// NOTE: only the thread that raster push here, so the count is not atomic
+static void tgui_timeline_push_raster(char *name, f64 start, TGuiHandle handle, u32 commands)
+{
+    TGuiTimeline *timeline = &tgui_global_state.timeline;
+    if(timeline->raster_span_count >= TGUI_TIMELINE_MAX_SPANS)
+    {
+        __atomic_fetch_add(&timeline->dropped_spans, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    TGuiTimelineSpan *span = timeline->raster_spans + timeline->raster_span_count++;
+    span->name = name;
+    span->start = start;
+    span->end = tgui_platform_get_time();
+    span->thread_id = tgui_platform_thread_id();
+    span->handle = handle;
+    span->commands = commands;
+}
+
+void tgui_raster_profile_end(char *name, f64 *stat, f64 start)
+{
+    TGuiState *state = &tgui_global_state;
+    f64 end = tgui_platform_get_time();
+    *stat += (end - start)*1000.0;
+    if(state->timeline.file)
+    {
+        tgui_timeline_push_raster(name, start, TGUI_INVALID_HANDLE, 0);
+    }
+}
+
+void tgui_timeline_push(char *name, f64 start, TGuiHandle handle, u32 commands)
+{
+    TGuiTimeline *timeline = &tgui_global_state.timeline;
+    f64 end = tgui_platform_get_time();
+    u32 index = __atomic_fetch_add(&timeline->span_count, 1, __ATOMIC_RELAXED);
+    if(index >= TGUI_TIMELINE_MAX_SPANS)
+    {
+        __atomic_fetch_add(&timeline->dropped_spans, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    TGuiTimelineSpan *span = timeline->spans + index;
+    span->name = name;
+    span->start = start;
+    span->end = end;
+    span->thread_id = tgui_platform_thread_id();
+    span->handle = handle;
+    span->commands = commands;
+}
+
+static b32 tgui_widget_update_span(TGuiHandle handle)
+{
+    TGUI_SPAN_BEGIN(widget_update);
+    b32 result = tgui_widget_update(handle);
+    TGUI_SPAN_END(widget_update, handle, 0);
+    return result;
+}
+
+static b32 tgui_widget_render_span(TGuiHandle handle)
+{
+    TGuiDrawCommandBuffer *buffer = &tgui_global_state.draw_command_buffer;
+    u32 command_count = buffer->count;
+    TGUI_SPAN_BEGIN(widget_render);
+    b32 result = tgui_widget_render(handle);
+    TGUI_SPAN_END(widget_render, handle, buffer->count - command_count);
+    return result;
+}
+
+// NOTE: the commands between two clipping changes are a raster batch in the timeline
+typedef struct TGuiTimelineBatch
+{
+    f64 start;
+    u32 count;
+} TGuiTimelineBatch;
+
+static void tgui_timeline_raster_batch(TGuiTimelineBatch *batch, TGuiDrawCommand *draw_cmd)
+{
+    b32 clipping = draw_cmd && (draw_cmd->type == TGUI_DRAWCMD_START_CLIPPING || draw_cmd->type == TGUI_DRAWCMD_END_CLIPPING);
+    if(batch->count && (!draw_cmd || clipping))
+    {
+        tgui_timeline_push_raster("raster_batch", batch->start, TGUI_INVALID_HANDLE, batch->count);
+        batch->count = 0;
+    }
+    if(draw_cmd)
+    {
+        if(batch->count == 0) batch->start = tgui_platform_get_time();
+        ++batch->count;
+    }
+}
+
+static void tgui_timeline_write_span(TGuiTimeline *timeline, TGuiTimelineSpan *span)
+{
+    FILE *file = (FILE *)timeline->file;
+    // NOTE: chrome trace times are in microseconds
+    fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"tgui\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"frame\":%u",
+            timeline->first_event ? "" : ",\n", span->name,
+            (span->start - timeline->start_time)*1000000.0, (span->end - span->start)*1000000.0,
+            span->thread_id, timeline->frame);
+    if(span->handle) fprintf(file, ",\"handle\":%u", span->handle);
+    if(span->commands) fprintf(file, ",\"commands\":%u", span->commands);
+    fprintf(file, "}}");
+    timeline->first_event = false;
+}
+
+static void tgui_timeline_flush(TGuiState *state)
+{
+    TGuiTimeline *timeline = &state->timeline;
+    f64 now = tgui_platform_get_time();
+    TGuiTimelineSpan frame = {0};
+    frame.name = "frame";
+    frame.start = timeline->frame_start;
+    frame.end = now;
+    frame.thread_id = tgui_platform_thread_id();
+    tgui_timeline_write_span(timeline, &frame);
+
+    // NOTE: the threads of the update are finish, the count is take and reset in one step
+    u32 span_count = __atomic_exchange_n(&timeline->span_count, 0, __ATOMIC_ACQ_REL);
+    if(span_count > TGUI_TIMELINE_MAX_SPANS) span_count = TGUI_TIMELINE_MAX_SPANS;
+    for(u32 span_index = 0; span_index < span_count; ++span_index)
+    {
+        tgui_timeline_write_span(timeline, timeline->spans + span_index);
+    }
+
+    // NOTE: the spans of the rasterizer are write out of the lock, the render thread can publish more meanwhile
+    tgui_pipeline_lock(state);
+    TGuiTimelineSpan *raster_spans = timeline->done_spans;
+    u32 raster_span_count = timeline->done_span_count;
+    timeline->done_spans = timeline->flush_spans;
+    timeline->done_span_count = 0;
+    timeline->flush_spans = raster_spans;
+    tgui_pipeline_unlock(state);
+    for(u32 span_index = 0; span_index < raster_span_count; ++span_index)
+    {
+        tgui_timeline_write_span(timeline, raster_spans + span_index);
+    }
+    timeline->frame_start = now;
+    ++timeline->frame;
+}
+#endif
+
+// NOTE: call by the thread that raster at the end of every frame, with the pipeline inside its lock. The stats,
+// spans and costs of the frame are give to the update thread and the rasterizer start with empty ones
+static void tgui_raster_frame_done(TGuiState *state)
+{
+    TGuiDebugCost *debug = &state->debug_cost;
+    if(debug->enabled)
+    {
+        TGuiWidgetCost *costs = debug->done_costs;
+        u32 costs_size = debug->done_costs_size;
+        debug->done_costs = debug->costs;
+        debug->done_costs_size = debug->costs_size;
+        debug->done_costs_count = debug->costs_count;
+        debug->costs = costs;
+        debug->costs_size = costs_size;
+        debug->costs_count = 0;
+        u16 *overdraw = debug->done_overdraw;
+        u32 overdraw_width = debug->done_overdraw_width;
+        u32 overdraw_height = debug->done_overdraw_height;
+        debug->done_overdraw = debug->overdraw;
+        debug->done_overdraw_width = debug->overdraw_width;
+        debug->done_overdraw_height = debug->overdraw_height;
+        debug->overdraw = overdraw;
+        debug->overdraw_width = overdraw_width;
+        debug->overdraw_height = overdraw_height;
+    }
+#if defined(TGUI_PROFILE)
+    TGuiProfile *profile = &state->profile;
+    tgui_frame_stats_add(&profile->raster_done, &profile->raster);
+    memset(&profile->raster, 0, sizeof(TGuiFrameStats));
+
+    TGuiTimeline *timeline = &state->timeline;
+    if(timeline->file && timeline->raster_span_count)
+    {
+        if(timeline->done_span_count == 0)
+        {
+            TGuiTimelineSpan *spans = timeline->done_spans;
+            timeline->done_spans = timeline->raster_spans;
+            timeline->done_span_count = timeline->raster_span_count;
+            timeline->raster_spans = spans;
+        }
+        else
+        {
+            // NOTE: more than one frame before the flush (tgui_draw_command_buffer call more than one time)
+            u32 count = TGUI_MIN(timeline->raster_span_count, TGUI_TIMELINE_MAX_SPANS - timeline->done_span_count);
+            memcpy(timeline->done_spans + timeline->done_span_count, timeline->raster_spans, count*sizeof(TGuiTimelineSpan));
+            timeline->done_span_count += count;
+        }
+    }
+    timeline->raster_span_count = 0;
+#endif
+}
+
+b32 tgui_timeline_begin(char *path)
+{
+#if defined(TGUI_PROFILE)
+    TGuiTimeline *timeline = &tgui_global_state.timeline;
+    if(timeline->file) tgui_timeline_end();
+    FILE *file = fopen(path, "wb");
+    if(!file) return false;
+    memset(timeline, 0, sizeof(TGuiTimeline));
+    timeline->spans = (TGuiTimelineSpan *)malloc(TGUI_TIMELINE_MAX_SPANS*sizeof(TGuiTimelineSpan));
+    timeline->raster_spans = (TGuiTimelineSpan *)malloc(TGUI_TIMELINE_MAX_SPANS*sizeof(TGuiTimelineSpan));
+    timeline->done_spans = (TGuiTimelineSpan *)malloc(TGUI_TIMELINE_MAX_SPANS*sizeof(TGuiTimelineSpan));
+    timeline->flush_spans = (TGuiTimelineSpan *)malloc(TGUI_TIMELINE_MAX_SPANS*sizeof(TGuiTimelineSpan));
+    timeline->start_time = tgui_platform_get_time();
+    timeline->frame_start = timeline->start_time;
+    timeline->first_event = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"tgui\"}}");
+    timeline->first_event = false;
+    // NOTE: set the file last, the spans are only push when the file is open
+    timeline->file = file;
+    return true;
+#else
+    UNUSED_VAR(path);
+    return false;
+#endif
+}
+
+void tgui_timeline_end(void)
+{
+#if defined(TGUI_PROFILE)
+    TGuiState *state = &tgui_global_state;
+    TGuiTimeline *timeline = &state->timeline;
+    if(!timeline->file) return;
+    // NOTE: the render thread dont push spans while the buffers are free
+    tgui_fence_wait(state->pipeline.submitted);
+    tgui_timeline_flush(state);
+    if(timeline->dropped_spans)
+    {
+        // NOTE: the json has no place for this, so it is a instant event
+        fprintf((FILE *)timeline->file, ",\n{\"name\":\"dropped spans %u\",\"ph\":\"i\",\"s\":\"g\",\"ts\":0,\"pid\":1,\"tid\":0}", timeline->dropped_spans);
+    }
+    fprintf((FILE *)timeline->file, "\n]}\n");
+    fclose((FILE *)timeline->file);
+    free(timeline->spans);
+    free(timeline->raster_spans);
+    free(timeline->done_spans);
+    free(timeline->flush_spans);
+    memset(timeline, 0, sizeof(TGuiTimeline));
+#endif
+}
+
+TGuiFrameStats tgui_get_frame_stats(void)
+{
+    TGuiState *state = &tgui_global_state;
+    return state->profile.last;
+}
+
+void tgui_draw_frame_stats(i32 x, i32 y)
+{
+#if defined(TGUI_PROFILE)
+    TGuiState *state = &tgui_global_state;
+    TGuiFrameStats *stats = &state->profile.last;
+    
+    u32 line_count = 2 + TGUI_TIMER_COUNT + TGUI_COUNTER_COUNT;
+    for(u32 type = 0; type < TGUI_DRAWCMD_COUNT; ++type)
+    {
+        if(stats->draw_commands[type]) ++line_count;
+    }
+    TGuiDrawCommand background = {0};
+    background.type = TGUI_DRAWCMD_RECT;
+    background.descriptor = tgui_rect_xywh(x, y, 32*state->font_width + 8, line_count*(state->font_height + 2) + 6);
+    background.color = TGUI_DRAK_BLACK;
+    tgui_push_draw_command(background);
+    x += 4;
+    y += 4;
+
+    char line[128];
+    tgui_profile_push_line(x, &y, line, snprintf(line, sizeof(line), "ms:%.3f fps:%d", stats->frame_ms,
+                                                 stats->frame_ms > 0 ? (i32)(1000.0/stats->frame_ms + 0.5) : 0));
+    for(u32 timer = 0; timer < TGUI_TIMER_COUNT; ++timer)
+    {
+        tgui_profile_push_line(x, &y, line, snprintf(line, sizeof(line), "%-14s %8.3fms", tgui_profile_timer_names[timer], stats->timers[timer]));
+    }
+    tgui_profile_push_line(x, &y, line, snprintf(line, sizeof(line), "raster commands"));
+    for(u32 type = 0; type < TGUI_DRAWCMD_COUNT; ++type)
+    {
+        if(!stats->draw_commands[type]) continue;
+        tgui_profile_push_line(x, &y, line, snprintf(line, sizeof(line), " %-13s %8.3fms x%u", tgui_draw_command_names[type], stats->kernels[type], stats->draw_commands[type]));
+    }
+    for(u32 counter = 0; counter < TGUI_COUNTER_COUNT; ++counter)
+    {
+        tgui_profile_push_line(x, &y, line, snprintf(line, sizeof(line), "%-14s %10llu", tgui_profile_counter_names[counter], (unsigned long long)stats->counters[counter]));
+    }
+#else
+    UNUSED_VAR(x);
+    UNUSED_VAR(y);
+#endif
+}
+
+//-----------------------------------------------------
+//  NOTE: debug cost functions
+//-----------------------------------------------------
+
+#define TGUI_DEFAULT_COSTS_SIZE 64
+static u32 tgui_overdraw_colors[] = {0x00000000, 0xFF3050FF, 0xFF30C050, 0xFFFFE040, 0xFFFF9030, 0xFFFF3030};
+
+void tgui_debug_cost_enable(b32 enable)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiDebugCost *debug = &state->debug_cost;
+    // NOTE: the render thread read the flag and the buffers, the frames in flight finish first
+    tgui_fence_wait(state->pipeline.submitted);
+    if(!enable)
+    {
+        free(debug->costs);
+        free(debug->overdraw);
+        free(debug->done_costs);
+        free(debug->done_overdraw);
+        free(debug->overdraw_bitmap.pixels);
+        memset(debug, 0, sizeof(TGuiDebugCost));
+    }
+    debug->enabled = enable;
+}
+
+static void tgui_debug_cost_begin(TGuiState *state, TGuiDrawCommandBuffer *buffer)
+{
+    TGuiDebugCost *debug = &state->debug_cost;
+    u32 count = buffer->handle_count;
+    if(count > debug->costs_size)
+    {
+        u32 new_costs_size = debug->costs_size ? debug->costs_size : TGUI_DEFAULT_COSTS_SIZE;
+        while(new_costs_size < count) new_costs_size *= 2;
+        free(debug->costs);
+        debug->costs = (TGuiWidgetCost *)malloc(new_costs_size*sizeof(TGuiWidgetCost));
+        debug->costs_size = new_costs_size;
+    }
+    memset(debug->costs, 0, count*sizeof(TGuiWidgetCost));
+    debug->costs_count = count;
+
+    TGuiBitmap *backbuffer = state->backbuffer;
+    if(debug->overdraw_width != backbuffer->width || debug->overdraw_height != backbuffer->height)
+    {
+        free(debug->overdraw);
+        debug->overdraw_width = backbuffer->width;
+        debug->overdraw_height = backbuffer->height;
+        debug->overdraw = (u16 *)malloc((u64)debug->overdraw_width*debug->overdraw_height*sizeof(u16));
+    }
+    memset(debug->overdraw, 0, (u64)debug->overdraw_width*debug->overdraw_height*sizeof(u16));
+}
+
+// NOTE: pixels that a command can write before the clipping, CLEAR is not clipped and
+// the clipping commands dont write anything
+static TGuiClipResult tgui_draw_command_bounds(TGuiState *state, TGuiDrawCommand *draw_cmd, b32 *clipped)
+{
+    TGuiRect rect = draw_cmd->descriptor;
+    *clipped = true;
+    switch(draw_cmd->type)
+    {
+        case TGUI_DRAWCMD_CLEAR:
+        {
+            rect = tgui_rect_xywh(0, 0, state->backbuffer->width, state->backbuffer->height);
+            *clipped = false;
+        } break;
+        case TGUI_DRAWCMD_CHAR:
+        {
+            rect.width = state->font_width;
+            rect.height = state->font_height;
+        } break;
+        case TGUI_DRAWCMD_TEXT:
+        {
+            rect.width = state->font_width*draw_cmd->text_size;
+            rect.height = state->font_height;
+        } break;
+        case TGUI_DRAWCMD_START_CLIPPING:
+        case TGUI_DRAWCMD_END_CLIPPING:
+        case TGUI_DRAWCMD_END_LAYER:
+        {
+            rect = tgui_rect_xywh(0, 0, 0, 0);
+        } break;
+        default: break;
+    }
+    TGuiClipResult bounds = {0};
+    bounds.min_x = rect.x;
+    bounds.min_y = rect.y;
+    bounds.max_x = bounds.min_x + (i32)rect.width;
+    bounds.max_y = bounds.min_y + (i32)rect.height;
+    return bounds;
+}
+
+static void tgui_debug_cost_command(TGuiState *state, TGuiDrawCommand *draw_cmd, f64 start)
+{
+    TGuiDebugCost *debug = &state->debug_cost;
+    f64 ms = (tgui_platform_get_time() - start)*1000.0;
+    
+    b32 clipped;
+    TGuiClipResult clip = tgui_draw_command_bounds(state, draw_cmd, &clipped);
+    if(clipped)
+    {
+        clip = tgui_clip_rect(clip.min_x, clip.min_y, clip.max_x, clip.max_y, tgui_clipping_stack_top(&global_clipping_stack));
+    }
+
+    u64 pixels = 0;
+    if(clip.max_x > clip.min_x && clip.max_y > clip.min_y)
+    {
+        pixels = (u64)(clip.max_x - clip.min_x)*(clip.max_y - clip.min_y);
+        for(i32 y = clip.min_y; y < clip.max_y; ++y)
+        {
+            u16 *count = debug->overdraw + (u64)y*debug->overdraw_width + clip.min_x;
+            for(i32 x = clip.min_x; x < clip.max_x; ++x)
+            {
+                if(*count < 0xFFFF) ++(*count);
+                ++count;
+            }
+        }
+    }
+
+    if(draw_cmd->handle && draw_cmd->handle < debug->costs_count)
+    {
+        TGuiWidgetCost *cost = debug->costs + draw_cmd->handle;
+        cost->handle = draw_cmd->handle;
+        ++cost->commands;
+        cost->pixels += pixels;
+        cost->ms += ms;
+    }
+}
+
+inline static b32 tgui_widget_cost_greater(TGuiWidgetCost *a, TGuiWidgetCost *b, TGuiCostSort sort)
+{
+    if(sort == TGUI_COST_SORT_TIME) return a->ms > b->ms;
+    return a->pixels > b->pixels;
+}
+
+// NOTE: the costs are from the last frame that the rasterizer finish
+u32 tgui_debug_cost_top(TGuiWidgetCost *costs, u32 max_count, TGuiCostSort sort)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiDebugCost *debug = &state->debug_cost;
+    u32 count = 0;
+    if(!max_count) return 0;
+    tgui_pipeline_lock(state);
+    for(u32 handle = 1; handle < debug->done_costs_count; ++handle)
+    {
+        TGuiWidgetCost *cost = debug->done_costs + handle;
+        if(!cost->commands) continue;
+        // NOTE: the costs can be from other thread, the type is take here from the widget (that can be free already)
+        TGuiWidget *widget = tgui_widget_get(handle);
+        cost->type = widget ? widget->header.type : TGUI_END_CONTAINER;
+        // NOTE: insert in the sorted array, only the max_count biggest are kept
+        u32 index = count;
+        while(index > 0 && tgui_widget_cost_greater(cost, costs + index - 1, sort)) --index;
+        if(index >= max_count) continue;
+        u32 last = count < max_count ? count : max_count - 1;
+        memmove(costs + index + 1, costs + index, (last - index)*sizeof(TGuiWidgetCost));
+        costs[index] = *cost;
+        if(count < max_count) ++count;
+    }
+    tgui_pipeline_unlock(state);
+    return count;
+}
+
+TGuiBitmap *tgui_debug_overdraw_bitmap(void)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiDebugCost *debug = &state->debug_cost;
+    TGuiBitmap *bitmap = &debug->overdraw_bitmap;
+    tgui_pipeline_lock(state);
+    if(!debug->done_overdraw)
+    {
+        tgui_pipeline_unlock(state);
+        return 0;
+    }
+    if(bitmap->width != debug->done_overdraw_width || bitmap->height != debug->done_overdraw_height)
+    {
+        free(bitmap->pixels);
+        bitmap->width = debug->done_overdraw_width;
+        bitmap->height = debug->done_overdraw_height;
+        bitmap->pitch = bitmap->width*sizeof(u32);
+        bitmap->pixels = (u32 *)malloc((u64)bitmap->width*bitmap->height*sizeof(u32));
+    }
+    u32 max_color = sizeof(tgui_overdraw_colors)/sizeof(u32) - 1;
+    u64 pixel_count = (u64)bitmap->width*bitmap->height;
+    for(u64 index = 0; index < pixel_count; ++index)
+    {
+        u32 count = debug->done_overdraw[index];
+        bitmap->pixels[index] = tgui_overdraw_colors[count < max_color ? count : max_color];
+    }
+    tgui_pipeline_unlock(state);
+    return bitmap;
+}
+
+void tgui_debug_draw_overdraw(TGuiBitmap *backbuffer)
+{
+    TGuiBitmap *bitmap = tgui_debug_overdraw_bitmap();
+    if(!bitmap || bitmap->width != backbuffer->width || bitmap->height != backbuffer->height) return;
+    u8 *row = (u8 *)backbuffer->pixels;
+    u32 *heat = bitmap->pixels;
+    for(u32 y = 0; y < backbuffer->height; ++y)
+    {
+        u32 *pixels = (u32 *)row;
+        for(u32 x = 0; x < backbuffer->width; ++x)
+        {
+            // NOTE: 50% blend
+            if(*heat) *pixels = 0xFF000000 | (((*pixels >> 1) & 0x7F7F7F) + ((*heat >> 1) & 0x7F7F7F));
+            ++pixels;
+            ++heat;
+        }
+        row += backbuffer->pitch;
+    }
+}
+
+//-----------------------------------------------------
+//  NOTE: damage functions
+//-----------------------------------------------------
+
+void tgui_damage_enable(b32 enable)
+{
+    TGuiDamage *damage = &tgui_global_state.damage;
+    if(!enable)
+    {
+        if(damage->current) free(damage->current->widgets);
+        if(damage->last) free(damage->last->widgets);
+        free(damage->current);
+        free(damage->last);
+        memset(damage, 0, sizeof(TGuiDamage));
+    }
+    else if(!damage->enabled)
+    {
+        damage->current = (TGuiDamageFrame *)calloc(1, sizeof(TGuiDamageFrame));
+        damage->last = (TGuiDamageFrame *)calloc(1, sizeof(TGuiDamageFrame));
+        // NOTE: the first frame is draw complete
+        damage->valid = false;
+    }
+    damage->enabled = enable;
+}
+
+inline static TGuiDamageRect tgui_damage_rect(i32 min_x, i32 min_y, i32 max_x, i32 max_y)
+{
+    TGuiDamageRect result;
+    result.min_x = min_x;
+    result.min_y = min_y;
+    result.max_x = max_x;
+    result.max_y = max_y;
+    return result;
+}
+
+inline static b32 tgui_damage_rect_empty(TGuiDamageRect rect)
+{
+    return rect.min_x >= rect.max_x || rect.min_y >= rect.max_y;
+}
+
+inline static TGuiDamageRect tgui_damage_rect_intersect(TGuiDamageRect a, TGuiDamageRect b)
+{
+    return tgui_damage_rect(TGUI_MAX(a.min_x, b.min_x), TGUI_MAX(a.min_y, b.min_y), TGUI_MIN(a.max_x, b.max_x), TGUI_MIN(a.max_y, b.max_y));
+}
+
+inline static TGuiDamageRect tgui_damage_rect_union(TGuiDamageRect a, TGuiDamageRect b)
+{
+    return tgui_damage_rect(TGUI_MIN(a.min_x, b.min_x), TGUI_MIN(a.min_y, b.min_y), TGUI_MAX(a.max_x, b.max_x), TGUI_MAX(a.max_y, b.max_y));
+}
+
+inline static TGuiDamageRect tgui_damage_rect_offset(TGuiDamageRect rect, i32 x, i32 y)
+{
+    return tgui_damage_rect(rect.min_x + x, rect.min_y + y, rect.max_x + x, rect.max_y + y);
+}
+
+inline static b32 tgui_damage_rect_contains(TGuiDamageRect outer, TGuiDamageRect inner)
+{
+    return inner.min_x >= outer.min_x && inner.min_y >= outer.min_y && inner.max_x <= outer.max_x && inner.max_y <= outer.max_y;
+}
+
+inline static u64 tgui_damage_rect_area(TGuiDamageRect rect)
+{
+    if(tgui_damage_rect_empty(rect)) return 0;
+    return (u64)(rect.max_x - rect.min_x)*(u64)(rect.max_y - rect.min_y);
+}
+
+// NOTE: the rects that overlap are merge, if the list is full the rect is merge with the one that grow less
+static void tgui_damage_add_rect(TGuiDamageRect *rects, u32 *count, TGuiDamageRect rect)
+{
+    if(tgui_damage_rect_empty(rect)) return;
+    for(u32 rect_index = 0; rect_index < *count;)
+    {
+        if(!tgui_damage_rect_empty(tgui_damage_rect_intersect(rects[rect_index], rect)))
+        {
+            rect = tgui_damage_rect_union(rects[rect_index], rect);
+            rects[rect_index] = rects[--(*count)];
+            rect_index = 0;
+        }
+        else
+        {
+            ++rect_index;
+        }
+    }
+    if(*count == TGUI_DAMAGE_RECTS_MAX)
+    {
+        u32 best_index = 0;
+        u64 best_growth = (u64)-1;
+        for(u32 rect_index = 0; rect_index < *count; ++rect_index)
+        {
+            TGuiDamageRect merged = tgui_damage_rect_union(rects[rect_index], rect);
+            u64 growth = tgui_damage_rect_area(merged) - tgui_damage_rect_area(rects[rect_index]);
+            if(growth < best_growth)
+            {
+                best_growth = growth;
+                best_index = rect_index;
+            }
+        }
+        rect = tgui_damage_rect_union(rects[best_index], rect);
+        rects[best_index] = rects[--(*count)];
+        tgui_damage_add_rect(rects, count, rect);
+        return;
+    }
+    rects[(*count)++] = rect;
+}
+
+static void tgui_damage_add_dirty(TGuiDamage *damage, TGuiDamageRect rect)
+{
+    TGuiDamageRect screen = tgui_damage_rect(0, 0, damage->backbuffer_width, damage->backbuffer_height);
+    tgui_damage_add_rect(damage->dirty, &damage->dirty_count, tgui_damage_rect_intersect(rect, screen));
+}
+
+typedef struct TGuiDamageScope
+{
+    TGuiHandle handle;
+    // NOTE: clip in the screen and clip in the space of the scroll origin (only the clips inside the scope)
+    TGuiDamageRect clip;
+    TGuiDamageRect local_clip;
+    i32 origin_x;
+    i32 origin_y;
+} TGuiDamageScope;
+
+#define TGUI_DAMAGE_NO_CLIP (1 << 29)
+
+static void tgui_damage_analyze(TGuiState *state, TGuiDamageFrame *frame, TGuiDrawCommandBuffer *buffer)
+{
+    u32 widgets_count = buffer->handle_count;
+    if(widgets_count > frame->widgets_size)
+    {
+        u32 new_widgets_size = frame->widgets_size ? frame->widgets_size : TGUI_DEFAULT_POOL_SIZE;
+        while(new_widgets_size < widgets_count) new_widgets_size *= 2;
+        free(frame->widgets);
+        frame->widgets = (TGuiDamageWidget *)malloc(new_widgets_size*sizeof(TGuiDamageWidget));
+        frame->widgets_size = new_widgets_size;
+    }
+    memset(frame->widgets, 0, widgets_count*sizeof(TGuiDamageWidget));
+    frame->widgets_count = widgets_count;
+    frame->command_count = 0;
+
+    TGuiDamageScope scopes[TGUI_DAMAGE_SCOPES_MAX];
+    u32 depth = 1;
+    memset(scopes, 0, sizeof(TGuiDamageScope));
+    scopes[0].clip = tgui_damage_rect(0, 0, state->backbuffer->width, state->backbuffer->height);
+    scopes[0].local_clip = tgui_damage_rect(-TGUI_DAMAGE_NO_CLIP, -TGUI_DAMAGE_NO_CLIP, TGUI_DAMAGE_NO_CLIP, TGUI_DAMAGE_NO_CLIP);
+
+    TGuiHandle last_handle = TGUI_INVALID_HANDLE;
+    for(u32 command_index = buffer->head; command_index < buffer->count; ++command_index)
+    {
+        TGuiDrawCommand *draw_cmd = buffer->buffer + command_index;
+        TGuiHandle handle = draw_cmd->handle < widgets_count ? draw_cmd->handle : TGUI_INVALID_HANDLE;
+        TGuiDamageWidget *widget = frame->widgets + handle;
+        if(!widget->drawn)
+        {
+            widget->drawn = true;
+            widget->prev = last_handle;
+        }
+        last_handle = handle;
+
+        TGuiDamageScope *scope = scopes + depth - 1;
+        TGuiDamageCommand *command = frame->commands + frame->command_count++;
+        command->handle = handle;
+        command->scope = scope->handle;
+        command->index = widget->count++;
+        command->solid = draw_cmd->type == TGUI_DRAWCMD_RECT;
+
+        b32 clipped;
+        TGuiClipResult bounds = tgui_draw_command_bounds(state, draw_cmd, &clipped);
+        command->bounds = tgui_damage_rect(bounds.min_x, bounds.min_y, bounds.max_x, bounds.max_y);
+        if(clipped) command->bounds = tgui_damage_rect_intersect(command->bounds, scope->clip);
+
+        // NOTE: the content hash dont change if only the scroll of the scope change
+        u64 hash = 0xCBF29CE484222325ull;
+        hash = tgui_hash_bytes(hash, &draw_cmd->type, sizeof(draw_cmd->type));
+        hash = tgui_hash_bitmap(hash, draw_cmd->bitmap);
+        hash = tgui_hash_bytes(hash, &draw_cmd->ratio, sizeof(draw_cmd->ratio));
+        hash = tgui_hash_bytes(hash, &draw_cmd->color, sizeof(draw_cmd->color));
+        hash = tgui_hash_bytes(hash, &draw_cmd->character, sizeof(draw_cmd->character));
+        if(draw_cmd->text) hash = tgui_hash_bytes(hash, draw_cmd->text, draw_cmd->text_size);
+        TGuiRect local = draw_cmd->descriptor;
+        if(tgui_draw_command_has_position(draw_cmd->type))
+        {
+            local.x -= scope->origin_x;
+            local.y -= scope->origin_y;
+        }
+        command->hash = tgui_hash_bytes(hash, &draw_cmd->descriptor, sizeof(TGuiRect));
+        command->hash = tgui_hash_bytes(command->hash, &scope->clip, sizeof(TGuiDamageRect));
+        command->content_hash = tgui_hash_bytes(hash, &local, sizeof(TGuiRect));
+        command->content_hash = tgui_hash_bytes(command->content_hash, &scope->local_clip, sizeof(TGuiDamageRect));
+
+        if(draw_cmd->type == TGUI_DRAWCMD_START_CLIPPING)
+        {
+            ASSERT(depth < TGUI_DAMAGE_SCOPES_MAX);
+            if(depth == TGUI_DAMAGE_SCOPES_MAX) continue;
+            TGuiRect descriptor = draw_cmd->descriptor;
+            TGuiDamageRect clip = tgui_damage_rect(descriptor.x, descriptor.y, (i32)descriptor.x + (i32)descriptor.width, (i32)descriptor.y + (i32)descriptor.height);
+            TGuiDamageScope *new_scope = scopes + depth++;
+            *new_scope = *scope;
+            new_scope->clip = tgui_damage_rect_intersect(scope->clip, clip);
+            new_scope->local_clip = tgui_damage_rect_intersect(scope->local_clip, tgui_damage_rect_offset(clip, -scope->origin_x, -scope->origin_y));
+
+            if(draw_cmd->scroll && handle)
+            {
+                // NOTE: the content of a scroll container has its own space, the scroll is part of the hash
+                // of the container so a container that scroll inside other is not equal
+                i32 offset[2] = {draw_cmd->scroll_x, draw_cmd->scroll_y};
+                command->hash = tgui_hash_bytes(command->hash, offset, sizeof(offset));
+                command->content_hash = tgui_hash_bytes(command->content_hash, offset, sizeof(offset));
+
+                new_scope->handle = handle;
+                new_scope->origin_x = clip.min_x - offset[0];
+                new_scope->origin_y = clip.min_y - offset[1];
+                new_scope->local_clip = scopes[0].local_clip;
+                widget->scroll = true;
+                widget->scope = scope->handle;
+                widget->origin_x = new_scope->origin_x;
+                widget->origin_y = new_scope->origin_y;
+                widget->clip = new_scope->clip;
+                widget->begin = frame->command_count - 1;
+            }
+        }
+        else if(draw_cmd->type == TGUI_DRAWCMD_END_CLIPPING && depth > 1)
+        {
+            --depth;
+        }
+    }
+
+    // NOTE: sort the commands by widget, so the command of a widget and index can be found
+    u32 first = 0;
+    for(u32 handle = 0; handle < widgets_count; ++handle)
+    {
+        TGuiDamageWidget *widget = frame->widgets + handle;
+        widget->first = first;
+        first += widget->count;
+        widget->count = 0;
+    }
+    for(u32 command_index = 0; command_index < frame->command_count; ++command_index)
+    {
+        TGuiDamageWidget *widget = frame->widgets + frame->commands[command_index].handle;
+        frame->sorted[widget->first + widget->count++] = command_index;
+    }
+}
+
+static TGuiDamageCommand *tgui_damage_find(TGuiDamageFrame *frame, TGuiHandle handle, u32 index)
+{
+    if(handle >= frame->widgets_count) return 0;
+    TGuiDamageWidget *widget = frame->widgets + handle;
+    if(index >= widget->count) return 0;
+    return frame->commands + frame->sorted[widget->first + index];
+}
+
+static b32 tgui_damage_in_scope(TGuiDamageFrame *frame, TGuiHandle scope, TGuiHandle ancestor)
+{
+    for(u32 depth = 0; scope && depth < TGUI_DAMAGE_SCOPES_MAX; ++depth)
+    {
+        if(scope == ancestor) return true;
+        scope = frame->widgets[scope].scope;
+    }
+    return false;
+}
+
+// NOTE: scroll container that contains the command and whose pixels are moved, 0 if there is none
+static TGuiHandle tgui_damage_blit_scope(TGuiDamageFrame *frame, TGuiHandle scope)
+{
+    for(u32 depth = 0; scope && depth < TGUI_DAMAGE_SCOPES_MAX; ++depth)
+    {
+        if(frame->widgets[scope].blit) return scope;
+        scope = frame->widgets[scope].scope;
+    }
+    return TGUI_INVALID_HANDLE;
+}
+
+inline static b32 tgui_damage_command_changed(TGuiDamageFrame *current, TGuiDamageFrame *last, TGuiDamageCommand *command, TGuiDamageCommand *last_command)
+{
+    return !last_command || last_command->hash != command->hash ||
+           last->widgets[command->handle].prev != current->widgets[command->handle].prev;
+}
+
+// NOTE: a scroll container can move its pixels if everything inside it is equal, only moved by the scroll
+static b32 tgui_damage_can_blit(TGuiDamage *damage, TGuiHandle handle)
+{
+    TGuiDamageFrame *current = damage->current;
+    TGuiDamageFrame *last = damage->last;
+    if(handle >= last->widgets_count) return false;
+    TGuiDamageWidget *widget = current->widgets + handle;
+    TGuiDamageWidget *last_widget = last->widgets + handle;
+    if(!last_widget->scroll || memcmp(&widget->clip, &last_widget->clip, sizeof(TGuiDamageRect)) != 0) return false;
+    i32 offset_x = widget->origin_x - last_widget->origin_x;
+    i32 offset_y = widget->origin_y - last_widget->origin_y;
+    if(offset_x == 0 && offset_y == 0) return false;
+    if(abs(offset_x) >= widget->clip.max_x - widget->clip.min_x || abs(offset_y) >= widget->clip.max_y - widget->clip.min_y) return false;
+
+    for(u32 command_index = 0; command_index < current->command_count; ++command_index)
+    {
+        TGuiDamageCommand *command = current->commands + command_index;
+        if(!tgui_damage_in_scope(current, command->scope, handle)) continue;
+        TGuiDamageCommand *last_command = tgui_damage_find(last, command->handle, command->index);
+        if(!last_command || last_command->content_hash != command->content_hash || last_command->scope != command->scope ||
+           last->widgets[command->handle].count != current->widgets[command->handle].count ||
+           last->widgets[command->handle].prev != current->widgets[command->handle].prev)
+        {
+            return false;
+        }
+    }
+    for(u32 command_index = 0; command_index < last->command_count; ++command_index)
+    {
+        TGuiDamageCommand *last_command = last->commands + command_index;
+        if(!tgui_damage_in_scope(last, last_command->scope, handle)) continue;
+        if(!tgui_damage_find(current, last_command->handle, last_command->index)) return false;
+    }
+    return true;
+}
+
+static void tgui_damage_blit(TGuiBitmap *backbuffer, TGuiDamageRect clip, i32 offset_x, i32 offset_y)
+{
+    TGuiDamageRect dest = tgui_damage_rect_intersect(clip, tgui_damage_rect_offset(clip, offset_x, offset_y));
+    if(tgui_damage_rect_empty(dest)) return;
+    i32 width = dest.max_x - dest.min_x;
+    TGUI_RASTER_COUNT(TGUI_COUNTER_PIXELS_WRITTEN, tgui_damage_rect_area(dest));
+    // NOTE: the rows are copy in the order that dont overwrite a row before it is read
+    for(i32 row_index = 0; row_index < dest.max_y - dest.min_y; ++row_index)
+    {
+        i32 y = offset_y > 0 ? dest.max_y - 1 - row_index : dest.min_y + row_index;
+        u32 *dest_row = (u32 *)((u8 *)backbuffer->pixels + (u64)y*backbuffer->pitch) + dest.min_x;
+        u32 *src_row = (u32 *)((u8 *)backbuffer->pixels + (u64)(y - offset_y)*backbuffer->pitch) + (dest.min_x - offset_x);
+        memmove(dest_row, src_row, width*sizeof(u32));
+    }
+}
+
+// NOTE: the commands that are not inside the moved container but write inside its clip were moved
+// with it, they are draw again in the new and in the moved position. A solid rect under the container
+// that fill all the clip look the same after the move
+static void tgui_damage_blit_outside(TGuiDamage *damage, TGuiDamageFrame *frame, TGuiDamageFrame *other, TGuiHandle handle, i32 offset_x, i32 offset_y)
+{
+    TGuiDamageWidget *widget = frame->widgets + handle;
+    for(u32 command_index = 0; command_index < frame->command_count; ++command_index)
+    {
+        TGuiDamageCommand *command = frame->commands + command_index;
+        if(tgui_damage_in_scope(frame, command->scope, handle)) continue;
+        TGuiDamageRect rect = tgui_damage_rect_intersect(command->bounds, widget->clip);
+        if(tgui_damage_rect_empty(rect)) continue;
+        TGuiDamageCommand *other_command = tgui_damage_find(other, command->handle, command->index);
+        if(command->solid && command_index < widget->begin && tgui_damage_rect_contains(command->bounds, widget->clip) &&
+           other_command && other_command->hash == command->hash)
+        {
+            continue;
+        }
+        rect = tgui_damage_rect_intersect(tgui_damage_rect_offset(rect, offset_x, offset_y), widget->clip);
+        tgui_damage_add_dirty(damage, rect);
+    }
+}
+
+static void tgui_damage_compute(TGuiState *state)
+{
+    TGuiDamage *damage = &state->damage;
+    TGuiDamageFrame *current = damage->current;
+    TGuiDamageFrame *last = damage->last;
+    TGuiBitmap *backbuffer = state->backbuffer;
+    damage->dirty_count = 0;
+    damage->present_count = 0;
+
+    if(!damage->valid || damage->backbuffer != backbuffer ||
+       damage->backbuffer_width != backbuffer->width || damage->backbuffer_height != backbuffer->height)
+    {
+        damage->backbuffer = backbuffer;
+        damage->backbuffer_width = backbuffer->width;
+        damage->backbuffer_height = backbuffer->height;
+        tgui_damage_add_dirty(damage, tgui_damage_rect(0, 0, backbuffer->width, backbuffer->height));
+        tgui_damage_add_rect(damage->present, &damage->present_count, damage->dirty[0]);
+        return;
+    }
+
+    // NOTE: move the pixels of the scroll containers in draw order, the containers inside are draw after
+    for(u32 command_index = 0; command_index < current->command_count; ++command_index)
+    {
+        TGuiHandle handle = current->commands[command_index].handle;
+        TGuiDamageWidget *widget = current->widgets + handle;
+        if(!widget->scroll || widget->begin != command_index || !tgui_damage_can_blit(damage, handle)) continue;
+
+        TGuiDamageWidget *last_widget = last->widgets + handle;
+        i32 offset_x = widget->origin_x - last_widget->origin_x;
+        i32 offset_y = widget->origin_y - last_widget->origin_y;
+        widget->blit = true;
+        tgui_damage_blit(backbuffer, widget->clip, offset_x, offset_y);
+        tgui_damage_add_rect(damage->present, &damage->present_count, widget->clip);
+
+        // NOTE: the strips that were outside the clip before the scroll
+        TGuiDamageRect clip = widget->clip;
+        if(offset_x > 0) tgui_damage_add_dirty(damage, tgui_damage_rect(clip.min_x, clip.min_y, clip.min_x + offset_x, clip.max_y));
+        if(offset_x < 0) tgui_damage_add_dirty(damage, tgui_damage_rect(clip.max_x + offset_x, clip.min_y, clip.max_x, clip.max_y));
+        if(offset_y > 0) tgui_damage_add_dirty(damage, tgui_damage_rect(clip.min_x, clip.min_y, clip.max_x, clip.min_y + offset_y));
+        if(offset_y < 0) tgui_damage_add_dirty(damage, tgui_damage_rect(clip.min_x, clip.max_y + offset_y, clip.max_x, clip.max_y));
+
+        tgui_damage_blit_outside(damage, current, last, handle, 0, 0);
+        tgui_damage_blit_outside(damage, last, current, handle, offset_x, offset_y);
+    }
+
+    for(u32 command_index = 0; command_index < current->command_count; ++command_index)
+    {
+        TGuiDamageCommand *command = current->commands + command_index;
+        // NOTE: the commands of a moved container are equal, its pixels are already in place
+        if(tgui_damage_blit_scope(current, command->scope)) continue;
+        TGuiDamageCommand *last_command = tgui_damage_find(last, command->handle, command->index);
+        if(tgui_damage_command_changed(current, last, command, last_command))
+        {
+            tgui_damage_add_dirty(damage, command->bounds);
+            if(last_command) tgui_damage_add_dirty(damage, last_command->bounds);
+        }
+    }
+    for(u32 command_index = 0; command_index < last->command_count; ++command_index)
+    {
+        TGuiDamageCommand *last_command = last->commands + command_index;
+        if(!tgui_damage_find(current, last_command->handle, last_command->index))
+        {
+            tgui_damage_add_dirty(damage, last_command->bounds);
+        }
+    }
+
+    for(u32 rect_index = 0; rect_index < damage->dirty_count; ++rect_index)
+    {
+        tgui_damage_add_rect(damage->present, &damage->present_count, damage->dirty[rect_index]);
+    }
+}
+
+u32 tgui_get_dirty_rects(TGuiRect *rects, u32 max_count)
+{
+    TGuiState *state = &tgui_global_state;
+    TGuiDamage *damage = &state->damage;
+    if(!max_count) return 0;
+    if(!damage->enabled)
+    {
+        rects[0] = tgui_rect_xywh(0, 0, state->backbuffer->width, state->backbuffer->height);
+        return 1;
+    }
+    u32 count = 0;
+    TGuiDamageRect merged = {0};
+    for(u32 rect_index = 0; rect_index < damage->present_count; ++rect_index)
+    {
+        TGuiDamageRect rect = damage->present[rect_index];
+        if(count < max_count - 1)
+        {
+            rects[count++] = tgui_rect_xywh(rect.min_x, rect.min_y, rect.max_x - rect.min_x, rect.max_y - rect.min_y);
+        }
+        else
+        {
+            merged = rect_index == max_count - 1 ? rect : tgui_damage_rect_union(merged, rect);
+        }
+    }
+    if(damage->present_count >= max_count)
+    {
+        rects[count++] = tgui_rect_xywh(merged.min_x, merged.min_y, merged.max_x - merged.min_x, merged.max_y - merged.min_y);
+    }
+    return count;
+}
+
+//-----------------------------------------------------
+//  NOTE: occlusion functions
+//-----------------------------------------------------
+
+static void tgui_occlusion_push_root(TGuiOcclusion *occlusion, TGuiHandle handle, u32 first)
+{
+    if(occlusion->root_count == TGUI_OCCLUSION_ROOTS_MAX)
+    {
+        occlusion->overflow = true;
+        return;
+    }
+    TGuiOcclusionRoot *root = occlusion->roots + occlusion->root_count++;
+    root->handle = handle;
+    root->first = first;
+}
+
+inline static b32 tgui_occlusion_draw_pixels(TGuiDrawCommandType type)
+{
+    return type == TGUI_DRAWCMD_RECT || type == TGUI_DRAWCMD_ROUNDED_RECT || type == TGUI_DRAWCMD_BITMAP ||
+           type == TGUI_DRAWCMD_TEXT || type == TGUI_DRAWCMD_CHAR || type == TGUI_DRAWCMD_BEGIN_LAYER ||
+           type == TGUI_DRAWCMD_SPANS;
+}
+
+// NOTE: subtract the occluder from the pieces, return max_count + 1 if the result does not fit
+static u32 tgui_occlusion_subtract(TGuiDamageRect *pieces, u32 count, u32 max_count, TGuiDamageRect occluder)
+{
+    TGuiDamageRect result[TGUI_OCCLUSION_PIECES_MAX];
+    u32 result_count = 0;
+    for(u32 piece_index = 0; piece_index < count; ++piece_index)
+    {
+        TGuiDamageRect piece = pieces[piece_index];
+        TGuiDamageRect hidden = tgui_damage_rect_intersect(piece, occluder);
+        TGuiDamageRect split[4];
+        u32 split_count = 0;
+        if(tgui_damage_rect_empty(hidden))
+        {
+            split[split_count++] = piece;
+        }
+        else
+        {
+            // NOTE: the rows above and below the occluder and the columns at its sides
+            if(piece.min_y < hidden.min_y) split[split_count++] = tgui_damage_rect(piece.min_x, piece.min_y, piece.max_x, hidden.min_y);
+            if(hidden.max_y < piece.max_y) split[split_count++] = tgui_damage_rect(piece.min_x, hidden.max_y, piece.max_x, piece.max_y);
+            if(piece.min_x < hidden.min_x) split[split_count++] = tgui_damage_rect(piece.min_x, hidden.min_y, hidden.min_x, hidden.max_y);
+            if(hidden.max_x < piece.max_x) split[split_count++] = tgui_damage_rect(hidden.max_x, hidden.min_y, piece.max_x, hidden.max_y);
+        }
+        if(result_count + split_count > max_count) return max_count + 1;
+        for(u32 split_index = 0; split_index < split_count; ++split_index)
+        {
+            result[result_count++] = split[split_index];
+        }
+    }
+    memcpy(pieces, result, result_count*sizeof(TGuiDamageRect));
+    return result_count;
+}
+
+inline static b32 tgui_occlusion_is_visible(TGuiDamageRect *pieces, u32 count, TGuiDamageRect bounds)
+{
+    for(u32 piece_index = 0; piece_index < count; ++piece_index)
+    {
+        if(!tgui_damage_rect_empty(tgui_damage_rect_intersect(pieces[piece_index], bounds))) return true;
+    }
+    return false;
+}
+
+static void tgui_occlusion_cull(TGuiState *state)
+{
+    TGuiDrawCommandBuffer *buffer = &state->draw_command_buffer;
+    TGuiOcclusion *occlusion = &buffer->occlusion;
+    memset(occlusion->culled, 0, sizeof(occlusion->culled));
+    occlusion->visible_count = 0;
+    // NOTE: a root end where the next one start (the optimizer can move the starts)
+    for(u32 root_index = 0; root_index < occlusion->root_count; ++root_index)
+    {
+        b32 last = root_index + 1 == occlusion->root_count;
+        occlusion->roots[root_index].end = last ? buffer->count : occlusion->roots[root_index + 1].first;
+    }
+    // NOTE: with too many roots everything is draw
+    if(occlusion->overflow) occlusion->root_count = 0;
+    if(occlusion->root_count < 2)
+    {
+        if(occlusion->root_count) occlusion->roots[0].occluded = false;
+        return;
+    }
+
+    // NOTE: bounds of the commands clipped by its containers
+    TGuiDamageRect clips[TGUI_DAMAGE_SCOPES_MAX];
+    u32 depth = 1;
+    u32 ignored_depth = 0;
+    clips[0] = tgui_damage_rect(0, 0, state->backbuffer->width, state->backbuffer->height);
+    for(u32 command_index = 0; command_index < buffer->count; ++command_index)
+    {
+        TGuiDrawCommand *draw_cmd = buffer->buffer + command_index;
+        b32 clipped;
+        TGuiClipResult bounds = tgui_draw_command_bounds(state, draw_cmd, &clipped);
+        TGuiDamageRect rect = tgui_damage_rect(bounds.min_x, bounds.min_y, bounds.max_x, bounds.max_y);
+        occlusion->bounds[command_index] = tgui_damage_rect_intersect(rect, clipped ? clips[depth - 1] : clips[0]);
+        if(draw_cmd->type == TGUI_DRAWCMD_START_CLIPPING)
+        {
+            TGuiRect descriptor = draw_cmd->descriptor;
+            TGuiDamageRect clip = tgui_damage_rect(descriptor.x, descriptor.y, (i32)descriptor.x + (i32)descriptor.width, (i32)descriptor.y + (i32)descriptor.height);
+            if(depth < TGUI_DAMAGE_SCOPES_MAX)
+            {
+                clips[depth] = tgui_damage_rect_intersect(clips[depth - 1], clip);
+                ++depth;
+            }
+            else ++ignored_depth;
+        }
+        else if(draw_cmd->type == TGUI_DRAWCMD_END_CLIPPING)
+        {
+            if(ignored_depth) --ignored_depth;
+            else if(depth > 1) --depth;
+        }
+    }
+
+    for(i32 root_index = occlusion->root_count - 1; root_index >= 0; --root_index)
+    {
+        TGuiOcclusionRoot *root = occlusion->roots + root_index;
+        root->occluded = false;
+        root->first_visible = occlusion->visible_count;
+        root->visible_count = 0;
+
+        TGuiDamageRect pieces[TGUI_OCCLUSION_PIECES_MAX];
+        u32 piece_count = 0;
+        for(u32 command_index = root->first; command_index < root->end; ++command_index)
+        {
+            TGuiDamageRect bounds = occlusion->bounds[command_index];
+            if(tgui_damage_rect_empty(bounds)) continue;
+            pieces[0] = piece_count ? tgui_damage_rect_union(pieces[0], bounds) : bounds;
+            piece_count = 1;
+        }
+        // NOTE: the roots above are already process, subtract its backgrounds
+        for(u32 above_index = root_index + 1; piece_count && piece_count <= TGUI_OCCLUSION_PIECES_MAX && above_index < occlusion->root_count; ++above_index)
+        {
+            TGuiDamageRect opaque = occlusion->roots[above_index].opaque;
+            if(tgui_damage_rect_empty(opaque)) continue;
+            if(piece_count == 1 && tgui_damage_rect_empty(tgui_damage_rect_intersect(pieces[0], opaque))) continue;
+            root->occluded = true;
+            piece_count = tgui_occlusion_subtract(pieces, piece_count, TGUI_OCCLUSION_PIECES_MAX, opaque);
+        }
+        if(piece_count > TGUI_OCCLUSION_PIECES_MAX || occlusion->visible_count + piece_count > TGUI_OCCLUSION_RECTS_MAX)
+        {
+            root->occluded = false;
+        }
+
+        if(root->occluded)
+        {
+            memcpy(occlusion->visible + occlusion->visible_count, pieces, piece_count*sizeof(TGuiDamageRect));
+            occlusion->visible_count += piece_count;
+            root->visible_count = piece_count;
+            // NOTE: the commands inside a layer are not culled, the layer bitmap must have all of them
+            u32 command_index = root->first;
+            while(command_index < root->end)
+            {
+                TGuiDrawCommandType type = buffer->buffer[command_index].type;
+                u32 next_index = command_index + 1;
+                if(type == TGUI_DRAWCMD_BEGIN_LAYER)
+                {
+                    u32 end_index = tgui_layer_end(buffer, command_index, root->end);
+                    next_index = end_index < root->end ? end_index + 1 : root->end;
+                }
+                if(tgui_occlusion_draw_pixels(type) && !tgui_occlusion_is_visible(pieces, piece_count, occlusion->bounds[command_index]))
+                {
+                    memset(occlusion->culled + command_index, true, next_index - command_index);
+                    TGUI_PROFILE_COUNT(TGUI_COUNTER_CULLED_COMMANDS, next_index - command_index);
+                }
+                command_index = next_index;
+            }
+        }
+
+        // NOTE: the background of a root container is the first command (after its layer)
+        root->opaque = tgui_damage_rect(0, 0, 0, 0);
+        TGuiWidget *widget = tgui_widget_get(root->handle);
+        u32 background_index = root->first;
+        if(background_index < root->end && buffer->buffer[background_index].type == TGUI_DRAWCMD_BEGIN_LAYER) ++background_index;
+        if(widget->header.type == TGUI_CONTAINER && background_index < root->end)
+        {
+            TGuiDrawCommand *background = buffer->buffer + background_index;
+            if(background->type == TGUI_DRAWCMD_RECT && background->handle == root->handle && (background->color & 0xFF000000) == 0xFF000000 &&
+               !tgui_damage_rect_empty(occlusion->bounds[background_index]))
+            {
+                root->opaque = occlusion->bounds[background_index];
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------
+//  NOTE: hit batch functions
+//-----------------------------------------------------
+
+void tgui_hit_batch_enable(b32 enable)
+{
+    TGuiHitBatch *batch = &tgui_global_state.hit_batch;
+    batch->enabled = enable;
+    batch->valid = false;
+}
+
+static void tgui_hit_batch_destroy(TGuiHitBatch *batch)
+{
+    free(batch->handles);
+    free(batch->min_x);
+    free(batch->min_y);
+    free(batch->max_x);
+    free(batch->max_y);
+    free(batch->hot);
+    free(batch->active);
+    free(batch->pressed);
+    free(batch->indices);
+    memset(batch, 0, sizeof(TGuiHitBatch));
+}
+
+// NOTE: the size is always a multiple of 32 so the bits of a widget are in the same word that the ones of its group
+static void tgui_hit_batch_grow(TGuiHitBatch *batch)
+{
+    u32 new_size = batch->size ? batch->size*2 : 64;
+    TGuiHandle *handles = (TGuiHandle *)malloc(new_size*sizeof(TGuiHandle));
+    f32 *min_x = (f32 *)malloc(new_size*sizeof(f32));
+    f32 *min_y = (f32 *)malloc(new_size*sizeof(f32));
+    f32 *max_x = (f32 *)malloc(new_size*sizeof(f32));
+    f32 *max_y = (f32 *)malloc(new_size*sizeof(f32));
+    u32 *hot = (u32 *)malloc(new_size/32*sizeof(u32));
+    u32 *active = (u32 *)malloc(new_size/32*sizeof(u32));
+    u32 *pressed = (u32 *)malloc(new_size/32*sizeof(u32));
+    TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, new_size*(sizeof(TGuiHandle) + 4*sizeof(f32)) + 3*new_size/32*sizeof(u32));
+    if(batch->size)
+    {
+        memcpy(handles, batch->handles, batch->count*sizeof(TGuiHandle));
+        memcpy(min_x, batch->min_x, batch->count*sizeof(f32));
+        memcpy(min_y, batch->min_y, batch->count*sizeof(f32));
+        memcpy(max_x, batch->max_x, batch->count*sizeof(f32));
+        memcpy(max_y, batch->max_y, batch->count*sizeof(f32));
+        free(batch->handles);
+        free(batch->min_x);
+        free(batch->min_y);
+        free(batch->max_x);
+        free(batch->max_y);
+        free(batch->hot);
+        free(batch->active);
+        free(batch->pressed);
+    }
+    batch->handles = handles;
+    batch->min_x = min_x;
+    batch->min_y = min_y;
+    batch->max_x = max_x;
+    batch->max_y = max_y;
+    batch->hot = hot;
+    batch->active = active;
+    batch->pressed = pressed;
+    batch->size = new_size;
+}
+
+// NOTE: the box is the same that the hot test of the update, the collision box and the visible part of the parent
+// are compare with the mouse one after the other so the box is the intersection of both
+static void tgui_hit_batch_push(TGuiHitBatch *batch, TGuiWidget *widget, TGuiV2 base_pos, TGuiRect *clip)
+{
+    if(batch->count == batch->size) tgui_hit_batch_grow(batch);
+    TGuiV2 abs_pos = tgui_v2_add(widget->header.position, base_pos);
+    TGuiRect box = widget->header.type == TGUI_BUTTON ?
+                   tgui_button_collision_box(&widget->button, abs_pos) :
+                   tgui_checkbox_collision_box(&widget->checkbox, abs_pos);
+    f32 min_x = box.x;
+    f32 min_y = box.y;
+    f32 max_x = box.x + box.width;
+    f32 max_y = box.y + box.height;
+    if(clip)
+    {
+        min_x = TGUI_MAX(min_x, clip->x);
+        min_y = TGUI_MAX(min_y, clip->y);
+        max_x = TGUI_MIN(max_x, clip->x + clip->width);
+        max_y = TGUI_MIN(max_y, clip->y + clip->height);
+    }
+    u32 index = batch->count++;
+    batch->handles[index] = widget->header.handle;
+    batch->min_x[index] = min_x;
+    batch->min_y[index] = min_y;
+    batch->max_x[index] = max_x;
+    batch->max_y[index] = max_y;
+    batch->indices[widget->header.handle] = index;
+}
+
+// NOTE: the position and the visible part of the container are the same for all its childs, so they are
+// calculate one time. The base is add from the container to the root, in the same order that tgui_widget_abs_pos
+static void tgui_hit_batch_push_childs(TGuiHitBatch *batch, TGuiWidget *container)
+{
+    TGuiV2 base_pos = {0};
+    TGuiWidget *parent = container;
+    while(parent)
+    {
+        base_pos = tgui_v2_add(base_pos, parent->header.position);
+        parent = tgui_widget_get(parent->header.parent);
+    }
+    TGuiRect clip = tgui_container_visible_rect(container);
+
+    TGuiWidget *child = tgui_widget_get(container->header.child_first);
+    while(child)
+    {
+        TGuiWidgetType type = child->header.type;
+        if(type == TGUI_CONTAINER) tgui_hit_batch_push_childs(batch, child);
+        else if(type == TGUI_BUTTON || type == TGUI_CHECKBOX) tgui_hit_batch_push(batch, child, base_pos, &clip);
+        child = tgui_widget_get(child->header.sibling_next);
+    }
+}
+
+static void tgui_hit_batch_build(TGuiState *state, TGuiHitBatch *batch)
+{
+    TGUI_PROFILE_BEGIN(hit_batch);
+    u32 handle_count = state->widget_allocator.count;
+    if(handle_count > batch->index_size)
+    {
+        free(batch->indices);
+        batch->index_size = handle_count*2;
+        batch->indices = (u32 *)malloc(batch->index_size*sizeof(u32));
+        TGUI_PROFILE_COUNT(TGUI_COUNTER_BYTES_ALLOCATED, batch->index_size*sizeof(u32));
+    }
+    batch->index_count = handle_count;
+    memset(batch->indices, 0xFF, handle_count*sizeof(u32));
+
+    batch->count = 0;
+    batch->layout_version = __atomic_load_n(&state->layout_version, __ATOMIC_RELAXED);
+    TGuiWidget *root = tgui_widget_get(state->first_root);
+    while(root)
+    {
+        TGuiWidgetType type = root->header.type;
+        if(type == TGUI_CONTAINER) tgui_hit_batch_push_childs(batch, root);
+        else if(type == TGUI_BUTTON || type == TGUI_CHECKBOX) tgui_hit_batch_push(batch, root, tgui_v2(0, 0), 0);
+        root = tgui_widget_get(root->header.sibling_next);
+    }
+    
+    // NOTE: the last group is fill with boxes that the mouse never hit, so the test dont need a tail
+    u32 real_count = batch->count;
+    while(batch->count & 31)
+    {
+        if(batch->count == batch->size) tgui_hit_batch_grow(batch);
+        batch->handles[batch->count] = TGUI_INVALID_HANDLE;
+        batch->min_x[batch->count] = 0;
+        batch->min_y[batch->count] = 0;
+        batch->max_x[batch->count] = 0;
+        batch->max_y[batch->count] = 0;
+        ++batch->count;
+    }
+    u32 word_count = batch->count / 32;
+    if(word_count)
+    {
+        memset(batch->active, 0, word_count*sizeof(u32));
+        memset(batch->pressed, 0, word_count*sizeof(u32));
+    }
+    for(u32 index = 0; index < real_count; ++index)
+    {
+        TGuiWidget *widget = tgui_widget_get(batch->handles[index]);
+        b32 active = widget->header.type == TGUI_BUTTON ? widget->button.active : widget->checkbox.active;
+        tgui_bit_set(batch->active, index, active);
+    }
+    batch->valid = true;
+    TGUI_PROFILE_END(hit_batch, timers[TGUI_TIMER_LAYOUT]);
+}
+
+// NOTE: build the batch if the layout change and hit test all the boxes against the mouse, 32 at the time
+static void tgui_hit_batch_begin(TGuiState *state)
+{
+    TGuiHitBatch *batch = &state->hit_batch;
+    if(!batch->valid || batch->layout_version != __atomic_load_n(&state->layout_version, __ATOMIC_RELAXED))
+    {
+        tgui_hit_batch_build(state, batch);
+    }
+    
+    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y);
+    u32 word_count = batch->count / 32;
+    for(u32 word_index = 0; word_index < word_count; ++word_index)
+    {
+        u32 first = word_index*32;
+        u32 hot = 0;
+#if TGUI_SSE2
+        __m128 mouse_x = _mm_set1_ps(mouse.x);
+        __m128 mouse_y = _mm_set1_ps(mouse.y);
+        for(u32 lane = 0; lane < 32; lane += 4)
+        {
+            u32 index = first + lane;
+            __m128 inside_x = _mm_and_ps(_mm_cmpge_ps(mouse_x, _mm_loadu_ps(batch->min_x + index)),
+                                         _mm_cmplt_ps(mouse_x, _mm_loadu_ps(batch->max_x + index)));
+            __m128 inside_y = _mm_and_ps(_mm_cmpge_ps(mouse_y, _mm_loadu_ps(batch->min_y + index)),
+                                         _mm_cmplt_ps(mouse_y, _mm_loadu_ps(batch->max_y + index)));
+            hot |= (u32)_mm_movemask_ps(_mm_and_ps(inside_x, inside_y)) << lane;
+        }
+#else
+        for(u32 lane = 0; lane < 32; ++lane)
+        {
+            u32 index = first + lane;
+            b32 inside = mouse.x >= batch->min_x[index] && mouse.x < batch->max_x[index] &&
+                         mouse.y >= batch->min_y[index] && mouse.y < batch->max_y[index];
+            hot |= (u32)inside << lane;
+        }
+#endif
+        batch->hot[word_index] = hot;
+        batch->pressed[word_index] = 0;
+    }
+    TGUI_PROFILE_COUNT(TGUI_COUNTER_HIT_TESTS, batch->count);
+}
+
+u32 tgui_get_pressed(TGuiHandle *handles, u32 max_count)
+{
+    TGuiHitBatch *batch = &tgui_global_state.hit_batch;
+    if(!batch->valid) return 0;
+    u32 count = 0;
+    for(u32 word_index = 0; word_index < batch->count / 32; ++word_index)
+    {
+        u32 pressed = batch->pressed[word_index];
+        while(pressed)
+        {
+            u32 index = word_index*32 + (u32)__builtin_ctz(pressed);
+            pressed &= pressed - 1;
+            if(count < max_count) handles[count] = batch->handles[index];
+            ++count;
+        }
+    }
+    return count;
+}
+
+//-----------------------------------------------------
+//  NOTE: optimizer functions
+//-----------------------------------------------------
+
+void tgui_optimizer_enable(b32 enable)
+{
+    tgui_global_state.optimizer.enabled = enable;
+}
+
+TGuiOptimizerStats tgui_get_optimizer_stats(void)
+{
+    return tgui_global_state.optimizer.stats;
+}
+
+// NOTE: the positions are float and the rasterizer truncate them, the clip tests use a pixel of margin
+inline static TGuiDamageRect tgui_optimizer_grow(TGuiDamageRect rect)
+{
+    return tgui_damage_rect(rect.min_x - 1, rect.min_y - 1, rect.max_x + 1, rect.max_y + 1);
+}
+
+// NOTE: only rects with integer positions are merged, so the merged rect write the same pixels
+static b32 tgui_optimizer_rect(TGuiDrawCommand *draw_cmd, TGuiDamageRect *rect)
+{
+    TGuiRect descriptor = draw_cmd->descriptor;
+    if(descriptor.x < 0 || descriptor.y < 0 || descriptor.width < 0 || descriptor.height < 0) return false;
+    if(descriptor.x != (f32)(i32)descriptor.x || descriptor.y != (f32)(i32)descriptor.y ||
+       descriptor.width != (f32)(i32)descriptor.width || descriptor.height != (f32)(i32)descriptor.height)
+    {
+        return false;
+    }
+    *rect = tgui_damage_rect((i32)descriptor.x, (i32)descriptor.y, (i32)descriptor.x + (i32)descriptor.width, (i32)descriptor.y + (i32)descriptor.height);
+    return true;
+}
+
+// NOTE: try to merge the command in the last command of the buffer, return true if it is merged
+static b32 tgui_optimizer_merge(TGuiState *state, TGuiDrawCommandBuffer *buffer, TGuiDrawCommand *last, TGuiDrawCommand *draw_cmd, TGuiOptimizerStats *stats)
+{
+    // NOTE: a merged command has only one handle, the commands of different widgets are not merged so the
+    // damage and the debug costs still see every widget
+    if(last->handle != draw_cmd->handle) return false;
+
+    if(last->type == TGUI_DRAWCMD_RECT && draw_cmd->type == TGUI_DRAWCMD_RECT)
+    {
+        TGuiDamageRect a, b;
+        if(!tgui_optimizer_rect(last, &a) || !tgui_optimizer_rect(draw_cmd, &b)) return false;
+        // NOTE: the rects are not blend, a rect that cover the last one overwrite all its pixels
+        if(tgui_damage_rect_contains(b, a))
+        {
+            *last = *draw_cmd;
+            ++stats->merged_rects;
+            return true;
+        }
+        if(last->color != draw_cmd->color) return false;
+        b32 merge = tgui_damage_rect_contains(a, b) ||
+                    (a.min_x == b.min_x && a.max_x == b.max_x && b.min_y <= a.max_y && a.min_y <= b.max_y) ||
+                    (a.min_y == b.min_y && a.max_y == b.max_y && b.min_x <= a.max_x && a.min_x <= b.max_x);
+        if(!merge) return false;
+        TGuiDamageRect rect = tgui_damage_rect_union(a, b);
+        last->descriptor = tgui_rect_xywh(rect.min_x, rect.min_y, rect.max_x - rect.min_x, rect.max_y - rect.min_y);
+        ++stats->merged_rects;
+        return true;
+    }
+
+    b32 last_text = last->type == TGUI_DRAWCMD_TEXT || last->type == TGUI_DRAWCMD_CHAR;
+    b32 text = draw_cmd->type == TGUI_DRAWCMD_TEXT || draw_cmd->type == TGUI_DRAWCMD_CHAR;
+    if(last_text && text)
+    {
+        // NOTE: the next run must start where the last one end, in the same line
+        u32 last_size = last->type == TGUI_DRAWCMD_TEXT ? last->text_size : 1;
+        u32 size = draw_cmd->type == TGUI_DRAWCMD_TEXT ? draw_cmd->text_size : 1;
+        if((i32)draw_cmd->descriptor.y != (i32)last->descriptor.y ||
+           (i32)draw_cmd->descriptor.x != (i32)last->descriptor.x + (i32)(state->font_width*last_size))
+        {
+            return false;
+        }
+        char *merged = (char *)tgui_arena_push(&buffer->arena, last_size + size);
+        if(last->type == TGUI_DRAWCMD_TEXT) memcpy(merged, last->text, last_size);
+        else merged[0] = (char)last->character;
+        if(draw_cmd->type == TGUI_DRAWCMD_TEXT) memcpy(merged + last_size, draw_cmd->text, size);
+        else merged[last_size] = (char)draw_cmd->character;
+        last->type = TGUI_DRAWCMD_TEXT;
+        last->text = merged;
+        last->text_size = last_size + size;
+        ++stats->merged_texts;
+        return true;
+    }
+    return false;
+}
+
+static void tgui_optimizer_run(TGuiState *state)
+{
+    TGuiOptimizer *optimizer = &state->optimizer;
+    TGuiDrawCommandBuffer *buffer = &state->draw_command_buffer;
+    TGuiOcclusion *occlusion = &buffer->occlusion;
+    TGuiOptimizerStats *stats = &optimizer->stats;
+    memset(stats, 0, sizeof(TGuiOptimizerStats));
+    stats->input = buffer->count;
+    stats->output = buffer->count;
+    if(!optimizer->enabled) return;
+
+    TGuiOptimizerScope scopes[TGUI_DAMAGE_SCOPES_MAX];
+    u32 depth = 1;
+    u32 ignored_depth = 0;
+    memset(scopes, 0, sizeof(scopes));
+    scopes[0].clip = tgui_damage_rect(0, 0, state->backbuffer->width, state->backbuffer->height);
+
+    // NOTE: the commands are compact in place, count is the size of the output
+    u32 count = 0;
+    u32 root_index = 0;
+    // NOTE: a command can only merge with the last one if there is nothing between them, and never with
+    // the command of other root (the roots can be draw in different rects by the occlusion culling)
+    b32 barrier = true;
+    u32 command_index = 0;
+    while(command_index < buffer->count)
+    {
+        while(root_index < occlusion->root_count && occlusion->roots[root_index].first <= command_index)
+        {
+            occlusion->roots[root_index++].first = count;
+            barrier = true;
+        }
+        TGuiDrawCommand draw_cmd = buffer->buffer[command_index++];
+        TGuiOptimizerScope *scope = scopes + depth - 1;
+        b32 push = true;
+        switch(draw_cmd.type)
+        {
+            case TGUI_DRAWCMD_START_CLIPPING:
+            case TGUI_DRAWCMD_BEGIN_LAYER:
+            {
+                if(ignored_depth || depth == TGUI_DAMAGE_SCOPES_MAX)
+                {
+                    ++ignored_depth;
+                    break;
+                }
+                TGuiRect descriptor = draw_cmd.descriptor;
+                TGuiDamageRect rect = tgui_damage_rect(descriptor.x, descriptor.y, (i32)descriptor.x + (i32)descriptor.width, (i32)descriptor.y + (i32)descriptor.height);
+                if(draw_cmd.type == TGUI_DRAWCMD_BEGIN_LAYER && !scope->keep_commands &&
+                   tgui_damage_rect_empty(tgui_damage_rect_intersect(tgui_optimizer_grow(rect), scope->clip)))
+                {
+                    // NOTE: all the layer is outside the clip
+                    u32 end_index = tgui_layer_end(buffer, command_index - 1, buffer->count);
+                    u32 next_index = end_index < buffer->count ? end_index + 1 : buffer->count;
+                    stats->culled += next_index - (command_index - 1);
+                    command_index = next_index;
+                    push = false;
+                    break;
+                }
+                TGuiOptimizerScope *next = scopes + depth++;
+                next->output_index = count;
+                next->layer = draw_cmd.type == TGUI_DRAWCMD_BEGIN_LAYER;
+                next->keep_commands = scope->keep_commands;
+                if(next->layer)
+                {
+                    // NOTE: the layer bitmap has all the container, not only the part inside the clip
+                    next->clip = rect;
+                    next->kept = true;
+                }
+                else
+                {
+                    if(state->damage.enabled && draw_cmd.scroll)
+                    {
+                        next->keep_commands = true;
+                    }
+                    next->clip = tgui_damage_rect_intersect(scope->clip, rect);
+                    next->kept = !tgui_damage_rect_contains(tgui_optimizer_grow(rect), scope->clip);
+                    if(!next->kept)
+                    {
+                        ++stats->collapsed_clips;
+                        push = false;
+                    }
+                }
+            } break;
+            case TGUI_DRAWCMD_END_CLIPPING:
+            case TGUI_DRAWCMD_END_LAYER:
+            {
+                if(ignored_depth)
+                {
+                    --ignored_depth;
+                    break;
+                }
+                if(depth == 1) break;
+                --depth;
+                if(!scope->kept)
+                {
+                    ++stats->collapsed_clips;
+                    push = false;
+                }
+                else if(!scope->layer && count == scope->output_index + 1)
+                {
+                    // NOTE: nothing is draw inside the clip
+                    --count;
+                    stats->collapsed_clips += 2;
+                    push = false;
+                }
+            } break;
+            case TGUI_DRAWCMD_RECT:
+            case TGUI_DRAWCMD_ROUNDED_RECT:
+            case TGUI_DRAWCMD_BITMAP:
+            case TGUI_DRAWCMD_CHAR:
+            case TGUI_DRAWCMD_TEXT:
+            case TGUI_DRAWCMD_SPANS:
+            {
+                b32 clipped;
+                TGuiClipResult bounds = tgui_draw_command_bounds(state, &draw_cmd, &clipped);
+                TGuiDamageRect rect = tgui_damage_rect(bounds.min_x, bounds.min_y, bounds.max_x, bounds.max_y);
+                if(tgui_damage_rect_empty(rect) ||
+                   (!scope->keep_commands && tgui_damage_rect_empty(tgui_damage_rect_intersect(tgui_optimizer_grow(rect), scope->clip))))
+                {
+                    ++stats->culled;
+                    push = false;
+                    break;
+                }
+                if(!barrier && tgui_optimizer_merge(state, buffer, buffer->buffer + count - 1, &draw_cmd, stats))
+                {
+                    push = false;
+                    break;
+                }
+                buffer->buffer[count++] = draw_cmd;
+                barrier = false;
+                push = false;
+            } break;
+            default: break;
+        }
+        if(push)
+        {
+            buffer->buffer[count++] = draw_cmd;
+            barrier = true;
+        }
+    }
+    while(root_index < occlusion->root_count)
+    {
+        occlusion->roots[root_index++].first = count;
+    }
+
+    buffer->count = count;
+    stats->output = count;
+    TGUI_PROFILE_COUNT(TGUI_COUNTER_OPTIMIZED_COMMANDS, stats->input - stats->output);
+}
+
+//-----------------------------------------------------
+//  NOTE: core library functions
+//-----------------------------------------------------
+
+void tgui_push_event(TGuiEvent event)
+{
+    TGuiState *state = &tgui_global_state;
+    if(state->event_queue.count < TGUI_EVENT_QUEUE_MAX)
+    {
+        state->event_queue.queue[state->event_queue.count++] = event;
+    }
+    else
+    {
+        TGUI_PROFILE_COUNT(TGUI_COUNTER_DROPPED_EVENTS, 1);
+    }
+}
+
+void tgui_push_draw_command(TGuiDrawCommand draw_cmd)
+{
+    TGuiState *state = &tgui_global_state;
+    if(state->draw_command_buffer.count< TGUI_DRAW_COMMANDS_MAX)
+    {
+        if(!draw_cmd.handle) draw_cmd.handle = state->render_handle;
+        // NOTE: the command own a copy of the text, widgets can change its text before the buffer is rasterize
+        if(draw_cmd.text && draw_cmd.text_size)
+        {
+            draw_cmd.text = (char *)tgui_arena_push_copy(&state->draw_command_buffer.arena, draw_cmd.text, draw_cmd.text_size);
+        }
+        state->draw_command_buffer.buffer[state->draw_command_buffer.count++] = draw_cmd;
+#if defined(TGUI_PROFILE)
+        ++state->profile.current.draw_commands[draw_cmd.type];
+#endif
+    }
+    else
+    {
+        TGUI_PROFILE_COUNT(TGUI_COUNTER_DROPPED_COMMANDS, 1);
+    }
+}
+
+b32 tgui_pull_draw_command(TGuiDrawCommand *draw_cmd)
+{
+    TGuiState *state = &tgui_global_state;
+    // NOTE: the buffer is not clear here, the commands stay valid until the next tgui_update
+    TGuiDrawCommandBuffer *buffer = &state->draw_command_buffer;
+    while(buffer->head < buffer->count && buffer->occlusion.culled[buffer->head]) ++buffer->head;
+    if(state->draw_command_buffer.head >= state->draw_command_buffer.count)
+    {
+        return false;
+    }
+    *draw_cmd = state->draw_command_buffer.buffer[state->draw_command_buffer.head++];
+    return true;
+}
+
+// NOTE: core lib functions
+void tgui_init(TGuiBitmap *backbuffer, TGuiFont *font)
+{
+    TGuiState *state = &tgui_global_state;
+    
+    memset(state, 0, sizeof(TGuiState));
+    state->backbuffer = backbuffer;
+    state->font = font;
+    state->font_height = 9;
+    f32 w_ration = (f32)font->src_rect.width / (f32)font->src_rect.height;
+    state->font_width = (u32)(w_ration * (f32)state->font_height + 0.5f);
+    
+    tgui_widget_poll_allocator_create(&state->widget_allocator);
+    tgui_draw_command_buffer_create(&state->draw_command_buffer);
+    tgui_arena_create(&state->snapshot_strings);
+    
+    tgui_clipping_stack_create(&global_clipping_stack);
+    tgui_clipping_stack_push(&global_clipping_stack, tgui_rect_xywh(0, 0, backbuffer->width, backbuffer->height));
+}
+
+void tgui_terminate(void)
+{
+    TGuiState *state = &tgui_global_state;
+    // NOTE: the last frame is draw and present before the rasterizer state is release
+    tgui_pipeline_end();
+    tgui_jobs_end();
+    free(state->jobs.roots);
+    memset(&state->jobs, 0, sizeof(TGuiJobs));
+    tgui_record_end();
+    tgui_timeline_end();
+    tgui_debug_cost_enable(false);
+    tgui_damage_enable(false);
+    tgui_layer_cache_destroy(&state->layers);
+    tgui_clipping_stack_destoy(&global_clipping_stack);
+    tgui_draw_command_buffer_destroy(&state->draw_command_buffer);
+    tgui_arena_destroy(&state->snapshot_strings);
+    // NOTE: the widgets that are still alive own memory (layers, text buffers) and threads
+    u32 free_count = 0;
+    u8 *free_map = tgui_widget_allocator_free_map(&state->widget_allocator, &free_count);
+    for(TGuiHandle handle = 1; handle < state->widget_allocator.count; ++handle)
+    {
+        if(!free_map[handle]) tgui_widget_release_resources(state->widget_allocator.buffer + handle);
+    }
+    free(free_map);
+    tgui_widget_allocator_destroy(&state->widget_allocator);
+    // NOTE: the release of the custom widgets use the registry
+    free(state->registry.classes);
+    memset(&state->registry, 0, sizeof(TGuiWidgetRegistry));
+    tgui_hit_batch_destroy(&state->hit_batch);
+}
+
+static void tgui_jobs_layout_roots(TGuiState *state);
+
+TGuiUpdateResult tgui_update(void)
+{
+    TGuiState *state = &tgui_global_state;
+    state->time = state->fixed_time > 0 ? state->fixed_time : tgui_platform_get_time();
+    state->deadline = 0;
+    if(state->recorder.file)
+    {
+        tgui_record_frame(state);
+    }
+#if defined(TGUI_PROFILE)
+    tgui_profile_next_frame(state);
+    if(state->timeline.file)
+    {
+        tgui_timeline_flush(state);
+    }
+#endif
+    // NOTE: start a new frame, the last frame commands and its memory are release here
+    tgui_draw_command_buffer_clear(&state->draw_command_buffer);
+    state->draw_command_buffer.handle_count = state->widget_allocator.count;
+    // NOTE: clear old state that are not needed any more
+    state->mouse_up = false;
+    state->mouse_down = false;
+    state->last_mouse_x = state->mouse_x;
+    state->last_mouse_y = state->mouse_y;
+    // NOTE: pull tgui events from the queue
+    TGUI_PROFILE_BEGIN(events);
+    for(u32 event_index = 0; event_index < state->event_queue.count; ++event_index)
+    {
+        TGuiEvent *event = state->event_queue.queue + event_index;
+        switch(event->type)
         {
-            textbox->cursor_position.x = next_line->count;
+            case TGUI_EVENT_KEYDOWN:
+            {
+                // TODO: check where is the best place to update the active textbox
+                if(state->widget_active)
+                {
+                    TGuiWidget *widget = tgui_widget_get(state->widget_active);
+                    if(widget->header.type == TGUI_TEXTBOX)
+                    {
+                        if(event->key.keycode == TGUI_KEYCODE_ENTER)
+                        {
+                            tgui_textbox_push_newline(&widget->textbox);
+                        }
+                        else if(event->key.keycode == TGUI_KEYCODE_BACKSPACE)
+                        {
+                            tgui_textbox_delete_current_character(&widget->textbox);
+                        }
+                        else if(event->key.keycode == TGUI_KEYCODE_LEFT)
+                        {
+                            tgui_textbox_move_cursor_left(&widget->textbox); 
+                        }
+                        else if(event->key.keycode == TGUI_KEYCODE_RIGHT)
+                        {
+                            tgui_textbox_move_cursor_right(&widget->textbox); 
+                        }
+                        else if(event->key.keycode == TGUI_KEYCODE_UP)
+                        {
+                            tgui_textbox_move_cursor_up(&widget->textbox); 
+                        }
+                        else if(event->key.keycode == TGUI_KEYCODE_DOWN)
+                        {
+                            tgui_textbox_move_cursor_down(&widget->textbox); 
+                        }
+                        tgui_textbox_scroll_to_cursor(state, &widget->textbox);
+                        widget->textbox.blink_start = state->time;
+                    }
+                    else if(widget->header.type == TGUI_TEXTVIEW)
+                    {
+                        i64 lines = 0;
+                        i32 columns = 0;
+                        if(event->key.keycode == TGUI_KEYCODE_UP) lines = -1;
+                        else if(event->key.keycode == TGUI_KEYCODE_DOWN) lines = 1;
+                        else if(event->key.keycode == TGUI_KEYCODE_LEFT) columns = -1;
+                        else if(event->key.keycode == TGUI_KEYCODE_RIGHT) columns = 1;
+                        tgui_textview_scroll(&widget->textview, lines, columns);
+                    }
+                    else if(widget->header.type == TGUI_GRID)
+                    {
+                        i64 rows = 0;
+                        i32 columns = 0;
+                        if(event->key.keycode == TGUI_KEYCODE_UP) rows = -1;
+                        else if(event->key.keycode == TGUI_KEYCODE_DOWN) rows = 1;
+                        else if(event->key.keycode == TGUI_KEYCODE_LEFT) columns = -1;
+                        else if(event->key.keycode == TGUI_KEYCODE_RIGHT) columns = 1;
+                        tgui_grid_scroll(&widget->grid, rows, columns);
+                    }
+                    else if(widget->header.type == TGUI_TREE)
+                    {
+                        if(event->key.keycode == TGUI_KEYCODE_UP) tgui_tree_scroll(&widget->tree, -1);
+                        else if(event->key.keycode == TGUI_KEYCODE_DOWN) tgui_tree_scroll(&widget->tree, 1);
+                    }
+                }
+            } break;
+            case TGUI_EVENT_KEYUP:
+            {
+            } break;
+            case TGUI_EVENT_MOUSEMOVE:
+            {
+                TGuiEventMouseMove *mouse = (TGuiEventMouseMove *)event;
+                state->mouse_x = mouse->pos_x;
+                state->mouse_y = mouse->pos_y;
+            } break;
+            case TGUI_EVENT_MOUSEDOWN:
+            {
+                state->mouse_down = true;
+                state->mouse_is_down = true;
+            } break;
+            case TGUI_EVENT_MOUSEUP:
+            {
+                state->mouse_up = true;
+                state->mouse_is_down = false;
+            } break;
+            case TGUI_EVENT_CHAR:
+            {
+                if(state->widget_active)
+                {
+                    TGuiWidget *widget = tgui_widget_get(state->widget_active);
+                    if(widget->header.type == TGUI_TEXTBOX)
+                    {
+                        if((event->character.character >= ' ') && (event->character.character <= '~'))
+                        {
+                            tgui_textbox_push_character(&widget->textbox, event->character.character);
+                            tgui_textbox_scroll_to_cursor(state, &widget->textbox);
+                            widget->textbox.blink_start = state->time;
+                        }
+                    }
+                }
+            } break;
+            case TGUI_EVENT_COUNT:
+            {
+                ASSERT(!"invalid path code\n");
+            } break;
         }
-        ++textbox->cursor_position.y;
     }
-}
-
-static void tgui_textbox_push_character(TGuiWidgetTextBox *textbox, u8 character)
-{
-    TGuiCharacterAllocator *line = textbox->allocator.buffer + textbox->cursor_position.y;
-    u8 *last_character = tgui_character_allocator_pull(line);
-    if((u32)textbox->cursor_position.x < (line->count - 1))
+    state->event_queue.count = 0;
+    TGUI_PROFILE_END(events, timers[TGUI_TIMER_EVENTS]);
+    
+    TGuiWidgetFP update = tgui_widget_update;
+    TGuiWidgetFP render = tgui_widget_render;
+#if defined(TGUI_PROFILE)
+    // NOTE: with the timeline open every widget has its own span
+    if(state->timeline.file)
     {
-        u8 *current_character = line->buffer + textbox->cursor_position.x;
-        tgui_safe_memcpy(current_character + 1, current_character, (u64)(last_character - current_character));
-        *current_character = character;
+        update = tgui_widget_update_span;
+        render = tgui_widget_render_span;
     }
-    else
+#endif
+    // NOTE: with the workers the roots are lay out in parallel first. With an active widget only it is
+    // update, so the layout is leave to its update
+    state->jobs.layout_done = false;
+    if(state->jobs.threads && !state->widget_active)
     {
-        *last_character = character;
+        tgui_jobs_layout_roots(state);
     }
-    
-    textbox->cursor_position.x++;
-}
-
-static void tgui_textbox_push_newline(TGuiWidgetTextBox *textbox)
-{
-    TGuiCharacterAllocator *last_line = tgui_line_allocator_pull(&textbox->allocator);
-    TGuiCharacterAllocator temp_last_line = *last_line;
-    TGuiCharacterAllocator *current_line = textbox->allocator.buffer + textbox->cursor_position.y;
-    TGuiCharacterAllocator *next_line = current_line + 1;
-    
-    tgui_safe_memcpy(next_line, current_line, ((u8 *)last_line - (u8 *)current_line));
-    *next_line = temp_last_line;
-    u32 characters_to_move = current_line->count - textbox->cursor_position.x;
-    // TODO: this move can be faster if we allocate the necesary space at once and the memcpy
-    for(u32 character_index = characters_to_move; character_index > 0; --character_index)
+    // NOTE: the buttons and checkboxes take the hot test from the batch, after the layout so the boxes are the last ones
+    if(state->hit_batch.enabled)
     {
-        u8 *character = tgui_character_allocator_pull(next_line);
-        *character = current_line->buffer[current_line->count - character_index];
+        tgui_hit_batch_begin(state);
     }
-    current_line->count -= characters_to_move;
-    
-    textbox->cursor_position.y++;
-    textbox->cursor_position.x = 0;
+    // NOTE: update all widget in the state widget tree
+    TGUI_PROFILE_BEGIN(update);
+    tgui_widget_recursive_descent_pos_first_to_last(state->first_root, update);
+    TGUI_PROFILE_END(update, timers[TGUI_TIMER_UPDATE]);
+    TGUI_PROFILE_BEGIN(render);
+    state->draw_command_buffer.occlusion.root_count = 0;
+    state->draw_command_buffer.occlusion.overflow = false;
+    tgui_widget_recursive_descent_pre_last_to_first(state->last_root, render);
+    state->render_handle = TGUI_INVALID_HANDLE;
+    tgui_optimizer_run(state);
+    tgui_occlusion_cull(state);
+    TGUI_PROFILE_END(render, timers[TGUI_TIMER_RENDER]);
+
+    state->recorder.update_count = state->draw_command_buffer.count;
+
+    TGuiUpdateResult result;
+    result.deadline = state->deadline;
+    return result;
 }
 
-static void tgui_textbox_delete_current_character(TGuiWidgetTextBox *textbox)
+// NOTE: call after the host push its commands. The frame only need to be draw if the commands (of the
+// update and of the host) are not the same as the ones of the last frame that changed
+b32 tgui_frame_changed(void)
 {
-    if(textbox->cursor_position.x > 0)
-    {
-        TGuiCharacterAllocator *line = textbox->allocator.buffer + textbox->cursor_position.y;
-        u8 *last_character = line->buffer + line->count;
-        u8 *current_character = line->buffer + textbox->cursor_position.x;
-        u8 *prev_character = current_character - 1;
-        tgui_safe_memcpy(prev_character, current_character, (u64)(last_character - current_character));
-        textbox->cursor_position.x--;
-        line->count--;
-    }
-    else if((textbox->cursor_position.x == 0) && (textbox->cursor_position.y > 0))
-    {
-        TGuiCharacterAllocator *current_line = textbox->allocator.buffer + textbox->cursor_position.y;
-        TGuiCharacterAllocator *prev_line = current_line - 1;
-        // TODO: this move can be faster if we allocate the necesary space at once and the memcpy
-        for(u32 character_index = 0; character_index < current_line->count; ++character_index)
-        {
-            u8 *character = tgui_character_allocator_pull(prev_line);
-            *character = current_line->buffer[character_index];
-        }
-        textbox->cursor_position.x = prev_line->count - current_line->count;
-        textbox->cursor_position.y--;
-        
-        TGuiCharacterAllocator *last_line = textbox->allocator.buffer + textbox->allocator.count;
-        if(current_line < (last_line - 1))
-        {
-            TGuiCharacterAllocator temp_current_line = *current_line;
-            TGuiCharacterAllocator *next_line = current_line + 1;
-            tgui_safe_memcpy(current_line, next_line, ((u8 *)last_line - (u8 *)next_line));
-            TGuiCharacterAllocator *real_last_line = (last_line - 1);
-            *real_last_line = temp_current_line;
-        }
-        textbox->allocator.count--;
-    }
+    TGuiState *state = &tgui_global_state;
+    u64 frame_hash = tgui_draw_command_buffer_hash(&state->draw_command_buffer);
+    b32 changed = frame_hash != state->frame_hash;
+    state->frame_hash = frame_hash;
+    return changed;
 }
 
-static b32 tgui_textbox_update(TGuiState *state, TGuiWidgetTextBox *textbox)
-{
-    TGuiV2 mouse = tgui_v2(state->mouse_x, state->mouse_y); 
-    TGuiV2 widget_abs_pos = tgui_widget_abs_pos(textbox->header.handle);
+static void tgui_raster_range(TGuiState *state, TGuiDrawCommandBuffer *buffer, u32 first_index, u32 last_index, TGuiBitmap *target);
 
-    TGuiRect text_box = {0};
-    text_box.pos = widget_abs_pos;
-    text_box.dim = textbox->header.size;
-    if(tgui_point_inside_rect(mouse, text_box))
+// NOTE: draw the layer that start at begin_index. If its commands are the same as the ones in the bitmap
+// of the container the bitmap is only copy, if not the commands are draw first into the bitmap.
+// The layers are find by the handle of the BEGIN_LAYER command, the rasterizer dont read the widgets.
+// Commands without handle (replayed traces) are draw directly
+static void tgui_raster_layer(TGuiState *state, TGuiDrawCommandBuffer *buffer, u32 begin_index, u32 end_index, TGuiBitmap *target)
+{
+    TGuiDrawCommand *begin_layer = buffer->buffer + begin_index;
+    if(!begin_layer->handle)
     {
-        textbox->hot = true;
+        tgui_raster_range(state, buffer, begin_index + 1, end_index, target);
+        return;
     }
-    else
+    i32 layer_x = (i32)begin_layer->descriptor.x;
+    i32 layer_y = (i32)begin_layer->descriptor.y;
+    u32 width = (u32)begin_layer->descriptor.width;
+    u32 height = (u32)begin_layer->descriptor.height;
+    if(!width || !height) return;
+
+    u64 hash = 0xCBF29CE484222325ull;
+    for(u32 command_index = begin_index + 1; command_index < end_index; ++command_index)
     {
-        textbox->hot = false;
+        hash = tgui_draw_command_hash(hash, buffer->buffer + command_index, layer_x, layer_y);
     }
-
-    if(textbox->hot && state->mouse_down)
+    
+    TGuiLayer *cached = tgui_layer_cache_get(&state->layers, begin_layer->handle);
+    TGuiBitmap *layer = &cached->bitmap;
+    if(layer->width != width || layer->height != height)
     {
-        state->widget_active = textbox->header.handle;
+        free(layer->pixels);
+        layer->width = width;
+        layer->height = height;
+        layer->pitch = width*sizeof(u32);
+        layer->pixels = (u32 *)malloc((u64)width*height*sizeof(u32));
+        cached->hash = 0;
     }
-    
-    if(state->mouse_up && !tgui_point_inside_rect(mouse, text_box))
+    if(cached->hash != hash)
     {
-        state->widget_active = TGUI_INVALID_HANDLE;
+        // NOTE: the view of the layer has the origin of the backbuffer, so the commands are draw with the
+        // same positions (and the same pixels) than without layer. The layer has its own clipping stack
+        // so the view is never write outside the bitmap
+        TGuiBitmap view = *layer;
+        view.pixels = (u32 *)((u8 *)layer->pixels - (i64)layer_y*layer->pitch) - layer_x;
+        TGuiClippingStack clipping_stack = global_clipping_stack;
+        tgui_clipping_stack_create(&global_clipping_stack);
+        tgui_clipping_stack_push(&global_clipping_stack, tgui_rect_xywh(layer_x, layer_y, width, height));
+        tgui_draw_rect(&view, layer_x, layer_y, layer_x + width, layer_y + height, 0);
+        tgui_raster_range(state, buffer, begin_index + 1, end_index, &view);
+        tgui_clipping_stack_destoy(&global_clipping_stack);
+        global_clipping_stack = clipping_stack;
+        cached->hash = hash;
+        TGUI_RASTER_COUNT(TGUI_COUNTER_LAYER_REDRAWS, 1);
     }
-    
-    if(textbox->hot) return true;
-    
-    return false;
+    // NOTE: the pixels that the container dont cover (corner of the grips) are transparent
+    tgui_copy_bitmap_alpha(target, layer, layer_x, layer_y);
 }
 
-b32 tgui_widget_update(TGuiHandle handle)
+// NOTE: draw the command at command_index into target and return the index of the next command,
+// a layer is draw all at once
+static u32 tgui_raster_command(TGuiState *state, TGuiDrawCommandBuffer *buffer, u32 command_index, u32 last_index, TGuiBitmap *target)
 {
-    TGuiState *state = &tgui_global_state;
-    TGuiWidget *widget = tgui_widget_get(handle);
-
-    if(!tgui_widget_is_active(handle))
-    {
-        return false;
-    }
-    
-    if(state->widget_active == handle)
+    TGuiDrawCommand draw_cmd = buffer->buffer[command_index];
+    switch(draw_cmd.type)
     {
-        tgui_container_set_to_top(widget);
-    }
-    
-    switch(widget->header.type)
-    {
-        case TGUI_CONTAINER:
+        case TGUI_DRAWCMD_CLEAR:
         {
-            // TODO: IMPORTANT: with orverlapping scrollbars get pick the one inside container need to consiget the scrollbar in the dimensionbox
-            b32 result = tgui_container_update(state, &widget->container);
-            tgui_container_update_scroll(state, &widget->container);
-            tgui_container_update_dragg_position(state, &widget->container);
-            return result;
-        }break;
-        case TGUI_END_CONTAINER:
+            // NOTE: with damage or inside a layer the clear only write inside the clipping rect
+            if(state->damage.enabled || target != state->backbuffer)
+            {
+                tgui_draw_rect(target, 0, 0, state->backbuffer->width, state->backbuffer->height, 0);
+            }
+            else
+            {
+                tgui_clear_backbuffer(target);
+            }
+        } break;
+        case TGUI_DRAWCMD_START_CLIPPING:
         {
-            return false;
-        }break;
-        case TGUI_BUTTON:
+            tgui_clipping_stack_push(&global_clipping_stack, draw_cmd.descriptor);
+        } break;
+        case TGUI_DRAWCMD_END_CLIPPING:
         {
-            b32 result = tgui_button_update(state, &widget->button);
-            return result;
-        }break;
-        case TGUI_CHECKBOX:
+            tgui_clipping_stack_pop(&global_clipping_stack);
+        } break;
+        case TGUI_DRAWCMD_RECT:
         {
-            b32 result = tgui_checkbox_update(state, &widget->checkbox);
-            return result;
-        }break;
-        case TGUI_SLIDER:
+            // NOTE: the position can be negative when the container is partially out of the screen
+            i32 min_x = (i32)draw_cmd.descriptor.x;
+            i32 min_y = (i32)draw_cmd.descriptor.y;
+            i32 max_x = min_x + (i32)draw_cmd.descriptor.width;
+            i32 max_y = min_y + (i32)draw_cmd.descriptor.height;
+            tgui_draw_rect(target, min_x, min_y, max_x, max_y, draw_cmd.color);
+        } break;
+        case TGUI_DRAWCMD_ROUNDED_RECT:
         {
-            b32 result = tgui_slider_update(state, &widget->slider);
-            return result;
-        }break;
-        case TGUI_TEXTBOX:
+            i32 max_x = draw_cmd.descriptor.x + draw_cmd.descriptor.width;
+            i32 max_y = draw_cmd.descriptor.y + draw_cmd.descriptor.height;
+            tgui_draw_rounded_rect(target, draw_cmd.descriptor.x, draw_cmd.descriptor.y, max_x, max_y, draw_cmd.color, draw_cmd.ratio);
+        } break;
+        case TGUI_DRAWCMD_BITMAP:
         {
-            b32 result = tgui_textbox_update(state, &widget->textbox);
-            return result;
-        }break;
-        case TGUI_COUNT:
+            tgui_draw_bitmap(target, draw_cmd.bitmap, draw_cmd.descriptor.x, draw_cmd.descriptor.y, draw_cmd.descriptor.width, draw_cmd.descriptor.height);
+        } break;
+        case TGUI_DRAWCMD_CHAR:
         {
-            ASSERT(!"invalid code path");
-        }break;
-    }
-
-    return false;
-}
-
-b32 tgui_widget_render(TGuiHandle handle)
-{
-    // TODO: refactor tgui_widget_render
-
-    TGuiWidget *widget = tgui_widget_get(handle);
-    TGuiV2 widget_abs_pos = tgui_widget_abs_pos(handle);
-    
-    switch(widget->header.type)
-    {
-        case TGUI_CONTAINER:
-        {
-            TGuiDrawCommand draw_cmd = {0};
-            draw_cmd.type = TGUI_DRAWCMD_RECT;
-            u32 color = TGUI_DRAK_BLACK;
-            if(widget->container.flags & TGUI_CONTAINER_DYNAMIC) color = TGUI_BLACK;
-            draw_cmd.descriptor.pos = widget_abs_pos;
-            // TODO: maybe create a tgui_get_container_dimension function
-            draw_cmd.descriptor.dim = widget->container.dimension;
-            draw_cmd.color = color;
-            tgui_push_draw_command(draw_cmd);
-            
-            if(widget->container.flags & TGUI_CONTAINER_V_SCROLL)
-            {
-                TGuiDrawCommand back_grip_cmd = {0};
-                back_grip_cmd.type = TGUI_DRAWCMD_RECT;
-                back_grip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, widget->container.vertical_grip.pos);
-                back_grip_cmd.descriptor.dim = widget->container.vertical_grip.dim;
-                back_grip_cmd.color = TGUI_ORANGE;
-                tgui_push_draw_command(back_grip_cmd);
-
-                TGuiDrawCommand grip_cmd = {0};
-                grip_cmd.type = TGUI_DRAWCMD_RECT;
-                grip_cmd.ratio = 4;
-
-                TGuiV2 grip_pos = widget->container.vertical_grip.pos;
-                grip_cmd.descriptor.dim = widget->container.vertical_grip.dim;
-                if(widget->container.total_dimension.y)
-                {
-                    f32 grip_ratio = (widget->container.dimension.y / widget->container.total_dimension.y);
-                    if(grip_ratio > 1.0f) grip_ratio = 1.0f; 
-                    grip_cmd.descriptor.dim.y = grip_ratio * widget->container.vertical_grip.height;
-                }
-                grip_pos.y = widget->container.vertical_value * (widget->container.dimension.y - grip_cmd.descriptor.dim.y);
-                grip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, grip_pos);
-                grip_cmd.color = TGUI_GREEN;
-                tgui_push_draw_command(grip_cmd);
-            }
-            if(widget->container.flags & TGUI_CONTAINER_H_SCROLL)
-            {
-                TGuiDrawCommand back_grip_cmd = {0};
-                back_grip_cmd.type = TGUI_DRAWCMD_RECT;
-                back_grip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, widget->container.horizontal_grip.pos);
-                back_grip_cmd.descriptor.dim = widget->container.horizontal_grip.dim;
-                back_grip_cmd.color = TGUI_ORANGE;
-                tgui_push_draw_command(back_grip_cmd);
-
-                TGuiDrawCommand grip_cmd = {0};
-                grip_cmd.type = TGUI_DRAWCMD_RECT;
-                grip_cmd.ratio = 4;
-
-                TGuiV2 grip_pos = widget->container.horizontal_grip.pos;
-                grip_cmd.descriptor.dim = widget->container.horizontal_grip.dim;
-                if(widget->container.total_dimension.x)
-                {
-                    f32 grip_ratio = (widget->container.dimension.x / widget->container.total_dimension.x);
-                    if(grip_ratio > 1.0f) grip_ratio = 1.0f; 
-                    grip_cmd.descriptor.dim.x = grip_ratio  * widget->container.horizontal_grip.width;
-                }
-                grip_pos.x = widget->container.horizontal_value * (widget->container.dimension.x - grip_cmd.descriptor.dim.x);
-                grip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, grip_pos);
-                grip_cmd.color = TGUI_GREEN;
-                tgui_push_draw_command(grip_cmd);
-            }
-
-            TGuiDrawCommand start_clip_cmd = {0};
-            start_clip_cmd.type = TGUI_DRAWCMD_START_CLIPPING;
-            start_clip_cmd.descriptor.pos = widget_abs_pos;
-            start_clip_cmd.descriptor.dim = widget->container.dimension;
-            tgui_push_draw_command(start_clip_cmd);
+            tgui_draw_char(target, state->font, state->font_height, draw_cmd.descriptor.x, draw_cmd.descriptor.y, draw_cmd.character);
         } break;
-        case TGUI_END_CONTAINER:
+        case TGUI_DRAWCMD_TEXT:
         {
-            TGuiDrawCommand end_clip_cmd = {0};
-            end_clip_cmd.type = TGUI_DRAWCMD_END_CLIPPING;
-            tgui_push_draw_command(end_clip_cmd);
+            tgui_draw_text(target, state->font, state->font_height, draw_cmd.descriptor.x, draw_cmd.descriptor.y, draw_cmd.text, draw_cmd.text_size);
         } break;
-        case TGUI_BUTTON:
+        case TGUI_DRAWCMD_BEGIN_LAYER:
         {
-            TGuiDrawCommand draw_cmd = {0};
-            draw_cmd.type = TGUI_DRAWCMD_RECT;
-            draw_cmd.descriptor.pos = widget_abs_pos;
-            draw_cmd.descriptor.dim = widget->header.size;
-            
-            TGuiWidgetButton *button_data = &widget->button;
-            u32 color = TGUI_GREY;
-            if(widget->button.hot) color = TGUI_ORANGE;
-            if(widget->button.active) color = TGUI_GREEN;
-            if(widget->button.pressed) color = TGUI_RED;
-            draw_cmd.color = color;
-            tgui_push_draw_command(draw_cmd);
-                
-            TGuiRect text_rect;
-            text_rect.dim = button_data->text.size;
-            text_rect.pos = tgui_v2_sub(tgui_v2_add(widget_abs_pos, tgui_v2_scale(button_data->header.size, 0.5f)), tgui_v2_scale(button_data->text.size, 0.5f));
-
-            TGuiDrawCommand text_cmd = {0};
-            text_cmd.type = TGUI_DRAWCMD_TEXT;
-            text_cmd.descriptor = text_rect;
-            text_cmd.text = button_data->text.text;
-            text_cmd.text_size = strlen(button_data->text.text);
-            tgui_push_draw_command(text_cmd);
-        
+            u32 end_index = tgui_layer_end(buffer, command_index, last_index);
+            tgui_raster_layer(state, buffer, command_index, end_index, target);
+            return end_index < last_index ? end_index + 1 : last_index;
         } break;
-        case TGUI_CHECKBOX:
+        case TGUI_DRAWCMD_END_LAYER:
         {
-            TGuiDrawCommand draw_cmd = {0};
-            draw_cmd.type = TGUI_DRAWCMD_RECT;
-            
-            TGuiWidgetCheckBox *checkbox_data = &widget->checkbox;
-            draw_cmd.descriptor.pos = widget_abs_pos;
-            draw_cmd.descriptor.dim = checkbox_data->box_dimension;
-            draw_cmd.ratio = 4;
-
-            u32 color = TGUI_RED; 
-            if(checkbox_data->checked)
-            {
-                color = TGUI_GREEN;
-            }
-            draw_cmd.color = color;
-            tgui_push_draw_command(draw_cmd);
-                
-            TGuiRect text_rect;
-            text_rect.dim = checkbox_data->text.size;
-            text_rect.pos = widget_abs_pos;
-            text_rect.pos.y += checkbox_data->box_dimension.y*0.5f - checkbox_data->text.size.y*0.5f;
-            text_rect.pos.x += checkbox_data->box_dimension.x + 5;
-            TGuiDrawCommand text_cmd = {0};
-            text_cmd.type = TGUI_DRAWCMD_TEXT;
-            text_cmd.descriptor = text_rect;
-            text_cmd.text = checkbox_data->text.text;
-            text_cmd.text_size = strlen(checkbox_data->text.text);
-            tgui_push_draw_command(text_cmd);
         } break;
-        case TGUI_SLIDER:
-        {
-            TGuiDrawCommand line_cmd = {0};
-            line_cmd.type = TGUI_DRAWCMD_RECT;
-            line_cmd.descriptor.pos = widget_abs_pos;
-            line_cmd.descriptor.pos.y += (widget->header.size.y * (0.5f*widget->slider.ratio));
-            line_cmd.descriptor.dim = widget->header.size;
-            line_cmd.descriptor.dim.y *= widget->slider.ratio;
-            line_cmd.color = TGUI_ORANGE;
-            tgui_push_draw_command(line_cmd);
-
-            TGuiWidgetSlider *slider_data = &widget->slider;
-            TGuiDrawCommand draw_cmd = {0};
-            draw_cmd.type = TGUI_DRAWCMD_RECT;
-            draw_cmd.descriptor.pos = widget_abs_pos;
-            draw_cmd.descriptor.dim = slider_data->grip_dimension;
-            draw_cmd.descriptor.x += (slider_data->value * widget->header.size.x) - (0.5f*widget->slider.grip_dimension.x);
-            draw_cmd.ratio = 4;
-            draw_cmd.color = TGUI_GREY;
-            tgui_push_draw_command(draw_cmd);
+        case TGUI_DRAWCMD_SPANS:
+        {
+            tgui_draw_spans(target, draw_cmd.descriptor.x, draw_cmd.descriptor.y, draw_cmd.descriptor.height,
+                            (TGuiSpan *)draw_cmd.text, draw_cmd.text_size / sizeof(TGuiSpan), draw_cmd.color);
         } break;
-        case TGUI_TEXTBOX:
-        {
-            TGuiDrawCommand draw_cmd = {0};
-            draw_cmd.type = TGUI_DRAWCMD_RECT;
-            draw_cmd.descriptor.pos = widget_abs_pos;
-            draw_cmd.descriptor.dim = widget->header.size;
-            draw_cmd.color = TGUI_DRAK_BLACK;
-            tgui_push_draw_command(draw_cmd);
-
-            TGuiDrawCommand start_clip_cmd = {0};
-            start_clip_cmd.type = TGUI_DRAWCMD_START_CLIPPING;
-            start_clip_cmd.descriptor.pos = tgui_v2_add(widget_abs_pos, tgui_v2(widget->textbox.margin, widget->textbox.margin));
-            start_clip_cmd.descriptor.dim = widget->textbox.dimension;
-            tgui_push_draw_command(start_clip_cmd);
-    
-            TGuiState *state = &tgui_global_state;
-            for(u32 line_index = 0; line_index < widget->textbox.allocator.count; ++line_index)
-            {
-                TGuiCharacterAllocator *line = widget->textbox.allocator.buffer + line_index;
-                TGuiDrawCommand text_cmd = {0};
-                text_cmd.type = TGUI_DRAWCMD_TEXT;
-                text_cmd.descriptor.x = widget_abs_pos.x + widget->textbox.margin;
-                text_cmd.descriptor.y = widget_abs_pos.y + (state->font_height * line_index) + widget->textbox.margin;
-                text_cmd.text = (char *)line->buffer;
-                text_cmd.text_size = line->count;
-                tgui_push_draw_command(text_cmd);
-            }
-            
-            TGuiDrawCommand cursor_cmd = {0};
-            cursor_cmd.type = TGUI_DRAWCMD_RECT;
-            cursor_cmd.descriptor.x = widget_abs_pos.x + (state->font_width *  widget->textbox.cursor_position.x) + widget->textbox.margin;
-            cursor_cmd.descriptor.y = widget_abs_pos.y + (state->font_height * widget->textbox.cursor_position.y) + widget->textbox.margin;
-            cursor_cmd.descriptor.width = 2;
-            cursor_cmd.descriptor.height = state->font_height;
-            cursor_cmd.color = TGUI_GREEN;
-            tgui_push_draw_command(cursor_cmd);
-
-            TGuiDrawCommand end_clip_cmd = {0};
-            end_clip_cmd.type = TGUI_DRAWCMD_END_CLIPPING;
-            tgui_push_draw_command(end_clip_cmd);
-        }break;
-        case TGUI_COUNT:
+        case TGUI_DRAWCMD_COUNT:
         {
             ASSERT(!"invalid code path");
         } break;
     }
-    return false;
+    return command_index + 1;
 }
 
-//-----------------------------------------------------
-// NOTE: recursive functions TODO: change to use STAKS
-//-----------------------------------------------------
-b32 tgui_widget_recursive_descent_pre_first_to_last(TGuiHandle handle, TGuiWidgetFP function)
+static void tgui_raster_range(TGuiState *state, TGuiDrawCommandBuffer *buffer, u32 first_index, u32 last_index, TGuiBitmap *target)
 {
-    TGuiWidget *widget = tgui_widget_get(handle);
-    while(widget)
+    u32 command_index = first_index;
+    while(command_index < last_index)
     {
-        if(function(widget->header.handle))
+        command_index = tgui_raster_command(state, buffer, command_index, last_index, target);
+    }
+}
+
+// NOTE: draw the commands [first_index, last_index) that are not culled, with a piece only the commands
+// that touch it are draw (the piece is already in the clipping stack)
+static void tgui_raster_span(TGuiState *state, TGuiDrawCommandBuffer *buffer, u32 first_index, u32 last_index, TGuiDamageRect *piece)
+{
+#if defined(TGUI_PROFILE)
+    TGuiTimelineBatch batch = {0};
+#endif
+    TGuiOcclusion *occlusion = &buffer->occlusion;
+    b32 debug_cost = state->debug_cost.enabled;
+    u32 command_index = first_index;
+    while(command_index < last_index)
+    {
+        TGuiDrawCommand *draw_cmd = buffer->buffer + command_index;
+        if(occlusion->culled[command_index])
         {
-            // NOTE: if the return true we dont need to keep calling it
-            return true;
+            ++command_index;
+            continue;
         }
-        if(widget->header.child_first)
+        if(piece && tgui_occlusion_draw_pixels(draw_cmd->type) &&
+           tgui_damage_rect_empty(tgui_damage_rect_intersect(*piece, occlusion->bounds[command_index])))
         {
-            if(tgui_widget_recursive_descent_pos_first_to_last(widget->header.child_first, function))
+            if(draw_cmd->type == TGUI_DRAWCMD_BEGIN_LAYER)
             {
-                return true;
+                u32 end_index = tgui_layer_end(buffer, command_index, last_index);
+                command_index = end_index < last_index ? end_index + 1 : last_index;
+            }
+            else
+            {
+                ++command_index;
             }
+            continue;
         }
-        widget = tgui_widget_get(widget->header.sibling_next);
+        f64 debug_start = debug_cost ? tgui_platform_get_time() : 0;
+#if defined(TGUI_PROFILE)
+        if(state->timeline.file) tgui_timeline_raster_batch(&batch, draw_cmd);
+#endif
+        TGUI_PROFILE_BEGIN(kernel);
+        // NOTE: the commands inside a layer are count in the BEGIN_LAYER command
+        command_index = tgui_raster_command(state, buffer, command_index, last_index, state->backbuffer);
+        TGUI_RASTER_ACCUMULATE(kernel, kernels[draw_cmd->type]);
+        if(debug_cost) tgui_debug_cost_command(state, draw_cmd, debug_start);
     }
-    return false;
+#if defined(TGUI_PROFILE)
+    if(state->timeline.file) tgui_timeline_raster_batch(&batch, 0);
+#endif
 }
 
-b32 tgui_widget_recursive_descent_pos_first_to_last(TGuiHandle handle, TGuiWidgetFP function)
+// NOTE: draw the commands that are not pull yet without pulling them, so they can be draw again in other rect.
+// A root with other roots above is draw one time for every visible piece
+static void tgui_raster_commands(TGuiState *state, TGuiDrawCommandBuffer *buffer)
 {
-    TGuiWidget *widget = tgui_widget_get(handle);
-    while(widget)
+    TGuiOcclusion *occlusion = &buffer->occlusion;
+    u32 command_index = buffer->head;
+    for(u32 root_index = 0; root_index < occlusion->root_count; ++root_index)
     {
-        if(widget->header.child_first)
+        TGuiOcclusionRoot *root = occlusion->roots + root_index;
+        if(root->end <= command_index) continue;
+        u32 first_index = TGUI_MAX(root->first, command_index);
+        tgui_raster_span(state, buffer, command_index, first_index, 0);
+        if(root->occluded)
         {
-            if(tgui_widget_recursive_descent_pos_first_to_last(widget->header.child_first, function))
+            for(u32 piece_index = 0; piece_index < root->visible_count; ++piece_index)
             {
-                return true;
+                TGuiDamageRect *piece = occlusion->visible + root->first_visible + piece_index;
+                tgui_clipping_stack_push(&global_clipping_stack, tgui_rect_xywh(piece->min_x, piece->min_y, piece->max_x - piece->min_x, piece->max_y - piece->min_y));
+                tgui_raster_span(state, buffer, first_index, root->end, piece);
+                tgui_clipping_stack_pop(&global_clipping_stack);
             }
         }
-        if(function(widget->header.handle))
+        else
         {
-            // NOTE: if the return true we dont need to keep calling it
-            return true;
+            tgui_raster_span(state, buffer, first_index, root->end, 0);
         }
-        widget = tgui_widget_get(widget->header.sibling_next);
+        command_index = root->end;
     }
-    return false;
+    // NOTE: the commands that the application push after the update
+    tgui_raster_span(state, buffer, command_index, buffer->count, 0);
 }
 
-b32 tgui_widget_recursive_descent_pre_last_to_first(TGuiHandle handle, TGuiWidgetFP function)
+// NOTE: draw a frame into the backbuffer, it only use the buffer and the state of the rasterizer (damage,
+// layers, debug cost) so it can run in the render thread
+static void tgui_draw_frame(TGuiState *state, TGuiDrawCommandBuffer *buffer)
 {
-    TGuiWidget *widget = tgui_widget_get(handle);
-    while(widget)
+    TGUI_PROFILE_BEGIN(raster);
+    tgui_layer_cache_begin_frame(&state->layers, buffer);
+    if(state->debug_cost.enabled) tgui_debug_cost_begin(state, buffer);
+    TGuiDamage *damage = &state->damage;
+    if(damage->enabled)
     {
-        if(function(widget->header.handle))
-        {
-            // NOTE: if the return true we dont need to keep calling it
-            return true;
-        }
-        if(widget->header.child_last)
+        tgui_damage_analyze(state, damage->current, buffer);
+        tgui_damage_compute(state);
+        // NOTE: every dirty rect is clear and all the commands are draw clipped to it
+        for(u32 rect_index = 0; rect_index < damage->dirty_count; ++rect_index)
         {
-            if(tgui_widget_recursive_descent_pre_last_to_first(widget->header.child_last, function))
-            {
-                return true;
-            }
+            TGuiDamageRect rect = damage->dirty[rect_index];
+            tgui_clipping_stack_push(&global_clipping_stack, tgui_rect_xywh(rect.min_x, rect.min_y, rect.max_x - rect.min_x, rect.max_y - rect.min_y));
+            tgui_draw_rect(state->backbuffer, rect.min_x, rect.min_y, rect.max_x, rect.max_y, 0);
+            tgui_raster_commands(state, buffer);
+            tgui_clipping_stack_pop(&global_clipping_stack);
         }
-        widget = tgui_widget_get(widget->header.sibling_prev);
+        TGuiDamageFrame *last = damage->last;
+        damage->last = damage->current;
+        damage->current = last;
+        damage->valid = true;
     }
-    return false;
+    else
+    {
+        tgui_raster_commands(state, buffer);
+    }
+    // NOTE: all the commands are consumed
+    buffer->head = buffer->count;
+    TGUI_RASTER_END(raster, timers[TGUI_TIMER_RASTER]);
 }
 
-b32 tgui_widget_recursive_descent_pos_last_to_first(TGuiHandle handle, TGuiWidgetFP function)
+void tgui_draw_command_buffer(void)
 {
-    TGuiWidget *widget = tgui_widget_get(handle);
-    while(widget)
+    TGuiState *state = &tgui_global_state;
+    // NOTE: with the pipeline the frames are draw by the render thread
+    ASSERT(!state->pipeline.thread);
+    tgui_draw_frame(state, &state->draw_command_buffer);
+    tgui_raster_frame_done(state);
+}
+
+//-----------------------------------------------------
+//  NOTE: pipeline functions
+//-----------------------------------------------------
+
+// NOTE: the render thread draw and present the frames in order, one at a time
+static void tgui_pipeline_thread(void *data)
+{
+    TGuiState *state = (TGuiState *)data;
+    TGuiPipeline *pipeline = &state->pipeline;
+    for(;;)
     {
-        if(widget->header.child_last)
+        tgui_platform_sync_lock(pipeline->sync);
+        while(!pipeline->stop && pipeline->released == pipeline->submitted)
         {
-            if(tgui_widget_recursive_descent_pre_last_to_first(widget->header.child_last, function))
-            {
-                return true;
-            }
+            tgui_platform_sync_wait(pipeline->sync);
         }
-        if(function(widget->header.handle))
+        // NOTE: the last frame is draw before stop
+        b32 stop = pipeline->released == pipeline->submitted;
+        tgui_platform_sync_unlock(pipeline->sync);
+        if(stop) break;
+
+        tgui_draw_frame(state, pipeline->frame);
+        TGuiRect rects[TGUI_DAMAGE_RECTS_MAX];
+        u32 rect_count = tgui_get_dirty_rects(rects, TGUI_DAMAGE_RECTS_MAX);
+        if(rect_count)
         {
-            // NOTE: if the return true we dont need to keep calling it
-            return true;
+            TGUI_PROFILE_BEGIN(present);
+            pipeline->present(rects, rect_count, pipeline->data);
+            TGUI_RASTER_END(present, timers[TGUI_TIMER_PRESENT]);
         }
-        widget = tgui_widget_get(widget->header.sibling_prev);
+
+        tgui_platform_sync_lock(pipeline->sync);
+        tgui_raster_frame_done(state);
+        ++pipeline->released;
+        tgui_platform_sync_wake(pipeline->sync);
+        tgui_platform_sync_unlock(pipeline->sync);
     }
-    return false;
 }
 
-//-----------------------------------------------------
-//  NOTE: memory management functions
-//-----------------------------------------------------
-void tgui_character_allocator_create(TGuiCharacterAllocator *allocator)
+b32 tgui_pipeline_begin(TGuiPresentFP present, void *data)
 {
-    allocator->buffer_size = TGUI_DEFAULT_LINE_SIZE;
-    allocator->buffer = (u8 *)malloc(allocator->buffer_size*sizeof(u8));
-    allocator->count = 0;
+    TGuiState *state = &tgui_global_state;
+    TGuiPipeline *pipeline = &state->pipeline;
+    if(pipeline->thread || !present) return false;
+    pipeline->present = present;
+    pipeline->data = data;
+    pipeline->frame = (TGuiDrawCommandBuffer *)malloc(sizeof(TGuiDrawCommandBuffer));
+    memset(pipeline->frame, 0, sizeof(TGuiDrawCommandBuffer));
+    tgui_draw_command_buffer_create(pipeline->frame);
+    pipeline->sync = tgui_platform_sync_create();
+    pipeline->submitted = 0;
+    pipeline->released = 0;
+    pipeline->stop = false;
+    pipeline->thread = tgui_platform_thread_create(tgui_pipeline_thread, state);
+    if(!pipeline->thread)
+    {
+        tgui_platform_sync_destroy(pipeline->sync);
+        tgui_draw_command_buffer_destroy(pipeline->frame);
+        free(pipeline->frame);
+        pipeline->frame = 0;
+        return false;
+    }
+    return true;
 }
 
-void tgui_character_allocator_destory(TGuiCharacterAllocator *allocator)
+void tgui_pipeline_end(void)
 {
-    free(allocator->buffer);
-    allocator->buffer_size = 0;
-    allocator->count = 0;
+    TGuiPipeline *pipeline = &tgui_global_state.pipeline;
+    if(!pipeline->thread) return;
+    tgui_platform_sync_lock(pipeline->sync);
+    pipeline->stop = true;
+    tgui_platform_sync_wake(pipeline->sync);
+    tgui_platform_sync_unlock(pipeline->sync);
+    tgui_platform_thread_join(pipeline->thread);
+    tgui_platform_sync_destroy(pipeline->sync);
+    tgui_draw_command_buffer_destroy(pipeline->frame);
+    free(pipeline->frame);
+    memset(pipeline, 0, sizeof(TGuiPipeline));
 }
 
-u8 *tgui_character_allocator_pull(TGuiCharacterAllocator *allocator)
+TGuiFence tgui_submit_frame(void)
 {
-    u8 *result = 0;
-    if(allocator->count >= allocator->buffer_size)
+    TGuiState *state = &tgui_global_state;
+    TGuiPipeline *pipeline = &state->pipeline;
+    ASSERT(pipeline->thread);
+    if(!pipeline->thread) return 0;
+    // NOTE: the commands are record here because they are not in the buffer at the next tgui_update
+    if(state->recorder.file && state->recorder.frame_open)
     {
-        u32 new_buffer_size = allocator->buffer_size * 2;
-        u8 *new_buffer = (u8 *)malloc(new_buffer_size*sizeof(u8));
-        memcpy(new_buffer, allocator->buffer, allocator->buffer_size*sizeof(u8));
-        allocator->buffer = new_buffer;
-        allocator->buffer_size = new_buffer_size;
+        tgui_record_commands(&state->recorder, &state->draw_command_buffer);
+        state->recorder.frame_open = false;
     }
-    result = allocator->buffer + allocator->count;
-    allocator->count++;
-    return result;
+    // NOTE: a frame that is the same as the last one is not draw, the fence of the last one is returned
+    if(!tgui_frame_changed()) return pipeline->submitted;
+    tgui_platform_sync_lock(pipeline->sync);
+    while(pipeline->released != pipeline->submitted)
+    {
+        tgui_platform_sync_wait(pipeline->sync);
+    }
+    tgui_draw_command_buffer_move(pipeline->frame, &state->draw_command_buffer);
+    TGuiFence fence = ++pipeline->submitted;
+    tgui_platform_sync_wake(pipeline->sync);
+    tgui_platform_sync_unlock(pipeline->sync);
+    return fence;
 }
 
-void tgui_character_allocator_clear(TGuiCharacterAllocator *allocator)
+b32 tgui_fence_done(TGuiFence fence)
 {
-    allocator->count = 0;
-    memset(allocator->buffer, 0, allocator->buffer_size);
+    TGuiPipeline *pipeline = &tgui_global_state.pipeline;
+    if(!pipeline->thread) return true;
+    tgui_platform_sync_lock(pipeline->sync);
+    b32 done = pipeline->released >= fence;
+    tgui_platform_sync_unlock(pipeline->sync);
+    return done;
 }
 
-void tgui_line_allocator_create(TGuiLineAllocator *allocator)
+void tgui_fence_wait(TGuiFence fence)
 {
-    allocator->buffer_size = TGUI_DEFAULT_NUM_LINES;
-    allocator->buffer = (TGuiCharacterAllocator *)malloc(allocator->buffer_size*sizeof(TGuiCharacterAllocator));
-    allocator->count = 0;
-    for(u32 index = 0; index < TGUI_DEFAULT_NUM_LINES; ++index)
+    TGuiPipeline *pipeline = &tgui_global_state.pipeline;
+    if(!pipeline->thread) return;
+    tgui_platform_sync_lock(pipeline->sync);
+    while(pipeline->released < fence)
     {
-        tgui_character_allocator_create(allocator->buffer + index);
+        tgui_platform_sync_wait(pipeline->sync);
     }
+    tgui_platform_sync_unlock(pipeline->sync);
 }
 
-void tgui_line_allocator_destory(TGuiLineAllocator *allocator)
+//-----------------------------------------------------
+//  NOTE: job functions
+//-----------------------------------------------------
+
+// NOTE: take jobs of the generation until there are no more, the index is only take if the generation
+// is still the same
+static void tgui_jobs_work(TGuiJobs *jobs, u32 generation, TGuiJobFP function, void *data, u32 job_count)
 {
-    for(u32 index = 0; index < allocator->buffer_size; ++index)
+    u64 next_job = __atomic_load_n(&jobs->next_job, __ATOMIC_ACQUIRE);
+    for(;;)
     {
-        tgui_character_allocator_destory(allocator->buffer + index);
+        if((u32)(next_job >> 32) != generation) break;
+        u32 index = (u32)next_job;
+        if(index >= job_count) break;
+        if(__atomic_compare_exchange_n(&jobs->next_job, &next_job, next_job + 1, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            function(data, index);
+            next_job = __atomic_load_n(&jobs->next_job, __ATOMIC_ACQUIRE);
+        }
     }
-    free(allocator->buffer);
-    allocator->buffer_size = 0;
-    allocator->count = 0;
 }
 
-TGuiCharacterAllocator *tgui_line_allocator_pull(TGuiLineAllocator *allocator)
+static void tgui_jobs_thread(void *data)
 {
-    TGuiCharacterAllocator *result = 0;
-    if(allocator->count >= allocator->buffer_size)
+    TGuiJobs *jobs = (TGuiJobs *)data;
+    u32 generation = 0;
+    for(;;)
     {
-        u32 new_buffer_size = allocator->buffer_size * 2;
-        TGuiCharacterAllocator *new_buffer = (TGuiCharacterAllocator *)malloc(new_buffer_size*sizeof(TGuiCharacterAllocator));
-        memcpy(new_buffer, allocator->buffer, allocator->buffer_size*sizeof(TGuiCharacterAllocator));
-        for(u32 index = allocator->buffer_size; index < new_buffer_size; ++index)
+        tgui_platform_sync_lock(jobs->sync);
+        while(!jobs->stop && jobs->generation == generation)
         {
-            tgui_character_allocator_create(new_buffer + index);
+            tgui_platform_sync_wait(jobs->sync);
         }
-        allocator->buffer = new_buffer;
-        allocator->buffer_size = new_buffer_size;
+        if(jobs->stop)
+        {
+            tgui_platform_sync_unlock(jobs->sync);
+            break;
+        }
+        generation = jobs->generation;
+        TGuiJobFP function = jobs->function;
+        void *job_data = jobs->data;
+        u32 job_count = jobs->job_count;
+        ++jobs->busy;
+        tgui_platform_sync_unlock(jobs->sync);
+
+        tgui_jobs_work(jobs, generation, function, job_data, job_count);
+
+        tgui_platform_sync_lock(jobs->sync);
+        --jobs->busy;
+        tgui_platform_sync_wake(jobs->sync);
+        tgui_platform_sync_unlock(jobs->sync);
     }
-    result = allocator->buffer + allocator->count;
-    allocator->count++;
-    result->count = 0;
-    return result;
-}
-
-void tgui_widget_poll_allocator_create(TGuiWidgetPoolAllocator *allocator)
-{
-    allocator->buffer_size = TGUI_DEFAULT_POOL_SIZE;
-    allocator->buffer = (TGuiWidget *)malloc(allocator->buffer_size*sizeof(TGuiWidget));
-    // NOTE: because 0 is a INVALID HANDLE the first element in the pool is reserved
-    allocator->count = 1;
-    allocator->free_list = 0;
-}
-
-void tgui_widget_allocator_destroy(TGuiWidgetPoolAllocator *allocator)
-{
-    free(allocator->buffer);
-    allocator->buffer_size = 0;
-    allocator->count = 0;
-    allocator->free_list = 0;
 }
 
-TGuiHandle tgui_widget_allocator_pool(TGuiWidgetPoolAllocator *allocator)
+// NOTE: run function for every index from 0 to job_count, it return when the jobs are done and all the
+// workers that were in the generation are out of it. A worker that wake late can still see the generation,
+// but the index is take with the generation so it dont get any job of it or of the next one
+static void tgui_jobs_run(TGuiJobs *jobs, TGuiJobFP function, void *data, u32 job_count)
 {
-    TGuiHandle handle = TGUI_INVALID_HANDLE;
-    if(allocator->free_list)
+    if(!jobs->threads)
     {
-        handle = allocator->free_list->handle;
-        allocator->free_list = allocator->free_list->next;
-        return handle;
+        for(u32 index = 0; index < job_count; ++index) function(data, index);
+        return;
     }
-    
-    handle = allocator->count++;
-    if(handle >= allocator->buffer_size)
+    tgui_platform_sync_lock(jobs->sync);
+    jobs->function = function;
+    jobs->data = data;
+    jobs->job_count = job_count;
+    u32 generation = ++jobs->generation;
+    __atomic_store_n(&jobs->next_job, (u64)generation << 32, __ATOMIC_RELEASE);
+    tgui_platform_sync_wake(jobs->sync);
+    tgui_platform_sync_unlock(jobs->sync);
+
+    tgui_jobs_work(jobs, generation, function, data, job_count);
+
+    tgui_platform_sync_lock(jobs->sync);
+    while(jobs->busy)
     {
-        // NOTE: this is a dynamic pool allocator need to be reallocated here!
-        u32 new_buffer_size = allocator->buffer_size * 2;
-        TGuiWidget *new_buffer = (TGuiWidget *)malloc(new_buffer_size*sizeof(TGuiWidget));
-        memcpy(new_buffer, allocator->buffer, allocator->buffer_size*sizeof(TGuiWidget));
-        free(allocator->buffer);
-        allocator->buffer = new_buffer;
-        allocator->buffer_size = new_buffer_size;
+        tgui_platform_sync_wait(jobs->sync);
     }
-    return handle;
+    tgui_platform_sync_unlock(jobs->sync);
 }
 
-void tgui_widget_allocator_free(TGuiWidgetPoolAllocator *allocator, TGuiHandle *handle)
+static void tgui_jobs_layout_root(void *data, u32 index)
 {
-    ASSERT(*handle != TGUI_INVALID_HANDLE);
-    TGuiWidget *widget = tgui_widget_get(*handle);
-    if(widget->header.type == TGUI_TEXTBOX)
+    TGuiJobs *jobs = (TGuiJobs *)data;
+    TGuiWidget *root = tgui_widget_get(jobs->roots[index]);
+    if(root->header.type == TGUI_CONTAINER)
     {
-        tgui_line_allocator_destory(&widget->textbox.allocator);
+        TGUI_SPAN_BEGIN(root_layout);
+        tgui_container_layout_subtree(&root->container);
+        TGUI_SPAN_END(root_layout, root->header.handle, 0);
     }
+}
 
-    TGuiWidgetFree *free_widget = (TGuiWidgetFree *)(allocator->buffer + *handle);
-    free_widget->handle = *handle;
-    free_widget->next = allocator->free_list;
-    allocator->free_list = free_widget;
-    *handle = TGUI_INVALID_HANDLE;
+// NOTE: the roots are take from the list first, the jobs dont read the list of roots
+static void tgui_jobs_layout_roots(TGuiState *state)
+{
+    TGuiJobs *jobs = &state->jobs;
+    jobs->root_count = 0;
+    TGuiWidget *root = tgui_widget_get(state->first_root);
+    while(root)
+    {
+        if(jobs->root_count == jobs->root_size)
+        {
+            u32 new_root_size = jobs->root_size ? jobs->root_size*2 : 16;
+            TGuiHandle *new_roots = (TGuiHandle *)malloc(new_root_size*sizeof(TGuiHandle));
+            memcpy(new_roots, jobs->roots, jobs->root_count*sizeof(TGuiHandle));
+            free(jobs->roots);
+            jobs->roots = new_roots;
+            jobs->root_size = new_root_size;
+        }
+        jobs->roots[jobs->root_count++] = root->header.handle;
+        root = tgui_widget_get(root->header.sibling_next);
+    }
+    TGUI_PROFILE_BEGIN(layout);
+    tgui_jobs_run(jobs, tgui_jobs_layout_root, jobs, jobs->root_count);
+    TGUI_PROFILE_END(layout, timers[TGUI_TIMER_LAYOUT]);
+    jobs->layout_done = true;
 }
 
-void tgui_widget_set(TGuiHandle handle, TGuiWidget widget)
+b32 tgui_jobs_begin(u32 thread_count)
 {
-    ASSERT(handle != TGUI_INVALID_HANDLE);
-    TGuiState *state = &tgui_global_state;
-    state->widget_allocator.buffer[handle] = widget;
+    TGuiJobs *jobs = &tgui_global_state.jobs;
+    if(jobs->threads || !thread_count) return false;
+    jobs->sync = tgui_platform_sync_create();
+    jobs->generation = 0;
+    jobs->busy = 0;
+    jobs->stop = false;
+    jobs->threads = (TGuiThread *)malloc(thread_count*sizeof(TGuiThread));
+    // NOTE: only the threads that can be create are used
+    jobs->thread_count = 0;
+    for(u32 thread_index = 0; thread_index < thread_count; ++thread_index)
+    {
+        TGuiThread thread = tgui_platform_thread_create(tgui_jobs_thread, jobs);
+        if(!thread) break;
+        jobs->threads[jobs->thread_count++] = thread;
+    }
+    if(!jobs->thread_count)
+    {
+        tgui_platform_sync_destroy(jobs->sync);
+        free(jobs->threads);
+        jobs->threads = 0;
+        return false;
+    }
+    return true;
 }
 
-TGuiWidget *tgui_widget_get(TGuiHandle handle)
+void tgui_jobs_end(void)
 {
-    TGuiWidget *result = 0;
-    if(handle != TGUI_INVALID_HANDLE)
+    TGuiJobs *jobs = &tgui_global_state.jobs;
+    if(!jobs->threads) return;
+    tgui_platform_sync_lock(jobs->sync);
+    jobs->stop = true;
+    tgui_platform_sync_wake(jobs->sync);
+    tgui_platform_sync_unlock(jobs->sync);
+    for(u32 thread_index = 0; thread_index < jobs->thread_count; ++thread_index)
     {
-        TGuiState *state = &tgui_global_state;
-        result = state->widget_allocator.buffer + handle;
+        tgui_platform_thread_join(jobs->threads[thread_index]);
     }
-    return result;
+    tgui_platform_sync_destroy(jobs->sync);
+    free(jobs->threads);
+    jobs->threads = 0;
+    jobs->thread_count = 0;
 }
 
 //-----------------------------------------------------
-//  NOTE: core library functions
+//  NOTE: geometry functions
 //-----------------------------------------------------
 
-void tgui_push_event(TGuiEvent event)
+#define TGUI_GEOMETRY_DEFAULT_SIZE 1024
+#define TGUI_GEOMETRY_DEFAULT_CALLS_SIZE 16
+#define TGUI_GEOMETRY_ARC_SEGMENTS_MAX 16
+#define TGUI_PI 3.14159265f
+
+void tgui_geometry_create(TGuiGeometry *geometry)
 {
     TGuiState *state = &tgui_global_state;
-    if(state->event_queue.count < TGUI_EVENT_QUEUE_MAX)
+    memset(geometry, 0, sizeof(TGuiGeometry));
+    // NOTE: the font with a white row at the bottom, the solid primitives sample the white texel
+    TGuiBitmap *font_bitmap = state->font->bitmap;
+    TGuiBitmap *atlas = &geometry->atlas;
+    atlas->width = font_bitmap->width;
+    atlas->height = font_bitmap->height + 1;
+    atlas->pitch = atlas->width*sizeof(u32);
+    atlas->pixels = (u32 *)malloc((u64)atlas->width*atlas->height*sizeof(u32));
+    for(u32 y = 0; y < font_bitmap->height; ++y)
     {
-        state->event_queue.queue[state->event_queue.count++] = event;
+        memcpy(atlas->pixels + (u64)y*atlas->width, (u8 *)font_bitmap->pixels + (u64)y*font_bitmap->pitch, font_bitmap->width*sizeof(u32));
     }
+    u32 *white = atlas->pixels + (u64)font_bitmap->height*atlas->width;
+    for(u32 x = 0; x < atlas->width; ++x) white[x] = 0xFFFFFFFF;
+
+    geometry->vertex_size = TGUI_GEOMETRY_DEFAULT_SIZE;
+    geometry->vertices = (TGuiVertex *)malloc(geometry->vertex_size*sizeof(TGuiVertex));
+    geometry->index_size = TGUI_GEOMETRY_DEFAULT_SIZE;
+    geometry->indices = (u32 *)malloc(geometry->index_size*sizeof(u32));
+    geometry->call_size = TGUI_GEOMETRY_DEFAULT_CALLS_SIZE;
+    geometry->calls = (TGuiDrawCall *)malloc(geometry->call_size*sizeof(TGuiDrawCall));
 }
 
-void tgui_push_draw_command(TGuiDrawCommand draw_cmd)
+void tgui_geometry_destroy(TGuiGeometry *geometry)
 {
-    TGuiState *state = &tgui_global_state;
-    if(state->draw_command_buffer.count< TGUI_DRAW_COMMANDS_MAX)
+    free(geometry->atlas.pixels);
+    free(geometry->vertices);
+    free(geometry->indices);
+    free(geometry->calls);
+    memset(geometry, 0, sizeof(TGuiGeometry));
+}
+
+static void tgui_geometry_reserve(TGuiGeometry *geometry, u32 vertex_count, u32 index_count)
+{
+    if(geometry->vertex_count + vertex_count > geometry->vertex_size)
     {
-        state->draw_command_buffer.buffer[state->draw_command_buffer.count++] = draw_cmd;
+        u32 new_vertex_size = geometry->vertex_size*2;
+        while(new_vertex_size < geometry->vertex_count + vertex_count) new_vertex_size *= 2;
+        TGuiVertex *new_vertices = (TGuiVertex *)malloc(new_vertex_size*sizeof(TGuiVertex));
+        memcpy(new_vertices, geometry->vertices, geometry->vertex_count*sizeof(TGuiVertex));
+        free(geometry->vertices);
+        geometry->vertices = new_vertices;
+        geometry->vertex_size = new_vertex_size;
+    }
+    if(geometry->index_count + index_count > geometry->index_size)
+    {
+        u32 new_index_size = geometry->index_size*2;
+        while(new_index_size < geometry->index_count + index_count) new_index_size *= 2;
+        u32 *new_indices = (u32 *)malloc(new_index_size*sizeof(u32));
+        memcpy(new_indices, geometry->indices, geometry->index_count*sizeof(u32));
+        free(geometry->indices);
+        geometry->indices = new_indices;
+        geometry->index_size = new_index_size;
     }
 }
 
-b32 tgui_pull_draw_command(TGuiDrawCommand *draw_cmd)
+inline static TGuiDamageRect tgui_geometry_rect(TGuiRect rect)
 {
-    TGuiState *state = &tgui_global_state;
-    if(state->draw_command_buffer.head >= state->draw_command_buffer.count)
+    return tgui_damage_rect(rect.x, rect.y, (i32)rect.x + (i32)rect.width, (i32)rect.y + (i32)rect.height);
+}
+
+// NOTE: return the draw call for a primitive. A primitive that is inside its clip (bounds) can go in the last call
+// if the clip of the call contain it, so the calls are only split when the texture change or when a primitive
+// cross its clip and need the scissor
+static TGuiDrawCall *tgui_geometry_batch(TGuiGeometry *geometry, TGuiBitmap *texture, TGuiDamageRect bounds, TGuiDamageRect clip, b32 scissor)
+{
+    if(geometry->call_count)
     {
-        state->draw_command_buffer.head = 0;
-        state->draw_command_buffer.count = 0;
-        return false;
+        TGuiDrawCall *last = geometry->calls + geometry->call_count - 1;
+        TGuiDamageRect last_clip = tgui_geometry_rect(last->clip);
+        b32 fit = scissor ? memcmp(&last_clip, &clip, sizeof(TGuiDamageRect)) == 0 : tgui_damage_rect_contains(last_clip, bounds);
+        if(last->texture == texture && fit) return last;
     }
-    *draw_cmd = state->draw_command_buffer.buffer[state->draw_command_buffer.head++];
-    return true;
+    if(geometry->call_count == geometry->call_size)
+    {
+        u32 new_call_size = geometry->call_size*2;
+        TGuiDrawCall *new_calls = (TGuiDrawCall *)malloc(new_call_size*sizeof(TGuiDrawCall));
+        memcpy(new_calls, geometry->calls, geometry->call_count*sizeof(TGuiDrawCall));
+        free(geometry->calls);
+        geometry->calls = new_calls;
+        geometry->call_size = new_call_size;
+    }
+    TGuiBitmap *backbuffer = tgui_global_state.backbuffer;
+    TGuiDamageRect call_clip = scissor ? clip : tgui_damage_rect(0, 0, backbuffer->width, backbuffer->height);
+    TGuiDrawCall *call = geometry->calls + geometry->call_count++;
+    call->texture = texture;
+    call->clip = tgui_rect_xywh(call_clip.min_x, call_clip.min_y, call_clip.max_x - call_clip.min_x, call_clip.max_y - call_clip.min_y);
+    call->first_index = geometry->index_count;
+    call->index_count = 0;
+    return call;
 }
 
-// NOTE: core lib functions
-void tgui_init(TGuiBitmap *backbuffer, TGuiFont *font)
+inline static void tgui_geometry_push_vertex(TGuiGeometry *geometry, f32 x, f32 y, f32 u, f32 v, u32 color)
 {
-    TGuiState *state = &tgui_global_state;
-    
-    memset(state, 0, sizeof(TGuiState));
-    state->backbuffer = backbuffer;
-    state->font = font;
-    state->font_height = 9;
-    f32 w_ration = (f32)font->src_rect.width / (f32)font->src_rect.height;
-    state->font_width = (u32)(w_ration * (f32)state->font_height + 0.5f);
-    
-    tgui_widget_poll_allocator_create(&state->widget_allocator);
-    
-    tgui_clipping_stack_create(&global_clipping_stack);
-    tgui_clipping_stack_push(&global_clipping_stack, tgui_rect_xywh(0, 0, backbuffer->width, backbuffer->height));
+    TGuiVertex *vertex = geometry->vertices + geometry->vertex_count++;
+    vertex->x = x;
+    vertex->y = y;
+    vertex->u = u;
+    vertex->v = v;
+    vertex->color = color;
 }
 
-void tgui_terminate(void)
+// NOTE: the quads are clipped here (with its uv), so they never need the scissor. src is in texels
+static void tgui_geometry_push_quad(TGuiGeometry *geometry, TGuiBitmap *texture, TGuiDamageRect rect, TGuiRect src, TGuiDamageRect clip, u32 color)
 {
-    TGuiState *state = &tgui_global_state;
-    tgui_clipping_stack_destoy(&global_clipping_stack);
-    tgui_widget_allocator_destroy(&state->widget_allocator);
+    TGuiDamageRect clipped = tgui_damage_rect_intersect(rect, clip);
+    if(tgui_damage_rect_empty(clipped)) return;
+    f32 texel_x = src.width/(f32)(rect.max_x - rect.min_x);
+    f32 texel_y = src.height/(f32)(rect.max_y - rect.min_y);
+    f32 u0 = (src.x + (clipped.min_x - rect.min_x)*texel_x)/(f32)texture->width;
+    f32 v0 = (src.y + (clipped.min_y - rect.min_y)*texel_y)/(f32)texture->height;
+    f32 u1 = (src.x + (clipped.max_x - rect.min_x)*texel_x)/(f32)texture->width;
+    f32 v1 = (src.y + (clipped.max_y - rect.min_y)*texel_y)/(f32)texture->height;
+
+    TGuiDrawCall *call = tgui_geometry_batch(geometry, texture, clipped, clip, false);
+    tgui_geometry_reserve(geometry, 4, 6);
+    u32 base = geometry->vertex_count;
+    tgui_geometry_push_vertex(geometry, clipped.min_x, clipped.min_y, u0, v0, color);
+    tgui_geometry_push_vertex(geometry, clipped.max_x, clipped.min_y, u1, v0, color);
+    tgui_geometry_push_vertex(geometry, clipped.max_x, clipped.max_y, u1, v1, color);
+    tgui_geometry_push_vertex(geometry, clipped.min_x, clipped.max_y, u0, v1, color);
+    u32 quad_indices[6] = {0, 1, 2, 0, 2, 3};
+    for(u32 index = 0; index < 6; ++index) geometry->indices[geometry->index_count++] = base + quad_indices[index];
+    call->index_count += 6;
 }
 
-void tgui_update(void)
+inline static TGuiRect tgui_geometry_white(TGuiGeometry *geometry)
 {
-    TGuiState *state = &tgui_global_state;
-    // NOTE: clear old state that are not needed any more
-    state->mouse_up = false;
-    state->mouse_down = false;
-    state->last_mouse_x = state->mouse_x;
-    state->last_mouse_y = state->mouse_y;
-    // NOTE: pull tgui events from the queue
-    for(u32 event_index = 0; event_index < state->event_queue.count; ++event_index)
+    // NOTE: the center of the first texel of the white row, the quad of a color is one texel stretched
+    return tgui_rect_xywh(0.5f, geometry->atlas.height - 0.5f, 0, 0);
+}
+
+// NOTE: a fan from the center, every corner is an arc of the circle of the radius (a circle is a rounded
+// rect with the radius of half its size). Only the fans that cross the clip need the scissor
+static void tgui_geometry_push_rounded_rect(TGuiGeometry *geometry, TGuiDamageRect rect, TGuiDamageRect clip, u32 radius, u32 color)
+{
+    i32 width = rect.max_x - rect.min_x;
+    i32 height = rect.max_y - rect.min_y;
+    TGuiDamageRect bounds = tgui_damage_rect_intersect(rect, clip);
+    if(tgui_damage_rect_empty(bounds)) return;
+    u32 max_radius = (u32)TGUI_MIN(width, height)/2;
+    if(radius > max_radius) radius = max_radius;
+    TGuiRect white = tgui_geometry_white(geometry);
+    if(radius == 0)
     {
-        TGuiEvent *event = state->event_queue.queue + event_index;
-        switch(event->type)
+        tgui_geometry_push_quad(geometry, &geometry->atlas, rect, white, clip, color);
+        return;
+    }
+    u32 segments = TGUI_MIN(TGUI_MAX(radius, 2), TGUI_GEOMETRY_ARC_SEGMENTS_MAX);
+    u32 perimeter_count = 4*(segments + 1);
+    b32 scissor = !tgui_damage_rect_contains(clip, rect);
+    TGuiDrawCall *call = tgui_geometry_batch(geometry, &geometry->atlas, bounds, clip, scissor);
+    tgui_geometry_reserve(geometry, perimeter_count + 1, perimeter_count*3);
+
+    f32 u = white.x/(f32)geometry->atlas.width;
+    f32 v = white.y/(f32)geometry->atlas.height;
+    u32 base = geometry->vertex_count;
+    tgui_geometry_push_vertex(geometry, rect.min_x + width*0.5f, rect.min_y + height*0.5f, u, v, color);
+    // NOTE: corners clockwise from the top right, the angle start at -90 degrees
+    f32 centers[4][2] =
+    {
+        {(f32)rect.max_x - radius, (f32)rect.min_y + radius},
+        {(f32)rect.max_x - radius, (f32)rect.max_y - radius},
+        {(f32)rect.min_x + radius, (f32)rect.max_y - radius},
+        {(f32)rect.min_x + radius, (f32)rect.min_y + radius},
+    };
+    f32 quarter = TGUI_PI*0.5f;
+    for(u32 corner = 0; corner < 4; ++corner)
+    {
+        for(u32 segment = 0; segment <= segments; ++segment)
         {
-            case TGUI_EVENT_KEYDOWN:
-            {
-                // TODO: check where is the best place to update the active textbox
-                if(state->widget_active)
-                {
-                    TGuiWidget *widget = tgui_widget_get(state->widget_active);
-                    if(widget->header.type == TGUI_TEXTBOX)
-                    {
-                        if(event->key.keycode == TGUI_KEYCODE_ENTER)
-                        {
-                            tgui_textbox_push_newline(&widget->textbox);
-                        }
-                        else if(event->key.keycode == TGUI_KEYCODE_BACKSPACE)
-                        {
-                            tgui_textbox_delete_current_character(&widget->textbox);
-                        }
-                        else if(event->key.keycode == TGUI_KEYCODE_LEFT)
-                        {
-                            tgui_textbox_move_cursor_left(&widget->textbox); 
-                        }
-                        else if(event->key.keycode == TGUI_KEYCODE_RIGHT)
-                        {
-                            tgui_textbox_move_cursor_right(&widget->textbox); 
-                        }
-                        else if(event->key.keycode == TGUI_KEYCODE_UP)
-                        {
-                            tgui_textbox_move_cursor_up(&widget->textbox); 
-                        }
-                        else if(event->key.keycode == TGUI_KEYCODE_DOWN)
-                        {
-                            tgui_textbox_move_cursor_down(&widget->textbox); 
-                        }
-                    }
-                }
-            } break;
-            case TGUI_EVENT_KEYUP:
-            {
-            } break;
-            case TGUI_EVENT_MOUSEMOVE:
-            {
-                TGuiEventMouseMove *mouse = (TGuiEventMouseMove *)event;
-                state->mouse_x = mouse->pos_x;
-                state->mouse_y = mouse->pos_y;
-            } break;
-            case TGUI_EVENT_MOUSEDOWN:
-            {
-                state->mouse_down = true;
-                state->mouse_is_down = true;
-            } break;
-            case TGUI_EVENT_MOUSEUP:
-            {
-                state->mouse_up = true;
-                state->mouse_is_down = false;
-            } break;
-            case TGUI_EVENT_CHAR:
-            {
-                if(state->widget_active)
-                {
-                    TGuiWidget *widget = tgui_widget_get(state->widget_active);
-                    if(widget->header.type == TGUI_TEXTBOX)
-                    {
-                        if((event->character.character >= ' ') && (event->character.character <= '~'))
-                        {
-                            tgui_textbox_push_character(&widget->textbox, event->character.character);
-                        }
-                    }
-                }
-            } break;
-            case TGUI_EVENT_COUNT:
-            {
-                ASSERT(!"invalid path code\n");
-            } break;
+            f32 angle = -quarter + corner*quarter + quarter*segment/(f32)segments;
+            tgui_geometry_push_vertex(geometry, centers[corner][0] + cosf(angle)*radius, centers[corner][1] + sinf(angle)*radius, u, v, color);
         }
     }
-    state->event_queue.count = 0;
-    
-    // NOTE: update all widget in the state widget tree
-    tgui_widget_recursive_descent_pos_first_to_last(state->first_root, tgui_widget_update);
-    tgui_widget_recursive_descent_pre_last_to_first(state->last_root, tgui_widget_render);
+    for(u32 index = 0; index < perimeter_count; ++index)
+    {
+        geometry->indices[geometry->index_count++] = base;
+        geometry->indices[geometry->index_count++] = base + 1 + index;
+        geometry->indices[geometry->index_count++] = base + 1 + (index + 1) % perimeter_count;
+    }
+    call->index_count += perimeter_count*3;
 }
 
-void tgui_draw_command_buffer(void)
+static void tgui_geometry_push_char(TGuiGeometry *geometry, TGuiState *state, i32 x, i32 y, char character, TGuiDamageRect clip)
+{
+    // NOTE: same glyphs as tgui_draw_char
+    if(character < ' ' || character > '~') return;
+    TGuiFont *font = state->font;
+    u32 index = (character - ' ');
+    TGuiRect src;
+    src.x = (index % font->num_rows)*font->src_rect.width;
+    src.y = (index / font->num_rows)*font->src_rect.height;
+    src.width = font->src_rect.width;
+    src.height = font->src_rect.height;
+    TGuiDamageRect rect = tgui_damage_rect(x, y, x + (i32)state->font_width, y + (i32)state->font_height);
+    tgui_geometry_push_quad(geometry, &geometry->atlas, rect, src, clip, 0xFFFFFFFF);
+}
+
+void tgui_geometry_build(TGuiGeometry *geometry)
 {
     TGuiState *state = &tgui_global_state;
-    // NOTE: pull tgui draw commands from the buffer 
-    TGuiDrawCommand draw_cmd;
-    while(tgui_pull_draw_command(&draw_cmd))
+    TGuiDrawCommandBuffer *buffer = &state->draw_command_buffer;
+    ASSERT(!state->pipeline.thread);
+    geometry->vertex_count = 0;
+    geometry->index_count = 0;
+    geometry->call_count = 0;
+
+    TGuiDamageRect clips[TGUI_DAMAGE_SCOPES_MAX];
+    u32 depth = 1;
+    u32 ignored_depth = 0;
+    clips[0] = tgui_damage_rect(0, 0, state->backbuffer->width, state->backbuffer->height);
+    TGuiRect white = tgui_geometry_white(geometry);
+    for(u32 command_index = buffer->head; command_index < buffer->count; ++command_index)
     {
-        switch(draw_cmd.type)
+        // NOTE: the culled commands are hidden by other roots, the layers are draw inline
+        if(buffer->occlusion.culled[command_index]) continue;
+        TGuiDrawCommand *draw_cmd = buffer->buffer + command_index;
+        TGuiDamageRect clip = clips[depth - 1];
+        TGuiDamageRect rect = tgui_geometry_rect(draw_cmd->descriptor);
+        switch(draw_cmd->type)
         {
             case TGUI_DRAWCMD_CLEAR:
             {
-                tgui_clear_backbuffer(state->backbuffer);
+                tgui_geometry_push_quad(geometry, &geometry->atlas, clips[0], white, clip, 0);
             } break;
             case TGUI_DRAWCMD_START_CLIPPING:
             {
-                tgui_clipping_stack_push(&global_clipping_stack, draw_cmd.descriptor);
+                if(ignored_depth || depth == TGUI_DAMAGE_SCOPES_MAX)
+                {
+                    ++ignored_depth;
+                    break;
+                }
+                clips[depth] = tgui_damage_rect_intersect(clip, rect);
+                ++depth;
             } break;
             case TGUI_DRAWCMD_END_CLIPPING:
             {
-                tgui_clipping_stack_pop(&global_clipping_stack);
+                if(ignored_depth) --ignored_depth;
+                else if(depth > 1) --depth;
             } break;
             case TGUI_DRAWCMD_RECT:
             {
-                u32 min_x = (u32)draw_cmd.descriptor.x;
-                u32 min_y = (u32)draw_cmd.descriptor.y;
-                u32 max_x = min_x + (u32)draw_cmd.descriptor.width;
-                u32 max_y = min_y + (u32)draw_cmd.descriptor.height;
-                tgui_draw_rect(state->backbuffer, min_x, min_y, max_x, max_y, draw_cmd.color);
+                tgui_geometry_push_quad(geometry, &geometry->atlas, rect, white, clip, draw_cmd->color);
             } break;
             case TGUI_DRAWCMD_ROUNDED_RECT:
             {
-                i32 max_x = draw_cmd.descriptor.x + draw_cmd.descriptor.width;
-                i32 max_y = draw_cmd.descriptor.y + draw_cmd.descriptor.height;
-                tgui_draw_rounded_rect(state->backbuffer, draw_cmd.descriptor.x, draw_cmd.descriptor.y, max_x, max_y, draw_cmd.color, draw_cmd.ratio);
+                tgui_geometry_push_rounded_rect(geometry, rect, clip, draw_cmd->ratio, draw_cmd->color);
             } break;
             case TGUI_DRAWCMD_BITMAP:
             {
-                tgui_draw_bitmap(state->backbuffer, draw_cmd.bitmap, draw_cmd.descriptor.x, draw_cmd.descriptor.y, draw_cmd.descriptor.width, draw_cmd.descriptor.height);
+                if(!draw_cmd->bitmap || tgui_damage_rect_empty(rect)) break;
+                TGuiRect src = tgui_rect_xywh(0, 0, draw_cmd->bitmap->width, draw_cmd->bitmap->height);
+                tgui_geometry_push_quad(geometry, draw_cmd->bitmap, rect, src, clip, 0xFFFFFFFF);
             } break;
             case TGUI_DRAWCMD_CHAR:
             {
-                tgui_draw_char(state->backbuffer, state->font, state->font_height, draw_cmd.descriptor.x, draw_cmd.descriptor.y, draw_cmd.character);
+                tgui_geometry_push_char(geometry, state, rect.min_x, rect.min_y, draw_cmd->character, clip);
             } break;
             case TGUI_DRAWCMD_TEXT:
             {
-                tgui_draw_text(state->backbuffer, state->font, state->font_height, draw_cmd.descriptor.x, draw_cmd.descriptor.y, draw_cmd.text, draw_cmd.text_size);
+                for(u32 char_index = 0; char_index < draw_cmd->text_size; ++char_index)
+                {
+                    tgui_geometry_push_char(geometry, state, rect.min_x + char_index*state->font_width, rect.min_y, draw_cmd->text[char_index], clip);
+                }
             } break;
-            case TGUI_DRAWCMD_COUNT:
+            case TGUI_DRAWCMD_SPANS:
             {
-                ASSERT(!"invalid code path");
+                // NOTE: the triangles are not blend, every span is a quad of the pixels that it cover more than half
+                TGuiSpan *spans = (TGuiSpan *)draw_cmd->text;
+                u32 span_count = draw_cmd->text_size / sizeof(TGuiSpan);
+                for(u32 span_index = 0; span_index < span_count; ++span_index)
+                {
+                    i32 x = rect.min_x + (i32)span_index;
+                    i32 min_y = rect.min_y + (i32)floorf(spans[span_index].min_y + 0.5f);
+                    i32 max_y = rect.min_y + (i32)floorf(spans[span_index].max_y + 0.5f);
+                    if(max_y <= min_y) continue;
+                    tgui_geometry_push_quad(geometry, &geometry->atlas, tgui_damage_rect(x, min_y, x + 1, max_y), white, clip, draw_cmd->color);
+                }
             } break;
+            default: break;
+        }
+    }
+    // NOTE: all the commands are consumed
+    buffer->head = buffer->count;
+}
+
+inline static f32 tgui_geometry_edge(TGuiVertex *a, TGuiVertex *b, f32 x, f32 y)
+{
+    return (b->x - a->x)*(y - a->y) - (b->y - a->y)*(x - a->x);
+}
+
+// NOTE: top-left fill rule, the pixels in the shared edge of two triangles are only draw by one of them
+inline static b32 tgui_geometry_edge_inside(f32 weight, TGuiVertex *a, TGuiVertex *b)
+{
+    if(weight != 0) return weight > 0;
+    f32 dx = b->x - a->x;
+    f32 dy = b->y - a->y;
+    return dy < 0 || (dy == 0 && dx > 0);
+}
+
+inline static u32 tgui_geometry_modulate(u32 texel, u32 color)
+{
+    u32 result = 0;
+    for(u32 shift = 0; shift < 32; shift += 8)
+    {
+        u32 channel = (((texel >> shift) & 0xFF)*((color >> shift) & 0xFF) + 127)/255;
+        result |= channel << shift;
+    }
+    return result;
+}
+
+static void tgui_geometry_raster_triangle(TGuiBitmap *target, TGuiBitmap *texture, TGuiDamageRect clip, TGuiVertex *v0, TGuiVertex *v1, TGuiVertex *v2)
+{
+    f32 area = tgui_geometry_edge(v0, v1, v2->x, v2->y);
+    if(area == 0) return;
+    if(area < 0)
+    {
+        TGuiVertex *swap = v1;
+        v1 = v2;
+        v2 = swap;
+        area = -area;
+    }
+    i32 min_x = TGUI_MAX(clip.min_x, (i32)floorf(TGUI_MIN(v0->x, TGUI_MIN(v1->x, v2->x))));
+    i32 min_y = TGUI_MAX(clip.min_y, (i32)floorf(TGUI_MIN(v0->y, TGUI_MIN(v1->y, v2->y))));
+    i32 max_x = TGUI_MIN(clip.max_x, (i32)ceilf(TGUI_MAX(v0->x, TGUI_MAX(v1->x, v2->x))));
+    i32 max_y = TGUI_MIN(clip.max_y, (i32)ceilf(TGUI_MAX(v0->y, TGUI_MAX(v1->y, v2->y))));
+    for(i32 y = min_y; y < max_y; ++y)
+    {
+        u32 *row = (u32 *)((u8 *)target->pixels + (i64)y*target->pitch);
+        f32 pixel_y = y + 0.5f;
+        for(i32 x = min_x; x < max_x; ++x)
+        {
+            f32 pixel_x = x + 0.5f;
+            f32 w0 = tgui_geometry_edge(v1, v2, pixel_x, pixel_y);
+            f32 w1 = tgui_geometry_edge(v2, v0, pixel_x, pixel_y);
+            f32 w2 = tgui_geometry_edge(v0, v1, pixel_x, pixel_y);
+            if(!tgui_geometry_edge_inside(w0, v1, v2) || !tgui_geometry_edge_inside(w1, v2, v0) || !tgui_geometry_edge_inside(w2, v0, v1)) continue;
+            // NOTE: nearest texel, the color of the triangle is the color of its first vertex
+            f32 u = (w0*v0->u + w1*v1->u + w2*v2->u)/area;
+            f32 v = (w0*v0->v + w1*v1->v + w2*v2->v)/area;
+            i32 texel_x = TGUI_MIN(TGUI_MAX((i32)(u*texture->width), 0), (i32)texture->width - 1);
+            i32 texel_y = TGUI_MIN(TGUI_MAX((i32)(v*texture->height), 0), (i32)texture->height - 1);
+            u32 texel = ((u32 *)((u8 *)texture->pixels + (i64)texel_y*texture->pitch))[texel_x];
+            if(((texel >> 24) & 0xFF) > 128) row[x] = tgui_geometry_modulate(texel, v0->color);
+        }
+    }
+}
+
+void tgui_geometry_raster(TGuiGeometry *geometry, TGuiBitmap *target)
+{
+    TGuiDamageRect target_rect = tgui_damage_rect(0, 0, target->width, target->height);
+    for(u32 call_index = 0; call_index < geometry->call_count; ++call_index)
+    {
+        TGuiDrawCall *call = geometry->calls + call_index;
+        TGuiDamageRect clip = tgui_damage_rect_intersect(tgui_geometry_rect(call->clip), target_rect);
+        if(tgui_damage_rect_empty(clip)) continue;
+        u32 *indices = geometry->indices + call->first_index;
+        for(u32 index = 0; index + 2 < call->index_count; index += 3)
+        {
+            tgui_geometry_raster_triangle(target, call->texture, clip, geometry->vertices + indices[index],
+                                          geometry->vertices + indices[index + 1], geometry->vertices + indices[index + 2]);
         }
     }
 }
@@ -1886,6 +7241,615 @@ TGuiKeyCode tgui_win32_translate_keycode(u32 keycode)
     }
 }
 
+b32 tgui_platform_map_file(TGuiMappedFile *file, char *path)
+{
+    memset(file, 0, sizeof(TGuiMappedFile));
+#if defined(_WIN32)
+    HANDLE file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(file_handle == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file_handle);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file_handle, 0, PAGE_READONLY, 0, 0, 0);
+    CloseHandle(file_handle);
+    if(!mapping) return false;
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!data)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    file->data = (u8 *)data;
+    file->size = (u64)file_size.QuadPart;
+    file->platform_handle = (void *)mapping;
+#else
+    int file_descriptor = open(path, O_RDONLY);
+    if(file_descriptor < 0) return false;
+    struct stat file_stat;
+    if(fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        close(file_descriptor);
+        return false;
+    }
+    void *data = mmap(0, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    close(file_descriptor);
+    if(data == MAP_FAILED) return false;
+    file->data = (u8 *)data;
+    file->size = (u64)file_stat.st_size;
+#endif
+    return true;
+}
+
+void tgui_platform_unmap_file(TGuiMappedFile *file)
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(file->data);
+    CloseHandle((HANDLE)file->platform_handle);
+#else
+    munmap(file->data, (size_t)file->size);
+#endif
+    memset(file, 0, sizeof(TGuiMappedFile));
+}
+
+void tgui_platform_release_pages(void *memory, u64 size)
+{
+    // NOTE: tell the os that this pages of a read only mapping can be drop, they are reload if they are touch again
+#if defined(_WIN32)
+    // NOTE: file backed pages on windows are already trimmed by the working set manager
+    UNUSED_VAR(memory);
+    UNUSED_VAR(size);
+#else
+    u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+    u64 start = ((u64)memory + page_size - 1) & ~(page_size - 1);
+    u64 end = ((u64)memory + size) & ~(page_size - 1);
+    if(end > start)
+    {
+        madvise((void *)start, (size_t)(end - start), MADV_DONTNEED);
+    }
+#endif
+}
+
+typedef struct TGuiThreadStart
+{
+    TGuiThreadFP function;
+    void *data;
+} TGuiThreadStart;
+
+#if defined(_WIN32)
+static DWORD WINAPI tgui_platform_thread_proc(LPVOID parameter)
+#else
+static void *tgui_platform_thread_proc(void *parameter)
+#endif
+{
+    TGuiThreadStart start = *(TGuiThreadStart *)parameter;
+    free(parameter);
+    start.function(start.data);
+    return 0;
+}
+
+// NOTE: return 0 if the thread cant be create, the caller must do the work in other way
+TGuiThread tgui_platform_thread_create(TGuiThreadFP function, void *data)
+{
+    TGuiThreadStart *start = (TGuiThreadStart *)malloc(sizeof(TGuiThreadStart));
+    start->function = function;
+    start->data = data;
+#if defined(_WIN32)
+    HANDLE thread = CreateThread(0, 0, tgui_platform_thread_proc, start, 0, 0);
+    if(!thread) free(start);
+    return (TGuiThread)thread;
+#else
+    pthread_t *thread = (pthread_t *)malloc(sizeof(pthread_t));
+    if(pthread_create(thread, 0, tgui_platform_thread_proc, start) != 0)
+    {
+        free(thread);
+        free(start);
+        return 0;
+    }
+    return (TGuiThread)thread;
+#endif
+}
+
+void tgui_platform_thread_join(TGuiThread thread)
+{
+#if defined(_WIN32)
+    WaitForSingleObject((HANDLE)thread, INFINITE);
+    CloseHandle((HANDLE)thread);
+#else
+    pthread_join(*(pthread_t *)thread, 0);
+    free(thread);
+#endif
+}
+
+f64 tgui_platform_get_time(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (f64)time.tv_sec + (f64)time.tv_nsec*1e-9;
+#endif
+}
+
+typedef struct TGuiPlatformSync
+{
+#if defined(_WIN32)
+    SRWLOCK lock;
+    CONDITION_VARIABLE condition;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+#endif
+} TGuiPlatformSync;
+
+TGuiSync tgui_platform_sync_create(void)
+{
+    TGuiPlatformSync *sync = (TGuiPlatformSync *)malloc(sizeof(TGuiPlatformSync));
+#if defined(_WIN32)
+    InitializeSRWLock(&sync->lock);
+    InitializeConditionVariable(&sync->condition);
+#else
+    pthread_mutex_init(&sync->mutex, 0);
+    pthread_cond_init(&sync->condition, 0);
+#endif
+    return (TGuiSync)sync;
+}
+
+void tgui_platform_sync_destroy(TGuiSync sync)
+{
+#if !defined(_WIN32)
+    pthread_mutex_destroy(&((TGuiPlatformSync *)sync)->mutex);
+    pthread_cond_destroy(&((TGuiPlatformSync *)sync)->condition);
+#endif
+    free(sync);
+}
+
+void tgui_platform_sync_lock(TGuiSync sync)
+{
+#if defined(_WIN32)
+    AcquireSRWLockExclusive(&((TGuiPlatformSync *)sync)->lock);
+#else
+    pthread_mutex_lock(&((TGuiPlatformSync *)sync)->mutex);
+#endif
+}
+
+void tgui_platform_sync_unlock(TGuiSync sync)
+{
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive(&((TGuiPlatformSync *)sync)->lock);
+#else
+    pthread_mutex_unlock(&((TGuiPlatformSync *)sync)->mutex);
+#endif
+}
+
+void tgui_platform_sync_wait(TGuiSync sync)
+{
+    TGuiPlatformSync *platform_sync = (TGuiPlatformSync *)sync;
+#if defined(_WIN32)
+    SleepConditionVariableSRW(&platform_sync->condition, &platform_sync->lock, INFINITE, 0);
+#else
+    pthread_cond_wait(&platform_sync->condition, &platform_sync->mutex);
+#endif
+}
+
+// NOTE: wake all the threads that wait, every one check its own condition
+void tgui_platform_sync_wake(TGuiSync sync)
+{
+#if defined(_WIN32)
+    WakeAllConditionVariable(&((TGuiPlatformSync *)sync)->condition);
+#else
+    pthread_cond_broadcast(&((TGuiPlatformSync *)sync)->condition);
+#endif
+}
+
+u32 tgui_platform_cpu_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (u32)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+#endif
+}
+
+u32 tgui_platform_thread_id(void)
+{
+#if defined(_WIN32)
+    return (u32)GetCurrentThreadId();
+#else
+    return (u32)syscall(SYS_gettid);
+#endif
+}
+
+//-----------------------------------------------------
+// NOTE: image functions
+//-----------------------------------------------------
+
+// NOTE: 8192x8192, bigger bitmaps are rejected so the pitch and the converted size dont overflow
+#define TGUI_BMP_MAX_PIXELS ((u64)1 << 26)
+
+inline static u16 tgui_read_u16(u8 *data)
+{
+    u16 result;
+    memcpy(&result, data, sizeof(u16));
+    return result;
+}
+
+inline static u32 tgui_read_u32(u8 *data)
+{
+    u32 result;
+    memcpy(&result, data, sizeof(u32));
+    return result;
+}
+
+static void tgui_convert_row_24(u32 *dst, u8 *src, u32 width)
+{
+    u32 x = 0;
+#if TGUI_SSE2
+    // NOTE: 4 pixels BGR BGR BGR BGR to BGRA BGRA BGRA BGRA, every pixel is shifted to the start of a register
+    // and the first dword of the 4 are interleaved, the byte after the pixel is replace by the alpha.
+    // The load read 16 bytes so stop 2 pixels before the end
+    __m128i alpha = _mm_set1_epi32((i32)0xFF000000);
+    for(; x + 6 <= width; x += 4)
+    {
+        __m128i bgr = _mm_loadu_si128((__m128i *)(src + x*3));
+        __m128i pixels01 = _mm_unpacklo_epi32(bgr, _mm_srli_si128(bgr, 3));
+        __m128i pixels23 = _mm_unpacklo_epi32(_mm_srli_si128(bgr, 6), _mm_srli_si128(bgr, 9));
+        __m128i bgra = _mm_or_si128(_mm_unpacklo_epi64(pixels01, pixels23), alpha);
+        _mm_storeu_si128((__m128i *)(dst + x), bgra);
+    }
+#endif
+    for(; x < width; ++x)
+    {
+        u8 *pixel = src + x*3;
+        dst[x] = 0xFF000000 | ((u32)pixel[2] << 16) | ((u32)pixel[1] << 8) | (u32)pixel[0];
+    }
+}
+
+// NOTE: the bitmaps without alpha mask have the alpha byte in 0, it is set to opaque
+static void tgui_convert_row_32(u32 *dst, u8 *src, u32 width)
+{
+    u32 x = 0;
+#if TGUI_SSE2
+    __m128i alpha = _mm_set1_epi32((i32)0xFF000000);
+    for(; x + 4 <= width; x += 4)
+    {
+        __m128i bgrx = _mm_loadu_si128((__m128i *)(src + x*4));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_or_si128(bgrx, alpha));
+    }
+#endif
+    for(; x < width; ++x)
+    {
+        dst[x] = 0xFF000000 | tgui_read_u32(src + x*4);
+    }
+}
+
+static void tgui_convert_row_8(u32 *dst, u8 *src, u32 width, u32 *palette)
+{
+    // NOTE: the palette is a 256 entries lookup table, there is no gather in SSE so 4 pixels are expanded
+    // for iteration and store with a single 16 bytes store
+    u32 x = 0;
+#if TGUI_SSE2
+    for(; x + 4 <= width; x += 4)
+    {
+        __m128i colors = _mm_setr_epi32((i32)palette[src[x + 0]], (i32)palette[src[x + 1]],
+                                        (i32)palette[src[x + 2]], (i32)palette[src[x + 3]]);
+        _mm_storeu_si128((__m128i *)(dst + x), colors);
+    }
+#endif
+    for(; x < width; ++x)
+    {
+        dst[x] = palette[src[x]];
+    }
+}
+
+b32 tgui_load_bmp(TGuiImage *image, char *path)
+{
+    memset(image, 0, sizeof(TGuiImage));
+    if(!tgui_platform_map_file(&image->file, path))
+    {
+        return false;
+    }
+    
+    u8 *data = image->file.data;
+    if(image->file.size < 54 || tgui_read_u16(data) != 0x4D42)
+    {
+        tgui_free_bmp(image);
+        return false;
+    }
+    u32 pixel_array_offset = tgui_read_u32(data + 10);
+    u32 dib_header_size = tgui_read_u32(data + 14);
+    i32 width = (i32)tgui_read_u32(data + 18);
+    i32 height = (i32)tgui_read_u32(data + 22);
+    u16 bits_per_pixel = tgui_read_u16(data + 28);
+    u32 compression = tgui_read_u32(data + 30);
+    u32 colors_used = tgui_read_u32(data + 46);
+    
+    // NOTE: positive height means the rows are store bottom up, INT_MIN cant be negated
+    b32 bottom_up = height > 0;
+    if(width <= 0 || height == 0 || height == (i32)0x80000000 ||
+       (bits_per_pixel != 8 && bits_per_pixel != 24 && bits_per_pixel != 32))
+    {
+        tgui_free_bmp(image);
+        return false;
+    }
+    if(height < 0) height = -height;
+    // NOTE: the size is compute in 64 bits, a crafted width can overflow 32 bits and give a row of 0 bytes
+    u64 row_size = (((u64)width * bits_per_pixel + 31) / 32) * 4;
+    if((u64)width * (u64)height > TGUI_BMP_MAX_PIXELS ||
+       (u64)pixel_array_offset > image->file.size ||
+       row_size * (u64)height > image->file.size - pixel_array_offset)
+    {
+        tgui_free_bmp(image);
+        return false;
+    }
+    
+    TGuiBitmap *bitmap = &image->bitmap;
+    bitmap->width = (u32)width;
+    bitmap->height = (u32)height;
+    u8 *first_row = data + pixel_array_offset;
+    
+    // NOTE: 0 = BI_RGB, 3 = BI_BITFIELDS. The masks are after the 40 bytes header or inside the bigger
+    // ones, the alpha mask is only in the headers of 56 bytes or more
+    b32 standard_masks = (compression == 0);
+    b32 alpha_mask = false;
+    if(compression == 3 && image->file.size >= 66)
+    {
+        standard_masks = tgui_read_u32(data + 54) == 0x00FF0000 &&
+                         tgui_read_u32(data + 58) == 0x0000FF00 &&
+                         tgui_read_u32(data + 62) == 0x000000FF;
+        // NOTE: the alpha mask is the bytes 66 to 69, inside the header and the file
+        alpha_mask = 14 + (u64)dib_header_size >= 70 && image->file.size >= 70 &&
+                     tgui_read_u32(data + 66) == 0xFF000000;
+    }
+
+    // NOTE: only the bitmaps with alpha can be use without copy, the rest need the alpha set to opaque
+    if(bits_per_pixel == 32 && standard_masks && alpha_mask)
+    {
+        // NOTE: zero copy, the bitmap point directly into the file
+        if(bottom_up)
+        {
+            bitmap->pixels = (u32 *)(first_row + (u64)row_size * (u64)(height - 1));
+            bitmap->pitch = -(i32)row_size;
+        }
+        else
+        {
+            bitmap->pixels = (u32 *)first_row;
+            bitmap->pitch = (i32)row_size;
+        }
+        return true;
+    }
+    
+    // NOTE: only 32, 24 and 8 bits uncompressed bitmaps are supported, the rest (16 bits, RLE,
+    // other masks) are not an error of the program, the load just fail
+    b32 supported = (bits_per_pixel == 32 && standard_masks) ||
+                    ((bits_per_pixel == 24 || bits_per_pixel == 8) && compression == 0);
+    if(!supported)
+    {
+        tgui_free_bmp(image);
+        return false;
+    }
+    
+    u32 palette[256] = {0};
+    if(bits_per_pixel == 8)
+    {
+        u64 palette_offset = 14 + (u64)dib_header_size;
+        if(colors_used == 0 || colors_used > 256) colors_used = 256;
+        if(palette_offset + colors_used*4 > image->file.size)
+        {
+            tgui_free_bmp(image);
+            return false;
+        }
+        u8 *palette_data = data + palette_offset;
+        for(u32 index = 0; index < colors_used; ++index)
+        {
+            palette[index] = 0xFF000000 | tgui_read_u32(palette_data + index*4);
+        }
+    }
+    
+    // NOTE: the converted pixels are store top down
+    image->converted_pixels = (u32 *)malloc((u64)width * (u64)height * sizeof(u32));
+    bitmap->pixels = image->converted_pixels;
+    bitmap->pitch = width * sizeof(u32);
+    for(i32 y = 0; y < height; ++y)
+    {
+        i32 src_y = bottom_up ? (height - 1 - y) : y;
+        u8 *src_row = first_row + (u64)row_size * (u64)src_y;
+        u32 *dst_row = bitmap->pixels + (u64)y * (u64)width;
+        if(bits_per_pixel == 32)
+        {
+            tgui_convert_row_32(dst_row, src_row, width);
+        }
+        else if(bits_per_pixel == 24)
+        {
+            tgui_convert_row_24(dst_row, src_row, width);
+        }
+        else
+        {
+            tgui_convert_row_8(dst_row, src_row, width, palette);
+        }
+    }
+    
+    // NOTE: the file is not needed any more
+    tgui_platform_unmap_file(&image->file);
+    return true;
+}
+
+void tgui_free_bmp(TGuiImage *image)
+{
+    if(image->file.data)
+    {
+        tgui_platform_unmap_file(&image->file);
+    }
+    free(image->converted_pixels);
+    memset(image, 0, sizeof(TGuiImage));
+}
+
+u32 tgui_asset_name_hash(char *name, u32 height)
+{
+    // NOTE: FNV-1a, the height is part of the key so the same font can be store in different sizes
+    u32 hash = 2166136261u;
+    for(char *character = name; *character; ++character)
+    {
+        hash ^= (u8)*character;
+        hash *= 16777619u;
+    }
+    hash ^= height * 0x9E3779B1u;
+    return hash;
+}
+
+// NOTE: true if the range is inside the file, write as a subtraction so a big offset cant overflow
+inline static b32 tgui_asset_pack_range(u64 offset, u64 size, u64 file_size)
+{
+    return offset <= file_size && size <= file_size - offset;
+}
+
+// NOTE: every entry is check once here, so the finds and the views dont read out of the file
+static b32 tgui_asset_pack_validate(TGuiAssetPack *pack)
+{
+    u8 *data = pack->file.data;
+    u64 file_size = pack->file.size;
+    TGuiAssetPackHeader *header = (TGuiAssetPackHeader *)data;
+    b32 valid = file_size >= sizeof(TGuiAssetPackHeader) &&
+                header->magic == TGUI_ASSET_PACK_MAGIC &&
+                header->version == TGUI_ASSET_PACK_VERSION &&
+                header->file_size == file_size &&
+                header->font_count <= TGUI_ASSET_PACK_MAX_FONTS &&
+                header->name_count && !(header->name_count & (header->name_count - 1)) &&
+                header->atlas_pitch >= 0 && (u64)header->atlas_pitch >= (u64)header->atlas_width*sizeof(u32) &&
+                tgui_asset_pack_range(header->atlas_offset, (u64)header->atlas_pitch*header->atlas_height, file_size) &&
+                tgui_asset_pack_range(header->bitmaps_offset, (u64)header->bitmap_count*sizeof(TGuiAssetPackBitmap), file_size) &&
+                tgui_asset_pack_range(header->fonts_offset, (u64)header->font_count*sizeof(TGuiAssetPackFont), file_size) &&
+                tgui_asset_pack_range(header->names_offset, (u64)header->name_count*sizeof(TGuiAssetPackName), file_size) &&
+                header->strings_offset <= file_size;
+    if(!valid) return false;
+
+    TGuiAssetPackBitmap *bitmaps = (TGuiAssetPackBitmap *)(data + header->bitmaps_offset);
+    for(u32 bitmap_index = 0; bitmap_index < header->bitmap_count; ++bitmap_index)
+    {
+        TGuiAssetPackBitmap *bitmap = bitmaps + bitmap_index;
+        if((u64)bitmap->x + bitmap->width > header->atlas_width ||
+           (u64)bitmap->y + bitmap->height > header->atlas_height)
+        {
+            return false;
+        }
+    }
+
+    TGuiAssetPackFont *fonts = (TGuiAssetPackFont *)(data + header->fonts_offset);
+    for(u32 font_index = 0; font_index < header->font_count; ++font_index)
+    {
+        if(fonts[font_index].bitmap_index >= header->bitmap_count) return false;
+    }
+
+    // NOTE: the strings must end inside the file, strcmp in the find dont have a limit
+    TGuiAssetPackName *names = (TGuiAssetPackName *)(data + header->names_offset);
+    char *strings = (char *)(data + header->strings_offset);
+    u64 strings_size = file_size - header->strings_offset;
+    for(u32 name_index = 0; name_index < header->name_count; ++name_index)
+    {
+        TGuiAssetPackName *name = names + name_index;
+        if(name->type == TGUI_ASSET_NONE) continue;
+        if(name->type != TGUI_ASSET_BITMAP && name->type != TGUI_ASSET_FONT) return false;
+        if(name->type == TGUI_ASSET_BITMAP && name->index >= header->bitmap_count) return false;
+        if(name->type == TGUI_ASSET_FONT && name->index >= header->font_count) return false;
+        if(name->string_offset >= strings_size) return false;
+        if(!memchr(strings + name->string_offset, 0, strings_size - name->string_offset)) return false;
+    }
+    return true;
+}
+
+b32 tgui_asset_pack_open(TGuiAssetPack *pack, char *path)
+{
+    memset(pack, 0, sizeof(TGuiAssetPack));
+    if(!tgui_platform_map_file(&pack->file, path))
+    {
+        return false;
+    }
+    
+    // NOTE: this is the only work done at load time, the rest is resolved when the assets are requested
+    if(!tgui_asset_pack_validate(pack))
+    {
+        tgui_asset_pack_close(pack);
+        return false;
+    }
+    pack->header = (TGuiAssetPackHeader *)pack->file.data;
+    return true;
+}
+
+void tgui_asset_pack_close(TGuiAssetPack *pack)
+{
+    if(pack->file.data)
+    {
+        tgui_platform_unmap_file(&pack->file);
+    }
+    memset(pack, 0, sizeof(TGuiAssetPack));
+}
+
+static TGuiAssetPackName *tgui_asset_pack_find(TGuiAssetPack *pack, char *name, u32 height, TGuiAssetType type)
+{
+    TGuiAssetPackHeader *header = pack->header;
+    TGuiAssetPackName *names = (TGuiAssetPackName *)(pack->file.data + header->names_offset);
+    char *strings = (char *)(pack->file.data + header->strings_offset);
+    u32 hash = tgui_asset_name_hash(name, height);
+    u32 mask = header->name_count - 1;
+    for(u32 probe = 0; probe < header->name_count; ++probe)
+    {
+        TGuiAssetPackName *entry = names + ((hash + probe) & mask);
+        if(entry->type == TGUI_ASSET_NONE) return 0;
+        if(entry->hash == hash && entry->type == type && strcmp(strings + entry->string_offset, name) == 0)
+        {
+            return entry;
+        }
+    }
+    return 0;
+}
+
+static TGuiBitmap tgui_asset_pack_bitmap_view(TGuiAssetPack *pack, u32 bitmap_index)
+{
+    // NOTE: the bitmap is a view of the atlas, it use the atlas pitch
+    TGuiAssetPackHeader *header = pack->header;
+    TGuiAssetPackBitmap *pack_bitmap = (TGuiAssetPackBitmap *)(pack->file.data + header->bitmaps_offset) + bitmap_index;
+    u8 *atlas = pack->file.data + header->atlas_offset;
+    TGuiBitmap result = {0};
+    result.pixels = (u32 *)(atlas + (u64)pack_bitmap->y * header->atlas_pitch) + pack_bitmap->x;
+    result.width = pack_bitmap->width;
+    result.height = pack_bitmap->height;
+    result.pitch = header->atlas_pitch;
+    return result;
+}
+
+b32 tgui_asset_pack_get_bitmap(TGuiAssetPack *pack, char *name, TGuiBitmap *bitmap)
+{
+    TGuiAssetPackName *entry = tgui_asset_pack_find(pack, name, 0, TGUI_ASSET_BITMAP);
+    if(!entry || entry->index >= pack->header->bitmap_count) return false;
+    *bitmap = tgui_asset_pack_bitmap_view(pack, entry->index);
+    return true;
+}
+
+b32 tgui_asset_pack_get_font(TGuiAssetPack *pack, char *name, u32 height, TGuiFont *font)
+{
+    // NOTE: use the pre scaled font if the pack has one for this height, if not use the original one
+    TGuiAssetPackName *entry = tgui_asset_pack_find(pack, name, height, TGUI_ASSET_FONT);
+    if(!entry) entry = tgui_asset_pack_find(pack, name, 0, TGUI_ASSET_FONT);
+    if(!entry || entry->index >= pack->header->font_count) return false;
+    
+    TGuiAssetPackFont *pack_font = (TGuiAssetPackFont *)(pack->file.data + pack->header->fonts_offset) + entry->index;
+    if(pack_font->bitmap_index >= pack->header->bitmap_count) return false;
+    TGuiBitmap *bitmap = pack->font_bitmaps + entry->index;
+    *bitmap = tgui_asset_pack_bitmap_view(pack, pack_font->bitmap_index);
+    *font = tgui_create_font(bitmap, pack_font->char_width, pack_font->char_height, pack_font->num_rows, pack_font->num_cols);
+    return true;
+}
+
 //-----------------------------------------------------
 // NOTE: DEBUG functions
 //-----------------------------------------------------
@@ -1948,6 +7912,7 @@ TGuiBitmap tgui_debug_load_bmp(char *path)
         TGuiBitmap result = {0};
         result.width = bmp_header.width;
         result.height = bmp_header.height;
+        result.pitch = result.width * sizeof(u32);
         u64 bitmap_size = result.width * result.height * bytes_per_pixel;
         result.pixels = (u32 *)malloc(bitmap_size); 
         
@@ -1983,12 +7948,18 @@ void tgui_debug_free_bmp(TGuiBitmap *bitmap)
     bitmap->pixels = 0;
     bitmap->width = 0;
     bitmap->height = 0;
+    bitmap->pitch = 0;
 }
 
 void tgui_clear_backbuffer(TGuiBitmap *backbuffer)
 {
-    size_t backbuffer_size = (backbuffer->width*backbuffer->height*sizeof(u32));
-    memset(backbuffer->pixels, 0, backbuffer_size);
+    TGUI_RASTER_COUNT(TGUI_COUNTER_PIXELS_WRITTEN, (u64)backbuffer->width*backbuffer->height);
+    u8 *row = (u8 *)backbuffer->pixels;
+    for(u32 y = 0; y < backbuffer->height; ++y)
+    {
+        memset(row, 0, backbuffer->width*sizeof(u32));
+        row += backbuffer->pitch;
+    }
 }
 
 //-----------------------------------------------------
@@ -2019,6 +7990,7 @@ void tgui_clipping_stack_push(TGuiClippingStack *stack, TGuiRect clipping)
 {
     // TODO: remove this ASSERT();
     ASSERT(stack->buffer_size < 16);
+    TGUI_RASTER_COUNT(TGUI_COUNTER_CLIP_PUSHES, 1);
     
     if(stack->top == stack->buffer_size)
     {
@@ -2076,6 +8048,7 @@ void tgui_draw_rect(TGuiBitmap *backbuffer, i32 min_x, i32 min_y, i32 max_x, i32
     TGuiClipResult clipping = tgui_clip_rect(min_x, min_y, max_x, max_y, tgui_clipping_stack_top(&global_clipping_stack));
     i32 width = clipping.max_x - clipping.min_x;
     i32 height = clipping.max_y - clipping.min_y;
+    if(width > 0 && height > 0) TGUI_RASTER_COUNT(TGUI_COUNTER_PIXELS_WRITTEN, (u64)width*height);
     u8 *row = (u8 *)backbuffer->pixels + clipping.min_y * backbuffer->pitch;
     for(i32 y = 0; y < height; ++y)
     {
@@ -2088,6 +8061,48 @@ void tgui_draw_rect(TGuiBitmap *backbuffer, i32 min_x, i32 min_y, i32 max_x, i32
     }
 }
 
+// NOTE: the pixels at the ends of a span are blend with the coverage of the span
+void tgui_draw_spans(TGuiBitmap *backbuffer, i32 x, i32 y, i32 height, TGuiSpan *spans, u32 span_count, u32 color)
+{
+    TGuiClipResult clipping = tgui_clip_rect(x, y, x + (i32)span_count, y + height, tgui_clipping_stack_top(&global_clipping_stack));
+    u64 pixel_count = 0;
+    for(i32 pixel_x = clipping.min_x; pixel_x < clipping.max_x; ++pixel_x)
+    {
+        TGuiSpan span = spans[pixel_x - x];
+        f32 top = y + span.min_y;
+        f32 bottom = y + span.max_y;
+        i32 min_y = TGUI_MAX((i32)floorf(top), clipping.min_y);
+        i32 max_y = TGUI_MIN((i32)ceilf(bottom), clipping.max_y);
+        if(max_y <= min_y) continue;
+        pixel_count += max_y - min_y;
+        
+        u8 *row = (u8 *)backbuffer->pixels + min_y * backbuffer->pitch;
+        for(i32 pixel_y = min_y; pixel_y < max_y; ++pixel_y)
+        {
+            u32 *pixel = (u32 *)row + pixel_x;
+            f32 coverage = TGUI_MIN(bottom, (f32)(pixel_y + 1)) - TGUI_MAX(top, (f32)pixel_y);
+            if(coverage >= 1.0f)
+            {
+                *pixel = color;
+            }
+            else
+            {
+                u32 alpha = (u32)(coverage*255.0f + 0.5f);
+                u32 result = 0xFF000000;
+                for(u32 shift = 0; shift < 24; shift += 8)
+                {
+                    u32 src = (color >> shift) & 0xFF;
+                    u32 dst = (*pixel >> shift) & 0xFF;
+                    result |= ((src*alpha + dst*(255 - alpha) + 127)/255) << shift;
+                }
+                *pixel = result;
+            }
+            row += backbuffer->pitch;
+        }
+    }
+    TGUI_RASTER_COUNT(TGUI_COUNTER_PIXELS_WRITTEN, pixel_count);
+}
+
 void tgui_draw_rounded_rect(TGuiBitmap *backbuffer, i32 min_x, i32 min_y, i32 max_x, i32 max_y, u32 color, u32 radius)
 {
     f32 diameter = radius*2;
@@ -2099,6 +8114,7 @@ void tgui_draw_rounded_rect(TGuiBitmap *backbuffer, i32 min_x, i32 min_y, i32 ma
     TGuiClipResult clipping = tgui_clip_rect(min_x, min_y, max_x, max_y, tgui_clipping_stack_top(&global_clipping_stack));
     i32 width = clipping.max_x - clipping.min_x;
     i32 height = clipping.max_y - clipping.min_y;
+    if(width > 0 && height > 0) TGUI_RASTER_COUNT(TGUI_COUNTER_PIXELS_WRITTEN, (u64)width*height);
     
     u8 *row = (u8 *)backbuffer->pixels + clipping.min_y * backbuffer->pitch;
     for(i32 y = 0; y < height; ++y)
@@ -2181,6 +8197,7 @@ void tgui_draw_circle_aa(TGuiBitmap *backbuffer, i32 x, i32 y, u32 color, u32 ra
     i32 min_y = clipping.min_y;
     i32 max_x = clipping.max_x;
     i32 max_y = clipping.max_y;
+    if(max_x > min_x && max_y > min_y) TGUI_RASTER_COUNT(TGUI_COUNTER_PIXELS_WRITTEN, (u64)(max_x - min_x)*(max_y - min_y));
 
     u8 *row = (u8 *)backbuffer->pixels + min_y * backbuffer->pitch;
     for(i32 pixel_y = min_y; pixel_y < max_y; ++pixel_y)
@@ -2223,19 +8240,49 @@ void tgui_copy_bitmap(TGuiBitmap *backbuffer, TGuiBitmap *bitmap, i32 x, i32 y)
     TGuiClipResult clipping = tgui_clip_rect(min_x, min_y, max_x, max_y, tgui_clipping_stack_top(&global_clipping_stack));
     i32 width = clipping.max_x - clipping.min_x;
     i32 height = clipping.max_y - clipping.min_y;
+    if(width > 0 && height > 0) TGUI_RASTER_COUNT(TGUI_COUNTER_PIXELS_WRITTEN, (u64)width*height);
 
     u8 *row = (u8 *)backbuffer->pixels + clipping.min_y * backbuffer->pitch;
-    u32 *bmp_row = bitmap->pixels + clipping.offset_y * bitmap->width;
+    u8 *bmp_row = (u8 *)bitmap->pixels + clipping.offset_y * bitmap->pitch;
     for(i32 y = 0; y < height; ++y)
     {
         u32 *pixels = (u32 *)row + clipping.min_x;
-        u32 *bmp_pixels = bmp_row + clipping.offset_x;
+        u32 *bmp_pixels = (u32 *)bmp_row + clipping.offset_x;
         for(i32 x = 0; x < width; ++x)
         {
             *pixels++ = *bmp_pixels++;
         }
         row += backbuffer->pitch;
-        bmp_row += bitmap->width;
+        bmp_row += bitmap->pitch;
+    }
+}
+
+void tgui_copy_bitmap_alpha(TGuiBitmap *backbuffer, TGuiBitmap *bitmap, i32 x, i32 y)
+{
+    i32 min_x = x;
+    i32 min_y = y;
+    i32 max_x = min_x + bitmap->width;
+    i32 max_y = min_y + bitmap->height;
+     
+    TGuiClipResult clipping = tgui_clip_rect(min_x, min_y, max_x, max_y, tgui_clipping_stack_top(&global_clipping_stack));
+    i32 width = clipping.max_x - clipping.min_x;
+    i32 height = clipping.max_y - clipping.min_y;
+    if(width > 0 && height > 0) TGUI_RASTER_COUNT(TGUI_COUNTER_PIXELS_WRITTEN, (u64)width*height);
+
+    u8 *row = (u8 *)backbuffer->pixels + clipping.min_y * backbuffer->pitch;
+    u8 *bmp_row = (u8 *)bitmap->pixels + clipping.offset_y * bitmap->pitch;
+    for(i32 y = 0; y < height; ++y)
+    {
+        u32 *pixels = (u32 *)row + clipping.min_x;
+        u32 *bmp_pixels = (u32 *)bmp_row + clipping.offset_x;
+        for(i32 x = 0; x < width; ++x)
+        {
+            u32 color = *bmp_pixels++;
+            if(color & 0xFF000000) *pixels = color;
+            ++pixels;
+        }
+        row += backbuffer->pitch;
+        bmp_row += bitmap->pitch;
     }
 }
 
@@ -2252,6 +8299,7 @@ void tgui_draw_src_dest_bitmap(TGuiBitmap *backbuffer, TGuiBitmap *bitmap, TGuiR
     TGuiClipResult clipping = tgui_clip_rect(min_x, min_y, max_x, max_y, tgui_clipping_stack_top(&global_clipping_stack));
     i32 dest_width = clipping.max_x - clipping.min_x;
     i32 dest_height = clipping.max_y - clipping.min_y;
+    if(dest_width > 0 && dest_height > 0) TGUI_RASTER_COUNT(TGUI_COUNTER_PIXELS_WRITTEN, (u64)dest_width*dest_height);
     
     i32 src_min_x = src.x;
     i32 src_min_y = src.y;
@@ -2266,12 +8314,15 @@ void tgui_draw_src_dest_bitmap(TGuiBitmap *backbuffer, TGuiBitmap *bitmap, TGuiR
     {
         f32 ratio_y = (f32)(y + clipping.offset_y) / (f32)dest.height;
         u32 bitmap_y = src_min_y + (u32)((f32)src_height * ratio_y + 0.5f);
+        if(bitmap_y >= (u32)src_max_y) bitmap_y = src_max_y - 1;
+        u32 *bitmap_row = (u32 *)((u8 *)bitmap->pixels + (i64)bitmap_y * bitmap->pitch);
         u32 *pixels = (u32 *)row + clipping.min_x;
         for(i32 x = 0; x < dest_width; ++x)
         {
             f32 ratio_x = (f32)(x + clipping.offset_x) / (f32)dest.width;
             u32 bitmap_x = src_min_x + (u32)((f32)src_width * ratio_x + 0.5f);
-            u32 src_color = bitmap->pixels[bitmap_y*bitmap->width + bitmap_x];
+            if(bitmap_x >= (u32)src_max_x) bitmap_x = src_max_x - 1;
+            u32 src_color = bitmap_row[bitmap_x];
             // TODO: implements real alpha bending
             u8 alpha = (u8)((src_color >> 24) & 0xFF);
             if(alpha > 128) 
@@ -2319,6 +8370,8 @@ TGuiFont tgui_create_font(TGuiBitmap *bitmap, u32 char_width, u32 char_height, u
 void tgui_draw_char(TGuiBitmap *backbuffer, TGuiFont *font, u32 height, i32 x, i32 y, char character)
 {
     ASSERT(font->bitmap && "font must have a bitmap");
+    // NOTE: the font only have the printable ascii characters, text from files can have anything
+    if(character < ' ' || character > '~') return;
     u32 index = (character - ' ');
     u32 x_index = index % font->num_rows;
     u32 y_index = index / font->num_rows;
@@ -1,6 +1,11 @@
 #ifndef TGUI_H
 #define TGUI_H
 
+// NOTE: posix functions (mmap, madvise, pthreads) are hidden with -std=c99
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
 #include <stdint.h>
 #include <assert.h>
 
@@ -24,7 +29,13 @@ typedef double f64;
 #define ASSERT(value) assert(value);
 #define UNUSED_VAR(x) ((void)x)
 #define OFFSET_OFF(s, p) (u64)(&(((s *)0)->p))
+#define TGUI_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define TGUI_MAX(a, b) ((a) > (b) ? (a) : (b))
+#if defined(_WIN32)
 #define TGUI_API __declspec(dllexport)
+#else
+#define TGUI_API
+#endif
 
 // NOTE: color pallete
 #define TGUI_DRAK_BLACK  0xFF282728
@@ -66,12 +77,17 @@ typedef union TGuiRect
     };
 } TGuiRect;
 
+// NOTE: pitch is the number of bytes from one row to the next one,
+// bottom up images have the pixels pointing to the last row and a negative pitch
+// NOTE: the draw commands only keep a pointer to the bitmap, the app increment version when
+// it change the pixels so the damage and the layer cache draw it again
 typedef struct TGuiBitmap
 {
     u32 *pixels;
     u32 width;
     u32 height;
-    u32 pitch;
+    i32 pitch;
+    u32 version;
 } TGuiBitmap;
 
 // NOTE: for now, only support for bitmaps fonts
@@ -85,6 +101,95 @@ typedef struct TGuiFont
     // maybe remove them
 } TGuiFont;
 
+// NOTE: read only file mapped in memory
+typedef struct TGuiMappedFile
+{
+    u8 *data;
+    u64 size;
+    void *platform_handle;
+} TGuiMappedFile;
+
+// NOTE: the bitmap can point directly into the file mapping, in that case the pixels are read only
+typedef struct TGuiImage
+{
+    TGuiBitmap bitmap;
+    TGuiMappedFile file;
+    u32 *converted_pixels;
+} TGuiImage;
+
+// NOTE: asset pack file layout, everything is little endian and the offsets are from the start of the file.
+// The atlas is store top down so the bitmaps and fonts can point directly into the file mapping
+#define TGUI_ASSET_PACK_MAGIC 0x4B504754
+#define TGUI_ASSET_PACK_VERSION 1
+#define TGUI_ASSET_PACK_MAX_FONTS 64
+
+typedef enum TGuiAssetType
+{
+    TGUI_ASSET_NONE,
+    TGUI_ASSET_BITMAP,
+    TGUI_ASSET_FONT,
+} TGuiAssetType;
+
+typedef struct TGuiAssetPackHeader
+{
+    u32 magic;
+    u32 version;
+    u64 file_size;
+    u32 bitmap_count;
+    u32 font_count;
+    // NOTE: number of slots of the name table, always a power of 2
+    u32 name_count;
+    u32 atlas_width;
+    u32 atlas_height;
+    i32 atlas_pitch;
+    u64 atlas_offset;
+    u64 bitmaps_offset;
+    u64 fonts_offset;
+    u64 names_offset;
+    u64 strings_offset;
+} TGuiAssetPackHeader;
+
+typedef struct TGuiAssetPackBitmap
+{
+    // NOTE: rect inside the atlas
+    u32 x;
+    u32 y;
+    u32 width;
+    u32 height;
+} TGuiAssetPackBitmap;
+
+typedef struct TGuiAssetPackFont
+{
+    u32 bitmap_index;
+    u32 char_width;
+    u32 char_height;
+    u32 num_rows;
+    u32 num_cols;
+    // NOTE: 0 for the original font, other values are fonts pre scaled to that pixel height
+    u32 height;
+} TGuiAssetPackFont;
+
+typedef struct TGuiAssetPackName
+{
+    u32 hash;
+    TGuiAssetType type;
+    u32 index;
+    u32 string_offset;
+} TGuiAssetPackName;
+
+typedef struct TGuiAssetPack
+{
+    TGuiMappedFile file;
+    TGuiAssetPackHeader *header;
+    // NOTE: the fonts need a bitmap with a stable address
+    TGuiBitmap font_bitmaps[TGUI_ASSET_PACK_MAX_FONTS];
+} TGuiAssetPack;
+
+typedef void *TGuiThread;
+typedef void (*TGuiThreadFP)(void *data);
+// NOTE: mutex with a condition variable
+typedef void *TGuiSync;
+
 typedef enum TGuiEventType
 {
     TGUI_EVENT_MOUSEMOVE,
@@ -155,6 +260,13 @@ typedef enum TGuiDrawCommandType
     TGUI_DRAWCMD_BITMAP,
     TGUI_DRAWCMD_TEXT,
     TGUI_DRAWCMD_CHAR,
+    // NOTE: the commands between BEGIN_LAYER and END_LAYER are the subtree of a cached container,
+    // the descriptor of BEGIN_LAYER is the rect of the layer and its handle the container
+    TGUI_DRAWCMD_BEGIN_LAYER,
+    TGUI_DRAWCMD_END_LAYER,
+    // NOTE: one vertical span for every column from descriptor.x, the text of the command is the TGuiSpan
+    // array (text_size in bytes) so it is copy and record like the text. The ends of the spans are anti-aliased
+    TGUI_DRAWCMD_SPANS,
     
     TGUI_DRAWCMD_COUNT,
 } TGuiDrawCommandType;
@@ -169,25 +281,117 @@ typedef struct TGuiDrawCommand
     u8 character;
     char *text;
     u32 text_size;
+    // NOTE: widget that emit the command, 0 for the commands of the application
+    TGuiHandle handle;
+    // NOTE: only in the START_CLIPPING of a scroll container, the scroll offset of its content
+    b32 scroll;
+    i32 scroll_x;
+    i32 scroll_y;
 } TGuiDrawCommand;
 
+// NOTE: column of a SPANS command, the y are from the top of the descriptor
+typedef struct TGuiSpan
+{
+    f32 min_y;
+    f32 max_y;
+} TGuiSpan;
+
+// NOTE: linear (bump) allocator, all the memory is release at once with tgui_arena_clear
+#define TGUI_DEFAULT_ARENA_BLOCK_SIZE (64*1024)
+typedef struct TGuiArenaBlock
+{
+    u8 *buffer;
+    u64 buffer_size;
+    u64 used;
+    struct TGuiArenaBlock *next;
+} TGuiArenaBlock;
+
+typedef struct TGuiArena
+{
+    TGuiArenaBlock *first;
+    TGuiArenaBlock *current;
+} TGuiArena;
+
 // TODO: make container structs for this queues, like std::vector<> in c++
 #define TGUI_DRAW_COMMANDS_MAX 512 
+
+// NOTE: rect in pixels, max is exclusive
+typedef struct TGuiDamageRect
+{
+    i32 min_x;
+    i32 min_y;
+    i32 max_x;
+    i32 max_y;
+} TGuiDamageRect;
+
+// NOTE: occlusion culling, the background of a root container is opaque and hide what is under it.
+// The roots are visit from front to back and the background of the roots above are subtracted from
+// the rect of every root, the root is only draw inside the rects that are still visible and the
+// commands that are not inside any of them are culled
+#define TGUI_OCCLUSION_ROOTS_MAX 64
+#define TGUI_OCCLUSION_RECTS_MAX 256
+#define TGUI_OCCLUSION_PIECES_MAX 32
+typedef struct TGuiOcclusionRoot
+{
+    TGuiHandle handle;
+    // NOTE: commands of the root [first, end)
+    u32 first;
+    u32 end;
+    // NOTE: opaque background, empty if the root is not a container
+    TGuiDamageRect opaque;
+    // NOTE: if nothing is above the root it is draw as always, without the visible rects
+    b32 occluded;
+    u32 first_visible;
+    u32 visible_count;
+} TGuiOcclusionRoot;
+
+typedef struct TGuiOcclusion
+{
+    TGuiOcclusionRoot roots[TGUI_OCCLUSION_ROOTS_MAX];
+    u32 root_count;
+    b32 overflow;
+    TGuiDamageRect visible[TGUI_OCCLUSION_RECTS_MAX];
+    u32 visible_count;
+    // NOTE: index by command, the bounds are clipped
+    u8 culled[TGUI_DRAW_COMMANDS_MAX];
+    TGuiDamageRect bounds[TGUI_DRAW_COMMANDS_MAX];
+} TGuiOcclusion;
+
+// NOTE: the buffer has everything that the rasterizer need (the text, the occlusion of the roots), so
+// it can be draw in other thread while the next frame is update
 typedef struct TGuiDrawCommandBuffer
 {
     TGuiDrawCommand buffer[TGUI_DRAW_COMMANDS_MAX];
     u32 head;
     u32 count;
+    // NOTE: per frame memory, the commands own a copy of its text here
+    TGuiArena arena;
+    // NOTE: the handles of the commands are smaller than it
+    u32 handle_count;
+    TGuiOcclusion occlusion;
 } TGuiDrawCommandBuffer;
 
+// NOTE: registry of the widget types of the library, X(type, name, struct). Every type has the functions
+// tgui_<name>_update, tgui_<name>_render, tgui_<name>_measure and tgui_<name>_collision_box, the enum,
+// the union, the sizes and the dispatch switchs are generate from this list. A new type only need its
+// struct, its functions and a line here
+#define TGUI_WIDGET_TYPES(X) \
+    X(TGUI_CONTAINER, container, TGuiWidgetContainer) \
+    X(TGUI_END_CONTAINER, end_container, TGuiWidgetEndContainer) \
+    X(TGUI_BUTTON, button, TGuiWidgetButton) \
+    X(TGUI_CHECKBOX, checkbox, TGuiWidgetCheckBox) \
+    X(TGUI_SLIDER, slider, TGuiWidgetSlider) \
+    X(TGUI_TEXTBOX, textbox, TGuiWidgetTextBox) \
+    X(TGUI_TEXTVIEW, textview, TGuiWidgetTextView) \
+    X(TGUI_PLOT, plot, TGuiWidgetPlot) \
+    X(TGUI_GRID, grid, TGuiWidgetGrid) \
+    X(TGUI_TREE, tree, TGuiWidgetTree)
+
 typedef enum TGuiWidgetType
 {
-    TGUI_CONTAINER,
-    TGUI_END_CONTAINER,
-    TGUI_BUTTON,
-    TGUI_CHECKBOX,
-    TGUI_SLIDER,
-    TGUI_TEXTBOX,
+#define TGUI_WIDGET_TYPE_ENUM(type, name, type_struct) type,
+    TGUI_WIDGET_TYPES(TGUI_WIDGET_TYPE_ENUM)
+#undef TGUI_WIDGET_TYPE_ENUM
     
     TGUI_COUNT,
 } TGuiWidgetType;
@@ -208,6 +412,8 @@ typedef enum TGuiContanerFlags
     TGUI_CONTAINER_H_SCROLL  = 1 << 2,
     TGUI_CONTAINER_DRAGGABLE = 1 << 3,
     TGUI_CONTAINER_RESIZABLE = 1 << 4,
+    // NOTE: the subtree is draw into its own bitmap and only draw again when it change
+    TGUI_CONTAINER_CACHED    = 1 << 5,
 } TGuiContanerFlags;
 
 typedef struct TGuiWidgetLayout
@@ -258,6 +464,11 @@ typedef struct TGuiWidgetContainer
     b32 hot;
 } TGuiWidgetContainer;
 
+typedef struct TGuiWidgetEndContainer
+{
+    TGuiWidgetHeader header;
+} TGuiWidgetEndContainer;
+
 typedef struct TGuiWidgetButton
 {
     TGuiWidgetHeader header;
@@ -290,53 +501,351 @@ typedef struct TGuiWidgetSlider
     TGuiV2 grip_dimension;
 } TGuiWidgetSlider;
 
-#define TGUI_DEFAULT_LINE_SIZE 4
-typedef struct TGuiCharacterAllocator
+// NOTE: text store in a single buffer with a gap at the editing position,
+// insert and delete at the gap are O(1) and moving the gap is a memmove
+#define TGUI_DEFAULT_GAP_BUFFER_SIZE 64
+typedef struct TGuiGapBuffer
 {
     u8 *buffer;
-    u32 count;
     u32 buffer_size;
-} TGuiCharacterAllocator;
-// TODO: this functions can be remove from the header
-void tgui_character_allocator_create(TGuiCharacterAllocator *allocator);
-void tgui_character_allocator_destory(TGuiCharacterAllocator *allocator);
-u8 *tgui_character_allocator_pull(TGuiCharacterAllocator *allocator);
-void tgui_character_allocator_clear(TGuiCharacterAllocator *allocator);
+    u32 gap_start;
+    u32 gap_end;
+} TGuiGapBuffer;
 
-#define TGUI_DEFAULT_NUM_LINES 2
-typedef struct TGuiLineAllocator
+// NOTE: start offset of every line, also with a gap. The entries before the gap
+// are absolute offsets and the entries after the gap are offsets from the end of
+// the text, so inserting or deleting text at the gap dont need to touch them
+#define TGUI_DEFAULT_LINE_INDEX_SIZE 16
+typedef struct TGuiLineIndex
 {
-    TGuiCharacterAllocator *buffer;
-    u32 count;
+    u32 *buffer;
     u32 buffer_size;
-} TGuiLineAllocator;
+    u32 gap_start;
+    u32 gap_end;
+} TGuiLineIndex;
+
+typedef struct TGuiTextBuffer
+{
+    TGuiGapBuffer text;
+    TGuiLineIndex lines;
+} TGuiTextBuffer;
 // TODO: this functions can be remove from the header
-void tgui_line_allocator_create(TGuiLineAllocator *allocator);
-void tgui_line_allocator_destory(TGuiLineAllocator *allocator);
-TGuiCharacterAllocator *tgui_line_allocator_pull(TGuiLineAllocator *allocator);
+void tgui_text_buffer_create(TGuiTextBuffer *buffer);
+void tgui_text_buffer_destroy(TGuiTextBuffer *buffer);
+void tgui_text_buffer_clear(TGuiTextBuffer *buffer);
+u32 tgui_text_buffer_size(TGuiTextBuffer *buffer);
+u32 tgui_text_buffer_line_count(TGuiTextBuffer *buffer);
+u32 tgui_text_buffer_line_start(TGuiTextBuffer *buffer, u32 line);
+u32 tgui_text_buffer_line_size(TGuiTextBuffer *buffer, u32 line);
+u32 tgui_text_buffer_find_line(TGuiTextBuffer *buffer, u32 offset);
+void tgui_text_buffer_insert(TGuiTextBuffer *buffer, u32 offset, u8 *text, u32 text_size);
+void tgui_text_buffer_delete(TGuiTextBuffer *buffer, u32 start, u32 end);
+void tgui_text_buffer_copy(TGuiTextBuffer *buffer, u32 start, u32 size, u8 *dst);
+u8 *tgui_text_buffer_get_text(TGuiTextBuffer *buffer, u32 start, u32 size, TGuiArena *arena);
 
 typedef struct TGuiWidgetTextBox
 {
     TGuiWidgetHeader header;
     //----------------------
     b32 hot;
-    TGuiLineAllocator allocator;
+    TGuiTextBuffer text;
     TGuiV2i cursor_position;
+    // NOTE: first visible column (x) and line (y)
+    TGuiV2i scroll;
     TGuiV2 dimension;
     u32 margin;
+    // NOTE: time of the last edit or activation, the cursor blink from here
+    f64 blink_start;
 } TGuiWidgetTextBox;
 
+// NOTE: line offsets of the file, only one of every TGUI_TEXTVIEW_INDEX_STRIDE lines is store
+// so the memory used by the index is bounded. It is filled by a background thread
+#define TGUI_TEXTVIEW_INDEX_STRIDE 64
+#define TGUI_TEXTVIEW_INDEX_PAGE_SIZE 4096
+#define TGUI_TEXTVIEW_INDEX_MAX_PAGES 4096
+#define TGUI_TEXTVIEW_INDEX_MAX_CHECKPOINTS ((u64)TGUI_TEXTVIEW_INDEX_MAX_PAGES*TGUI_TEXTVIEW_INDEX_PAGE_SIZE)
+#define TGUI_TEXTVIEW_INDEX_CHUNK_SIZE (1024*1024)
+typedef struct TGuiTextViewIndex
+{
+    u8 *data;
+    u64 size;
+    u64 *pages[TGUI_TEXTVIEW_INDEX_MAX_PAGES];
+    // NOTE: this values are written by the index thread
+    volatile u64 line_count;
+    volatile u64 checkpoint_count;
+    volatile b32 done;
+    volatile b32 stop;
+} TGuiTextViewIndex;
+
+typedef struct TGuiWidgetTextView
+{
+    TGuiWidgetHeader header;
+    //----------------------
+    b32 hot;
+    // NOTE: own copy of the path so the view can be reopen (snapshot restore)
+    char *path;
+    TGuiMappedFile file;
+    TGuiTextViewIndex *index;
+    TGuiThread index_thread;
+    u64 scroll_line;
+    u32 scroll_column;
+    TGuiV2 dimension;
+    u32 margin;
+} TGuiWidgetTextView;
+
+// NOTE: min and max of the samples of a column, the next column join with the last sample
+typedef struct TGuiPlotColumn
+{
+    f32 min;
+    f32 max;
+    f32 last;
+} TGuiPlotColumn;
+
+// NOTE: the columns of one zoom, column c has the samples [c*samples_per_column, (c + 1)*samples_per_column)
+// so the complete columns dont change when samples are append. The columns are a ring of column_size,
+// the complete columns [first_column, end_column) are in it
+#define TGUI_PLOT_CACHE_LEVELS 4
+typedef struct TGuiPlotLevel
+{
+    u64 samples_per_column;
+    u64 first_column;
+    u64 end_column;
+    u64 last_use;
+    TGuiPlotColumn *columns;
+} TGuiPlotLevel;
+
+typedef struct TGuiPlotCache
+{
+    TGuiPlotLevel levels[TGUI_PLOT_CACHE_LEVELS];
+    u32 column_size;
+    u64 use_count;
+    // NOTE: the spans of the frame before they are copy to the command
+    TGuiSpan *spans;
+} TGuiPlotCache;
+
+typedef struct TGuiWidgetPlot
+{
+    TGuiWidgetHeader header;
+    //----------------------
+    b32 hot;
+    // NOTE: ring buffer of the application, sample i is samples[i % capacity] and only the last capacity
+    // samples are in it. sample_count is the total of samples append
+    f32 *samples;
+    u64 capacity;
+    u64 sample_count;
+    // NOTE: the last view_count samples are show, one column for every pixel
+    u64 view_count;
+    f32 min_value;
+    f32 max_value;
+    u32 color;
+    TGuiV2 dimension;
+    TGuiPlotCache *cache;
+} TGuiWidgetPlot;
+
+// NOTE: write the text of the cell in buffer and return its size
+typedef u32 (*TGuiGridCellFP)(void *data, u64 row, char *buffer, u32 buffer_size);
+
+typedef enum TGuiGridColumnType
+{
+    TGUI_GRID_COLUMN_F32,
+    TGUI_GRID_COLUMN_I32,
+    TGUI_GRID_COLUMN_STRING,
+    TGUI_GRID_COLUMN_CALLBACK,
+} TGuiGridColumnType;
+
+// NOTE: a column of the application, data is a f32 *, i32 * or char ** with one entry for every row,
+// or the data of the callback. The width is in characters. When the data change call tgui_grid_invalidate
+// so the version change and the cells are format again
+typedef struct TGuiGridColumn
+{
+    char *name;
+    TGuiGridColumnType type;
+    u32 width;
+    void *data;
+    TGuiGridCellFP format;
+    u32 version;
+} TGuiGridColumn;
+
+// NOTE: formatted text of a visible cell, the cache is a table of buckets of TGUI_GRID_CACHE_WAYS cells
+// by (row, column) hash and its size only depend on the visible cells, not on the rows
+#define TGUI_GRID_CELL_TEXT_MAX 32
+#define TGUI_GRID_CACHE_WAYS 4
+typedef struct TGuiGridCell
+{
+    u64 row;
+    u32 column;
+    u32 version;
+    // NOTE: last frame that the cell was draw, the older of the bucket is replace
+    u32 frame;
+    u32 text_size;
+    char text[TGUI_GRID_CELL_TEXT_MAX];
+} TGuiGridCell;
+
+#define TGUI_GRID_ROW_PADDING 4
+typedef struct TGuiGridData
+{
+    TGuiGridColumn *columns;
+    u32 column_count;
+    TGuiGridCell *cells;
+    u32 cell_size;
+    u32 frame;
+    // NOTE: the text of a row of cells, draw in one TEXT command
+    char *run;
+    u32 run_size;
+    u32 cache_hits;
+    u32 cache_misses;
+} TGuiGridData;
+
+typedef struct TGuiWidgetGrid
+{
+    TGuiWidgetHeader header;
+    //----------------------
+    b32 hot;
+    TGuiV2 dimension;
+    u64 row_count;
+    // NOTE: first row and column after the fixed ones
+    u64 scroll_row;
+    u32 scroll_column;
+    u32 fixed_rows;
+    u32 fixed_columns;
+    TGuiGridData *data;
+} TGuiWidgetGrid;
+
+// NOTE: the nodes of a tree are index of the application from 0 to node_count - 1, the tree only ask for
+// the children of the expanded nodes in the rows that are visible
+typedef u32 (*TGuiTreeChildCountFP)(void *data, u32 node);
+typedef u32 (*TGuiTreeChildFP)(void *data, u32 node, u32 index);
+typedef u32 (*TGuiTreeLabelFP)(void *data, u32 node, char *buffer, u32 buffer_size);
+
+typedef struct TGuiTreeSource
+{
+    void *data;
+    TGuiTreeChildCountFP child_count;
+    TGuiTreeChildFP child;
+    TGuiTreeLabelFP label;
+} TGuiTreeSource;
+
+// NOTE: an expanded node, visible is the rows of its subtree without it. A row is found with the list of
+// expanded children of the nodes (sort by index), so a node with many children is never walk
+#define TGUI_TREE_NONE 0xFFFFFFFF
+typedef struct TGuiTreeNode
+{
+    u32 node;
+    // NOTE: entry of the parent and index of the node in its children
+    u32 parent;
+    u32 index;
+    u32 child_count;
+    u32 visible;
+    u32 first_child;
+    u32 next_sibling;
+} TGuiTreeNode;
+
+// NOTE: a child of the node of entry, the rows are walk with a stack of levels. child is the first
+// expanded child with an index not less than index
+typedef struct TGuiTreeLevel
+{
+    u32 entry;
+    u32 index;
+    u32 child;
+} TGuiTreeLevel;
+
+#define TGUI_TREE_ROW_PADDING 4
+#define TGUI_TREE_INDENT 2
+typedef struct TGuiTreeData
+{
+    TGuiTreeSource source;
+    u32 node_count;
+    // NOTE: one bit for every node of the application
+    u32 *expanded;
+    // NOTE: the first entry is the root and it is always expanded, the free ones are a list by next_sibling
+    TGuiTreeNode *nodes;
+    u32 node_size;
+    u32 node_capacity;
+    u32 free_node;
+    // NOTE: space for node_capacity levels
+    TGuiTreeLevel *levels;
+} TGuiTreeData;
+
+typedef struct TGuiWidgetTree
+{
+    TGuiWidgetHeader header;
+    //----------------------
+    b32 hot;
+    TGuiV2 dimension;
+    u32 scroll_row;
+    u32 hot_row;
+    TGuiTreeData *data;
+} TGuiWidgetTree;
+
+// NOTE: the widgets of the application only store a pointer to its data, so they dont grow the union
+typedef struct TGuiWidgetCustom
+{
+    TGuiWidgetHeader header;
+    //----------------------
+    void *data;
+} TGuiWidgetCustom;
+
 typedef union TGuiWidget
 {
     TGuiWidgetHeader header;
     //----------------------
-    TGuiWidgetContainer container;
-    TGuiWidgetButton button;
-    TGuiWidgetCheckBox checkbox;
-    TGuiWidgetSlider slider;
-    TGuiWidgetTextBox textbox;
+#define TGUI_WIDGET_TYPE_MEMBER(type, name, type_struct) type_struct name;
+    TGUI_WIDGET_TYPES(TGUI_WIDGET_TYPE_MEMBER)
+#undef TGUI_WIDGET_TYPE_MEMBER
+    TGuiWidgetCustom custom;
 } TGuiWidget;
 
+// NOTE: functions of a widget type of the application, the types from TGUI_COUNT are find in the registry.
+// The render push its commands with tgui_push_draw_command, release and measure can be null. save write
+// the data of the widget in buffer and return its size, if it dont fit nothing is write and it is call again
+// with a buffer of that size. restore get the same bytes and set the data of the widget. Without save and
+// restore the widgets of the type can not be in a snapshot (or in a record)
+typedef struct TGuiWidgetClass
+{
+    char *name;
+    b32 (*update)(TGuiWidget *widget);
+    void (*render)(TGuiWidget *widget, TGuiV2 abs_pos);
+    TGuiV2 (*measure)(TGuiWidget *widget);
+    TGuiRect (*collision_box)(TGuiWidget *widget, TGuiV2 abs_pos);
+    void (*release)(TGuiWidget *widget);
+    u32 (*save)(TGuiWidget *widget, void *buffer, u32 buffer_size);
+    b32 (*restore)(TGuiWidget *widget, void *data, u32 size);
+} TGuiWidgetClass;
+
+// NOTE: the buttons and checkboxes of the tree in SoA, the boxes are the collision box clipped by the parents
+// so a widget is hot if the mouse is inside its box. The boxes are build again when layout_version change,
+// the hot bits are test for all of them in one pass before the update. The active bits are the same as the
+// flags of the widgets, the pressed bits are the buttons pressed and the checkboxes toggled in the last update
+typedef struct TGuiHitBatch
+{
+    b32 enabled;
+    b32 valid;
+    u32 layout_version;
+    TGuiHandle *handles;
+    f32 *min_x;
+    f32 *min_y;
+    f32 *max_x;
+    f32 *max_y;
+    u32 count;
+    u32 size;
+    // NOTE: one bit for every widget
+    u32 *hot;
+    u32 *active;
+    u32 *pressed;
+    // NOTE: index of a handle in the batch, TGUI_HIT_BATCH_NONE if it is not in the batch
+    u32 *indices;
+    u32 index_count;
+    u32 index_size;
+} TGuiHitBatch;
+#define TGUI_HIT_BATCH_NONE 0xFFFFFFFF
+
+typedef struct TGuiWidgetRegistry
+{
+    TGuiWidgetClass *classes;
+    u32 class_count;
+    u32 class_size;
+} TGuiWidgetRegistry;
+
 typedef struct TGuiWidgetFree
 {
     TGuiHandle handle;
@@ -352,6 +861,400 @@ typedef struct TGuiWidgetPoolAllocator
     TGuiWidgetFree *free_list;
 } TGuiWidgetPoolAllocator;
 
+// NOTE: trace of a session, the snapshot of the tree at the start and then the events
+// and the draw commands of every frame. All the values are store as they are in memory
+//
+//  TGuiTraceHeader | snapshot
+//  chunks: u32 TGuiTraceChunkType | chunk data
+//    TGUI_TRACE_EVENTS:   f64 time | u32 count | TGuiEvent[count]
+//    TGUI_TRACE_COMMANDS: u32 count | u32 host_count | (TGuiTraceCommand | text)[count]
+//                         host_count is how many of the commands are push by the app after tgui_update
+//    TGUI_TRACE_BITMAP:   u32 id | u32 width | u32 height | u32 pixels[width*height]
+#define TGUI_TRACE_MAGIC 0x52544754 // NOTE: "TGTR"
+#define TGUI_TRACE_VERSION 4
+#define TGUI_TRACE_MAX_BITMAPS 64
+typedef enum TGuiTraceChunkType
+{
+    TGUI_TRACE_EVENTS,
+    TGUI_TRACE_COMMANDS,
+    TGUI_TRACE_BITMAP,
+
+    TGUI_TRACE_COUNT,
+} TGuiTraceChunkType;
+
+typedef struct TGuiTraceHeader
+{
+    u32 magic;
+    u32 version;
+    u32 backbuffer_width;
+    u32 backbuffer_height;
+    i32 mouse_x;
+    i32 mouse_y;
+    b32 mouse_is_down;
+    u32 snapshot_size;
+    // NOTE: the replay need the same commands, so it optimize them too
+    b32 optimizer;
+} TGuiTraceHeader;
+
+typedef struct TGuiTraceCommand
+{
+    u32 type;
+    TGuiRect descriptor;
+    u32 ratio;
+    u32 color;
+    u32 character;
+    u32 text_size;
+    // NOTE: 0 is no bitmap, the pixels are write once in a TGUI_TRACE_BITMAP chunk
+    u32 bitmap_id;
+} TGuiTraceCommand;
+
+typedef struct TGuiRecorder
+{
+    void *file;
+    // NOTE: the events of the frame are write at the start of tgui_update and its
+    // draw commands at the start of the next one (the app can push commands after the update)
+    b32 frame_open;
+    // NOTE: commands in the buffer at the end of tgui_update, the rest are push by the app
+    u32 update_count;
+    TGuiBitmap *bitmaps[TGUI_TRACE_MAX_BITMAPS];
+    u32 bitmap_count;
+} TGuiRecorder;
+
+// NOTE: profiling, the timers and counters are only compiled with TGUI_PROFILE defined
+typedef enum TGuiProfileTimer
+{
+    TGUI_TIMER_EVENTS,
+    // NOTE: layout is also inside the update timer when a container is scrolled
+    TGUI_TIMER_LAYOUT,
+    TGUI_TIMER_UPDATE,
+    TGUI_TIMER_RENDER,
+    TGUI_TIMER_RASTER,
+    // NOTE: measure by the application with TGUI_PROFILE_BEGIN/END
+    TGUI_TIMER_PRESENT,
+
+    TGUI_TIMER_COUNT,
+} TGuiProfileTimer;
+
+typedef enum TGuiProfileCounter
+{
+    TGUI_COUNTER_WIDGETS_VISITED,
+    TGUI_COUNTER_HIT_TESTS,
+    TGUI_COUNTER_PIXELS_WRITTEN,
+    TGUI_COUNTER_CLIP_PUSHES,
+    TGUI_COUNTER_BYTES_ALLOCATED,
+    TGUI_COUNTER_DROPPED_EVENTS,
+    TGUI_COUNTER_DROPPED_COMMANDS,
+    TGUI_COUNTER_LAYER_REDRAWS,
+    TGUI_COUNTER_CULLED_COMMANDS,
+    TGUI_COUNTER_OPTIMIZED_COMMANDS,
+
+    TGUI_COUNTER_COUNT,
+} TGuiProfileCounter;
+
+typedef struct TGuiFrameStats
+{
+    f64 frame_ms;
+    // NOTE: all times are in ms
+    f64 timers[TGUI_TIMER_COUNT];
+    // NOTE: raster time of every kind of draw command
+    f64 kernels[TGUI_DRAWCMD_COUNT];
+    u32 draw_commands[TGUI_DRAWCMD_COUNT];
+    u64 counters[TGUI_COUNTER_COUNT];
+} TGuiFrameStats;
+
+// NOTE: the rasterizer (the render thread with the pipeline) count in its own stats, at the end of every
+// frame they are add to raster_done inside the lock of the pipeline. The next tgui_update merge them with
+// the stats of the update thread into last, so the two threads never write the same stats
+typedef struct TGuiProfile
+{
+    f64 frame_start;
+    TGuiFrameStats current;
+    TGuiFrameStats raster;
+    TGuiFrameStats raster_done;
+    TGuiFrameStats last;
+} TGuiProfile;
+
+// NOTE: chrome trace event json (chrome://tracing or ui.perfetto.dev), the spans of a frame
+// are write at the start of the next tgui_update. The update thread and the jobs push spans
+// that are finish before that point. The rasterizer push to its own buffer, it is swap with
+// done_spans at the end of its frame and with flush_spans when the spans are write
+#define TGUI_TIMELINE_MAX_SPANS 16384
+typedef struct TGuiTimelineSpan
+{
+    char *name;
+    f64 start;
+    f64 end;
+    u32 thread_id;
+    // NOTE: 0 if the span is not from a widget
+    TGuiHandle handle;
+    // NOTE: draw commands emitted or rasterized inside the span
+    u32 commands;
+} TGuiTimelineSpan;
+
+typedef struct TGuiTimeline
+{
+    void *file;
+    f64 start_time;
+    f64 frame_start;
+    u32 frame;
+    b32 first_event;
+    TGuiTimelineSpan *spans;
+    u32 span_count;
+    u32 dropped_spans;
+    TGuiTimelineSpan *raster_spans;
+    u32 raster_span_count;
+    TGuiTimelineSpan *done_spans;
+    u32 done_span_count;
+    TGuiTimelineSpan *flush_spans;
+} TGuiTimeline;
+
+// NOTE: debug mode to find the expensive widgets, the rasterizer accumulate the pixels and the time
+// of the commands of every widget and how many times every pixel is written (overdraw).
+// The pixels are the clipped rect of the command, transparent pixels of bitmaps and text are counted
+typedef struct TGuiWidgetCost
+{
+    TGuiHandle handle;
+    TGuiWidgetType type;
+    u32 commands;
+    u64 pixels;
+    f64 ms;
+} TGuiWidgetCost;
+
+typedef enum TGuiCostSort
+{
+    TGUI_COST_SORT_PIXELS,
+    TGUI_COST_SORT_TIME,
+} TGuiCostSort;
+
+// The rasterizer write the costs and the overdraw of its frame, at the end of the frame they are swap
+// (inside the lock of the pipeline) with the done ones that the application read
+typedef struct TGuiDebugCost
+{
+    b32 enabled;
+    // NOTE: index by widget handle
+    TGuiWidgetCost *costs;
+    u32 costs_size;
+    u32 costs_count;
+    // NOTE: write count of every pixel of the backbuffer
+    u16 *overdraw;
+    u32 overdraw_width;
+    u32 overdraw_height;
+    TGuiWidgetCost *done_costs;
+    u32 done_costs_size;
+    u32 done_costs_count;
+    u16 *done_overdraw;
+    u32 done_overdraw_width;
+    u32 done_overdraw_height;
+    TGuiBitmap overdraw_bitmap;
+} TGuiDebugCost;
+
+// NOTE: returned by tgui_update. After the frame the host can sleep until an event arrive or the
+// deadline pass. The deadline is in the clock of tgui_platform_get_time, 0 means that nothing will
+// change with the time. If the frame change is decided later by tgui_frame_changed (or tgui_submit_frame),
+// after the host push its own commands, so the text and overlays of the host are include
+typedef struct TGuiUpdateResult
+{
+    f64 deadline;
+} TGuiUpdateResult;
+
+#define TGUI_CURSOR_BLINK_TIME 0.5
+#define TGUI_TEXTVIEW_INDEX_POLL_TIME (1.0/30.0)
+
+// NOTE: damage tracking, with it enable the rasterizer own the backbuffer: it is not clear every frame
+// and only the rects where the commands change are draw again. Every command is match with the command
+// of the same widget and index of the last frame. When a scroll container only change its scroll the
+// pixels inside its clip are moved and only the new strip is draw
+#define TGUI_DAMAGE_RECTS_MAX 16
+#define TGUI_DAMAGE_SCOPES_MAX 32
+
+typedef struct TGuiDamageCommand
+{
+    TGuiHandle handle;
+    // NOTE: scroll container of the command, 0 if it is not inside one
+    TGuiHandle scope;
+    u64 hash;
+    // NOTE: hash with the positions relative to the scroll origin of the scope
+    u64 content_hash;
+    // NOTE: index of the command between the commands of its widget
+    u32 index;
+    TGuiDamageRect bounds;
+    b32 solid;
+} TGuiDamageCommand;
+
+typedef struct TGuiDamageWidget
+{
+    // NOTE: index of its commands in TGuiDamageFrame sorted and widget drawn before it
+    u32 first;
+    u32 count;
+    TGuiHandle prev;
+    b32 drawn;
+    // NOTE: only for scroll containers
+    b32 scroll;
+    TGuiHandle scope;
+    i32 origin_x;
+    i32 origin_y;
+    TGuiDamageRect clip;
+    // NOTE: index of its START_CLIPPING and if its pixels were moved this frame
+    u32 begin;
+    b32 blit;
+} TGuiDamageWidget;
+
+typedef struct TGuiDamageFrame
+{
+    TGuiDamageCommand commands[TGUI_DRAW_COMMANDS_MAX];
+    // NOTE: command indices sorted by widget
+    u32 sorted[TGUI_DRAW_COMMANDS_MAX];
+    u32 command_count;
+    // NOTE: index by widget handle
+    TGuiDamageWidget *widgets;
+    u32 widgets_size;
+    u32 widgets_count;
+} TGuiDamageFrame;
+
+typedef struct TGuiDamage
+{
+    b32 enabled;
+    b32 valid;
+    TGuiBitmap *backbuffer;
+    u32 backbuffer_width;
+    u32 backbuffer_height;
+    TGuiDamageFrame *current;
+    TGuiDamageFrame *last;
+    // NOTE: rects that are draw again and rects that change on the screen (draw and moved)
+    TGuiDamageRect dirty[TGUI_DAMAGE_RECTS_MAX];
+    u32 dirty_count;
+    TGuiDamageRect present[TGUI_DAMAGE_RECTS_MAX];
+    u32 present_count;
+} TGuiDamage;
+
+// NOTE: optional pass over the commands of tgui_update (before the occlusion culling). It remove the commands
+// that are outside its clip, merge consecutive rects that form a rect, remove the clipping that dont change
+// the clip and join consecutive text runs of the same line in one TEXT command. The order is never change
+typedef struct TGuiOptimizerStats
+{
+    u32 input;
+    u32 output;
+    u32 culled;
+    u32 merged_rects;
+    u32 collapsed_clips;
+    u32 merged_texts;
+} TGuiOptimizerStats;
+
+typedef struct TGuiOptimizerScope
+{
+    TGuiDamageRect clip;
+    // NOTE: if its START_CLIPPING is in the buffer and its index
+    b32 kept;
+    u32 output_index;
+    b32 layer;
+    // NOTE: the commands inside a scroll container are not culled with damage, the scroll need all of them
+    b32 keep_commands;
+} TGuiOptimizerScope;
+
+typedef struct TGuiOptimizer
+{
+    b32 enabled;
+    TGuiOptimizerStats stats;
+} TGuiOptimizer;
+
+// NOTE: bitmaps of the TGUI_CONTAINER_CACHED containers, own by the rasterizer. A layer that is not in
+// the frame that is draw is release
+typedef struct TGuiLayer
+{
+    TGuiHandle handle;
+    TGuiBitmap bitmap;
+    // NOTE: hash of the commands that are in the bitmap
+    u64 hash;
+    b32 used;
+} TGuiLayer;
+
+typedef struct TGuiLayerCache
+{
+    TGuiLayer *layers;
+    u32 count;
+    u32 size;
+} TGuiLayerCache;
+
+// NOTE: pipelined frames, tgui_submit_frame give the commands of the frame to the render thread and the
+// next tgui_update run while it is draw and present. The fence of a frame is done after its present
+typedef u64 TGuiFence;
+typedef void (*TGuiPresentFP)(TGuiRect *rects, u32 rect_count, void *data);
+typedef struct TGuiPipeline
+{
+    TGuiThread thread;
+    TGuiSync sync;
+    TGuiPresentFP present;
+    void *data;
+    // NOTE: the render thread own the frame from its submit to its release
+    TGuiDrawCommandBuffer *frame;
+    TGuiFence submitted;
+    TGuiFence released;
+    b32 stop;
+} TGuiPipeline;
+
+// NOTE: worker threads for the work of the frame that can be split in jobs. The thread that run the jobs
+// also take them and wait until all are done. tgui_update lay out every root in a job, the roots dont
+// share any widget so the jobs dont write the same memory
+typedef void (*TGuiJobFP)(void *data, u32 index);
+typedef struct TGuiJobs
+{
+    TGuiThread *threads;
+    u32 thread_count;
+    TGuiSync sync;
+    TGuiJobFP function;
+    void *data;
+    u32 job_count;
+    // NOTE: the generation is in the high 32 bits and the next job in the low ones, a worker that is late
+    // cant take a job of other generation with the function and the job_count of its own
+    u64 next_job;
+    // NOTE: the workers take the jobs of a new generation, busy is how many are still in it
+    u32 generation;
+    u32 busy;
+    b32 stop;
+    TGuiHandle *roots;
+    u32 root_count;
+    u32 root_size;
+    // NOTE: the roots are lay out before the update of the frame, the update only do it again if a scroll change
+    b32 layout_done;
+} TGuiJobs;
+
+// NOTE: geometry output for renderers that draw triangles, the commands are converted to vertices and indices
+// and the triangles are group in draw calls by texture and clip. The rects and the text use the atlas of the
+// geometry (the font with a white row) so they go in the same draw call. The color of a pixel is the texel
+// multiply by the vertex color, the texels with alpha <= 128 are discard (same as the rasterizer)
+typedef struct TGuiVertex
+{
+    // NOTE: position in pixels and uv from 0 to 1
+    f32 x;
+    f32 y;
+    f32 u;
+    f32 v;
+    u32 color;
+} TGuiVertex;
+
+typedef struct TGuiDrawCall
+{
+    TGuiBitmap *texture;
+    // NOTE: scissor rect, only the calls with triangles that cross its clip have a smaller one than the backbuffer
+    TGuiRect clip;
+    u32 first_index;
+    u32 index_count;
+} TGuiDrawCall;
+
+typedef struct TGuiGeometry
+{
+    TGuiBitmap atlas;
+    TGuiVertex *vertices;
+    u32 vertex_count;
+    u32 vertex_size;
+    u32 *indices;
+    u32 index_count;
+    u32 index_size;
+    TGuiDrawCall *calls;
+    u32 call_count;
+    u32 call_size;
+} TGuiGeometry;
+
 typedef struct TGuiState
 {
     TGuiBitmap *backbuffer;
@@ -376,11 +1279,64 @@ typedef struct TGuiState
     TGuiHandle last_root;
 
     TGuiHandle widget_active;
+    // NOTE: widget that is been render, the draw commands are tagged with it
+    TGuiHandle render_handle;
+
+    // NOTE: labels restored from a snapshot are store here
+    TGuiArena snapshot_strings;
+
+    // NOTE: time of the frame, if fixed_time is not 0 it is used instead of the clock (tgui_replay)
+    f64 time;
+    f64 fixed_time;
+    // NOTE: earliest time a widget needs a new frame and hash of the commands of the last frame
+    // that changed, the host commands are include
+    f64 deadline;
+    u64 frame_hash;
+
+    TGuiRecorder recorder;
+    TGuiProfile profile;
+    TGuiTimeline timeline;
+    TGuiDebugCost debug_cost;
+    TGuiDamage damage;
+    TGuiOptimizer optimizer;
+    TGuiLayerCache layers;
+    TGuiPipeline pipeline;
+    TGuiJobs jobs;
+    TGuiWidgetRegistry registry;
+    // NOTE: change every time a widget move, change its size or the tree change
+    u32 layout_version;
+    TGuiHitBatch hit_batch;
 } TGuiState;
 // TODO: Maybe the state should be provided by the application?
 // NOTE: global state (stores all internal state of the GUI)
 extern TGuiState tgui_global_state;
 
+// NOTE: TGUI_PROFILE_END add the time to the frame stats and a span to the timeline (if it is open),
+// TGUI_PROFILE_ACCUMULATE only add the time. TGUI_SPAN_BEGIN/END only add a span and dont
+// read the clock if the timeline is close. The TGUI_RASTER_ versions are for the code that only run
+// in the rasterizer (draw kernels, layers, damage and present of the render thread)
+#if defined(TGUI_PROFILE)
+#define TGUI_PROFILE_BEGIN(name) f64 tgui_profile_start_##name = tgui_platform_get_time()
+#define TGUI_PROFILE_END(name, stat) tgui_profile_end(#name, &tgui_global_state.profile.current.stat, tgui_profile_start_##name)
+#define TGUI_PROFILE_ACCUMULATE(name, stat) (tgui_global_state.profile.current.stat += (tgui_platform_get_time() - tgui_profile_start_##name)*1000.0)
+#define TGUI_PROFILE_COUNT(counter, value) (tgui_global_state.profile.current.counters[(counter)] += (value))
+#define TGUI_RASTER_END(name, stat) tgui_raster_profile_end(#name, &tgui_global_state.profile.raster.stat, tgui_profile_start_##name)
+#define TGUI_RASTER_ACCUMULATE(name, stat) (tgui_global_state.profile.raster.stat += (tgui_platform_get_time() - tgui_profile_start_##name)*1000.0)
+#define TGUI_RASTER_COUNT(counter, value) (tgui_global_state.profile.raster.counters[(counter)] += (value))
+#define TGUI_SPAN_BEGIN(name) f64 tgui_span_start_##name = tgui_global_state.timeline.file ? tgui_platform_get_time() : 0
+#define TGUI_SPAN_END(name, handle, commands) (tgui_span_start_##name > 0 ? tgui_timeline_push(#name, tgui_span_start_##name, (handle), (commands)) : (void)0)
+#else
+#define TGUI_PROFILE_BEGIN(name)
+#define TGUI_PROFILE_END(name, stat) ((void)0)
+#define TGUI_PROFILE_ACCUMULATE(name, stat) ((void)0)
+#define TGUI_PROFILE_COUNT(counter, value) ((void)0)
+#define TGUI_RASTER_END(name, stat) ((void)0)
+#define TGUI_RASTER_ACCUMULATE(name, stat) ((void)0)
+#define TGUI_RASTER_COUNT(counter, value) ((void)0)
+#define TGUI_SPAN_BEGIN(name)
+#define TGUI_SPAN_END(name, handle, commands) ((void)0)
+#endif
+
 //-----------------------------------------------------
 // NOTE: GUI lib functions
 //-----------------------------------------------------
@@ -390,9 +1346,60 @@ TGUI_API TGuiHandle tgui_create_container(i32 x, i32 y, i32 width, i32 height, T
 TGUI_API TGuiHandle tgui_create_button(char *label);
 TGUI_API TGuiHandle tgui_create_checkbox(char *label);
 TGUI_API TGuiHandle tgui_create_slider(void);
+TGUI_API TGuiHandle tgui_create_textbox(u32 width, u32 height);
+TGUI_API TGuiHandle tgui_create_textview(char *path, u32 width, u32 height);
+TGUI_API TGuiHandle tgui_create_plot(u32 width, u32 height);
+TGUI_API TGuiHandle tgui_create_grid(u32 width, u32 height);
+TGUI_API TGuiHandle tgui_create_tree(u32 width, u32 height);
 TGUI_API void tgui_container_add_widget(TGuiHandle container_handle, TGuiHandle widget_handle);
 TGUI_API void tgui_widget_to_root(TGuiHandle widget_handle);
 TGUI_API void tgui_set_widget_position(TGuiHandle widget_handle, f32 x, f32 y);
+// NOTE: widget types of the application, the class is copy and the type return is TGUI_COUNT or more.
+// The data of a custom widget is own by the application, the snapshots can not restore custom widgets
+TGUI_API TGuiWidgetType tgui_register_widget_type(TGuiWidgetClass *widget_class);
+TGUI_API TGuiHandle tgui_create_custom(TGuiWidgetType type, void *data);
+TGUI_API void *tgui_widget_get_custom_data(TGuiHandle handle);
+// NOTE: the handles of the widgets of one type in the tree of the roots (in update order), so a type can be
+// process in a batch. Return the total count, only max_count are write
+TGUI_API u32 tgui_widget_gather(TGuiWidgetType type, TGuiHandle *handles, u32 max_count);
+
+// NOTE: bulk text functions, offsets are in bytes from the start of the text
+TGUI_API void tgui_textbox_set_text(TGuiHandle textbox_handle, char *text, u32 text_size);
+TGUI_API void tgui_textbox_insert(TGuiHandle textbox_handle, u32 offset, char *text, u32 text_size);
+TGUI_API void tgui_textbox_append(TGuiHandle textbox_handle, char *text, u32 text_size);
+TGUI_API void tgui_textbox_replace_range(TGuiHandle textbox_handle, u32 start, u32 end, char *text, u32 text_size);
+TGUI_API u32 tgui_textbox_get_size(TGuiHandle textbox_handle);
+
+TGUI_API void tgui_textview_scroll_to_line(TGuiHandle textview_handle, u64 line);
+TGUI_API u64 tgui_textview_get_line_count(TGuiHandle textview_handle);
+TGUI_API b32 tgui_textview_is_indexed(TGuiHandle textview_handle);
+
+// NOTE: the samples are own by the application, sample_count samples are already write in the ring.
+// After write new samples call tgui_plot_append with how many, only the new columns are calculate
+TGUI_API void tgui_plot_bind(TGuiHandle plot_handle, f32 *samples, u64 capacity, u64 sample_count);
+TGUI_API void tgui_plot_append(TGuiHandle plot_handle, u64 count);
+TGUI_API void tgui_plot_set_view(TGuiHandle plot_handle, u64 view_count);
+TGUI_API void tgui_plot_set_range(TGuiHandle plot_handle, f32 min_value, f32 max_value);
+
+// NOTE: the columns are copy, the names and the data are own by the application. Only the visible cells are
+// format, the header row show the names of the columns. The fixed rows and columns dont scroll
+#define TGUI_GRID_ALL_COLUMNS 0xFFFFFFFF
+TGUI_API void tgui_grid_set_columns(TGuiHandle grid_handle, TGuiGridColumn *columns, u32 column_count);
+TGUI_API void tgui_grid_set_row_count(TGuiHandle grid_handle, u64 row_count);
+TGUI_API void tgui_grid_set_fixed(TGuiHandle grid_handle, u32 fixed_rows, u32 fixed_columns);
+TGUI_API void tgui_grid_set_size(TGuiHandle grid_handle, u32 width, u32 height);
+TGUI_API void tgui_grid_scroll_to(TGuiHandle grid_handle, u64 row, u32 column);
+// NOTE: the data of the column change (TGUI_GRID_ALL_COLUMNS for all), its cells are format again
+TGUI_API void tgui_grid_invalidate(TGuiHandle grid_handle, u32 column);
+
+// NOTE: the source is copy, the root is not show and its children are the first rows. Click a row to expand
+// or collapse it, only the expanded nodes take memory
+TGUI_API void tgui_tree_bind(TGuiHandle tree_handle, TGuiTreeSource *source, u32 node_count, u32 root);
+TGUI_API void tgui_tree_toggle_row(TGuiHandle tree_handle, u32 row);
+TGUI_API void tgui_tree_scroll_to(TGuiHandle tree_handle, u32 row);
+TGUI_API u32 tgui_tree_get_row_count(TGuiHandle tree_handle);
+// NOTE: TGUI_TREE_NONE if the row is not in the tree
+TGUI_API u32 tgui_tree_get_row_node(TGuiHandle tree_handle, u32 row);
 
 b32 tgui_widget_update(TGuiHandle handle);
 b32 tgui_widget_render(TGuiHandle handle);
@@ -402,16 +1409,104 @@ b32 tgui_widget_recursive_descent_pre_last_to_first(TGuiHandle handle, TGuiWidge
 b32 tgui_widget_recursive_descent_pos_last_to_first(TGuiHandle handle, TGuiWidgetFP function);
 TGuiV2 tgui_widget_abs_pos(TGuiHandle handle);
 
+//-----------------------------------------------------
+// NOTE: snapshot functions
+//-----------------------------------------------------
+// NOTE: the snapshot is only valid for the same build of the library, the widget
+// structs are store as they are in memory and the restore check the version and the size
+#define TGUI_SNAPSHOT_MAGIC 0x53534754 // NOTE: "TGSS"
+#define TGUI_SNAPSHOT_VERSION 3
+typedef struct TGuiSnapshotHeader
+{
+    u32 magic;
+    u32 version;
+    u32 widget_size;
+    u32 widget_count;
+    u32 free_count;
+    TGuiHandle first_root;
+    TGuiHandle last_root;
+    TGuiHandle widget_active;
+    u64 data_size;
+} TGuiSnapshotHeader;
+
+typedef struct TGuiSnapshot
+{
+    u8 *data;
+    u64 size;
+} TGuiSnapshot;
+
+// NOTE: return an empty snapshot (data 0) if a widget of the application has no save and restore
+TGUI_API TGuiSnapshot tgui_snapshot_save(void);
+TGUI_API void tgui_snapshot_free(TGuiSnapshot *snapshot);
+TGUI_API b32 tgui_snapshot_restore(TGuiSnapshot snapshot);
+
+// NOTE: record every frame until tgui_record_end, replay it with tgui_replay
+TGUI_API b32 tgui_record_begin(char *path);
+TGUI_API void tgui_record_end(void);
+
 //-----------------------------------------------------
 // NOTE: core lib functions
 //-----------------------------------------------------
 TGUI_API void tgui_init(TGuiBitmap *backbuffer, TGuiFont *font);
 TGUI_API void tgui_terminate(void);
-TGUI_API void tgui_update(void);
+TGUI_API TGuiUpdateResult tgui_update(void);
 TGUI_API void tgui_draw_command_buffer(void);
+TGUI_API b32 tgui_frame_changed(void);
 TGUI_API void tgui_push_event(TGuiEvent event);
 TGUI_API void tgui_push_draw_command(TGuiDrawCommand draw_cmd);
 TGUI_API b32 tgui_pull_draw_command(TGuiDrawCommand *draw_cmd);
+// NOTE: stats of the last complete frame (update, raster and present), all zero without TGUI_PROFILE
+TGUI_API TGuiFrameStats tgui_get_frame_stats(void);
+// NOTE: push the draw commands of the stats overlay, call it after tgui_update
+TGUI_API void tgui_draw_frame_stats(i32 x, i32 y);
+// NOTE: write a timeline of every frame to a chrome trace json, only with TGUI_PROFILE
+TGUI_API b32 tgui_timeline_begin(char *path);
+TGUI_API void tgui_timeline_end(void);
+
+// NOTE: the costs are of the last frame that is draw (with the pipeline wait its fence)
+TGUI_API void tgui_debug_cost_enable(b32 enable);
+TGUI_API u32 tgui_debug_cost_top(TGuiWidgetCost *costs, u32 max_count, TGuiCostSort sort);
+// NOTE: the write count of every pixel as colors (0 is transparent, then blue, green, yellow and red for 5 or more)
+TGUI_API TGuiBitmap *tgui_debug_overdraw_bitmap(void);
+// NOTE: blend the overdraw colors over the backbuffer
+TGUI_API void tgui_debug_draw_overdraw(TGuiBitmap *backbuffer);
+// NOTE: with damage enable the application must not clear the backbuffer and must draw with draw commands
+TGUI_API void tgui_damage_enable(b32 enable);
+// NOTE: rects of the backbuffer that change in the last tgui_draw_command_buffer, the application only need
+// to present them. If there are more than max_count the rest are merge in the last one
+TGUI_API u32 tgui_get_dirty_rects(TGuiRect *rects, u32 max_count);
+// NOTE: the optimizer only change the commands of tgui_update, not the ones that the application push after it
+TGUI_API void tgui_optimizer_enable(b32 enable);
+// NOTE: how many commands the optimizer remove in the last tgui_update
+TGUI_API TGuiOptimizerStats tgui_get_optimizer_stats(void);
+// NOTE: hit test the buttons and checkboxes in a batch, the result of the update is the same
+TGUI_API void tgui_hit_batch_enable(b32 enable);
+// NOTE: the buttons that are pressed and the checkboxes that change in the last tgui_update, return the total
+// count and only write max_count handles
+TGUI_API u32 tgui_get_pressed(TGuiHandle *handles, u32 max_count);
+// NOTE: start the render thread, present is call from it with the rects of the backbuffer that change.
+// The damage, the debug cost and the backbuffer are own by the render thread until tgui_pipeline_end
+TGUI_API b32 tgui_pipeline_begin(TGuiPresentFP present, void *data);
+TGUI_API void tgui_pipeline_end(void);
+// NOTE: call it after tgui_update and the draw commands of the application, it wait until the last
+// frame is draw (the render thread only has one frame) and return the fence of the new one
+TGUI_API TGuiFence tgui_submit_frame(void);
+TGUI_API b32 tgui_fence_done(TGuiFence fence);
+TGUI_API void tgui_fence_wait(TGuiFence fence);
+// NOTE: start the worker threads, tgui_update lay out the roots in parallel. The update of the input
+// (hot, active and the events) is still serial so the frames are the same as without workers
+TGUI_API b32 tgui_jobs_begin(u32 thread_count);
+TGUI_API void tgui_jobs_end(void);
+// NOTE: the atlas is create from the font of tgui_init
+TGUI_API void tgui_geometry_create(TGuiGeometry *geometry);
+TGUI_API void tgui_geometry_destroy(TGuiGeometry *geometry);
+// NOTE: convert the commands that are not pull yet (like tgui_draw_command_buffer, it consume them)
+TGUI_API void tgui_geometry_build(TGuiGeometry *geometry);
+// NOTE: reference rasterizer of the triangles, to test the geometry without a gpu
+TGUI_API void tgui_geometry_raster(TGuiGeometry *geometry, TGuiBitmap *target);
+void tgui_timeline_push(char *name, f64 start, TGuiHandle handle, u32 commands);
+void tgui_profile_end(char *name, f64 *stat, f64 start);
+void tgui_raster_profile_end(char *name, f64 *stat, f64 start);
 
 //-----------------------------------------------------
 //  NOTE: memory management functions
@@ -423,6 +1518,17 @@ void tgui_widget_allocator_free(TGuiWidgetPoolAllocator *allocator, TGuiHandle *
 void tgui_widget_set(TGuiHandle handle, TGuiWidget widget);
 TGuiWidget *tgui_widget_get(TGuiHandle handle);
 
+void tgui_arena_create(TGuiArena *arena);
+void tgui_arena_destroy(TGuiArena *arena);
+void *tgui_arena_push(TGuiArena *arena, u64 size);
+void *tgui_arena_push_copy(TGuiArena *arena, void *data, u64 size);
+void tgui_arena_clear(TGuiArena *arena);
+
+void tgui_draw_command_buffer_create(TGuiDrawCommandBuffer *buffer);
+void tgui_draw_command_buffer_destroy(TGuiDrawCommandBuffer *buffer);
+void tgui_draw_command_buffer_clear(TGuiDrawCommandBuffer *buffer);
+u64 tgui_draw_command_buffer_hash(TGuiDrawCommandBuffer *buffer);
+
 TGUI_API TGuiRect tgui_rect_xywh(f32 x, f32 y, f32 width, f32 height);
 TGUI_API b32 tgui_point_inside_rect(TGuiV2 point, TGuiRect rect);
 
@@ -430,6 +1536,34 @@ TGUI_API b32 tgui_point_inside_rect(TGuiV2 point, TGuiRect rect);
 // NOTE: platform functions
 //-----------------------------------------------------
 TGUI_API TGuiKeyCode tgui_win32_translate_keycode(u32 keycode);
+TGUI_API b32 tgui_platform_map_file(TGuiMappedFile *file, char *path);
+TGUI_API void tgui_platform_unmap_file(TGuiMappedFile *file);
+TGUI_API void tgui_platform_release_pages(void *memory, u64 size);
+TGuiThread tgui_platform_thread_create(TGuiThreadFP function, void *data);
+void tgui_platform_thread_join(TGuiThread thread);
+TGuiSync tgui_platform_sync_create(void);
+void tgui_platform_sync_destroy(TGuiSync sync);
+void tgui_platform_sync_lock(TGuiSync sync);
+void tgui_platform_sync_unlock(TGuiSync sync);
+// NOTE: must be lock, unlock it and sleep until other thread call tgui_platform_sync_wake
+void tgui_platform_sync_wait(TGuiSync sync);
+void tgui_platform_sync_wake(TGuiSync sync);
+u32 tgui_platform_cpu_count(void);
+// NOTE: monotonic time in seconds
+TGUI_API f64 tgui_platform_get_time(void);
+u32 tgui_platform_thread_id(void);
+
+//-----------------------------------------------------
+// NOTE: image functions
+//-----------------------------------------------------
+TGUI_API b32 tgui_load_bmp(TGuiImage *image, char *path);
+TGUI_API void tgui_free_bmp(TGuiImage *image);
+
+TGUI_API b32 tgui_asset_pack_open(TGuiAssetPack *pack, char *path);
+TGUI_API void tgui_asset_pack_close(TGuiAssetPack *pack);
+TGUI_API b32 tgui_asset_pack_get_bitmap(TGuiAssetPack *pack, char *name, TGuiBitmap *bitmap);
+TGUI_API b32 tgui_asset_pack_get_font(TGuiAssetPack *pack, char *name, u32 height, TGuiFont *font);
+TGUI_API u32 tgui_asset_name_hash(char *name, u32 height);
 
 //-----------------------------------------------------
 // NOTE: DEBUG function
@@ -460,8 +1594,11 @@ extern TGuiClippingStack global_clipping_stack;
 TGUI_API void tgui_clear_backbuffer(TGuiBitmap *backbuffer);
 TGUI_API void tgui_draw_circle_aa(TGuiBitmap *backbuffer, i32 x, i32 y, u32 color, u32 radius);
 TGUI_API void tgui_draw_rect(TGuiBitmap *backbuffer, i32 min_x, i32 min_y, i32 max_x, i32 max_y, u32 color);
+TGUI_API void tgui_draw_spans(TGuiBitmap *backbuffer, i32 x, i32 y, i32 height, TGuiSpan *spans, u32 span_count, u32 color);
 TGUI_API void tgui_draw_rounded_rect(TGuiBitmap *backbuffer, i32 min_x, i32 min_y, i32 max_x, i32 max_y, u32 color, u32 radius);
 TGUI_API void tgui_copy_bitmap(TGuiBitmap *backbuffer, TGuiBitmap *bitmap, i32 x, i32 y);
+// NOTE: same as tgui_copy_bitmap but the pixels with alpha 0 are not copy
+TGUI_API void tgui_copy_bitmap_alpha(TGuiBitmap *backbuffer, TGuiBitmap *bitmap, i32 x, i32 y);
 TGUI_API void tgui_draw_bitmap(TGuiBitmap *backbuffer, TGuiBitmap *bitmap, i32 x, i32 y, i32 width, i32 height);
 TGUI_API void tgui_draw_src_dest_bitmap(TGuiBitmap *backbuffer, TGuiBitmap *bitmap, TGuiRect src, TGuiRect dest);
 // NOTE: font funtions
@@ -0,0 +1,287 @@
+#include "tgui.h"
+#include "tgui.c"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <stdio.h>
+
+// NOTE: reference loop for linux, the thread sleep in poll until X send an event, other thread
+// write to the eventfd (linux_wake) or the deadline that tgui_update return pass. The frame is
+// only submit if tgui_update say that it change, the render thread of tgui draw and present it
+// while this thread update the next one
+
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 600
+static b32 global_running = false;
+static i32 global_wake_fd = -1;
+
+typedef struct LinuxPresent
+{
+    Display *display;
+    Window window;
+    GC gc;
+    XImage *image;
+} LinuxPresent;
+
+// NOTE: call from the render thread of tgui with the rects that change (the display is open with XInitThreads)
+static void linux_present(TGuiRect *rects, u32 rect_count, void *data)
+{
+    LinuxPresent *present = (LinuxPresent *)data;
+    for(u32 rect_index = 0; rect_index < rect_count; ++rect_index)
+    {
+        TGuiRect rect = rects[rect_index];
+        XPutImage(present->display, present->window, present->gc, present->image, rect.x, rect.y, rect.x, rect.y, rect.width, rect.height);
+    }
+    XFlush(present->display);
+}
+
+// NOTE: can be call from any thread to force a new frame
+static void linux_wake(void)
+{
+    u64 value = 1;
+    ssize_t result = write(global_wake_fd, &value, sizeof(u64));
+    UNUSED_VAR(result);
+}
+
+static TGuiKeyCode linux_translate_keycode(KeySym keysym)
+{
+    switch(keysym)
+    {
+        case XK_Left: return TGUI_KEYCODE_LEFT;
+        case XK_Up: return TGUI_KEYCODE_UP;
+        case XK_Right: return TGUI_KEYCODE_RIGHT;
+        case XK_Down: return TGUI_KEYCODE_DOWN;
+        case XK_BackSpace: return TGUI_KEYCODE_BACKSPACE;
+        case XK_Return: return TGUI_KEYCODE_ENTER;
+        default: return TGUI_KEYCODE_NONE;
+    }
+}
+
+// NOTE: return true if the window need to be present again
+static b32 linux_process_event(XEvent *event, Atom wm_delete_window)
+{
+    switch(event->type)
+    {
+        case ClientMessage:
+        {
+            if((Atom)event->xclient.data.l[0] == wm_delete_window) global_running = false;
+        } break;
+        case Expose:
+        {
+            return event->xexpose.count == 0;
+        } break;
+        case KeyPress:
+        case KeyRelease:
+        {
+            char text[8];
+            KeySym keysym = 0;
+            i32 text_size = XLookupString(&event->xkey, text, sizeof(text), &keysym, 0);
+            TGuiEventKey key_event = {0};
+            key_event.type = event->type == KeyPress ? TGUI_EVENT_KEYDOWN : TGUI_EVENT_KEYUP;
+            key_event.keycode = linux_translate_keycode(keysym);
+            tgui_push_event((TGuiEvent)key_event);
+            if(event->type == KeyPress && text_size == 1)
+            {
+                TGuiEvent char_event = {0};
+                char_event.type = TGUI_EVENT_CHAR;
+                char_event.character.character = (u8)text[0];
+                tgui_push_event(char_event);
+            }
+        } break;
+        case MotionNotify:
+        {
+            TGuiEventMouseMove mouse_event = {0};
+            mouse_event.type = TGUI_EVENT_MOUSEMOVE;
+            mouse_event.pos_x = event->xmotion.x;
+            mouse_event.pos_y = event->xmotion.y;
+            tgui_push_event((TGuiEvent)mouse_event);
+        } break;
+        case ButtonPress:
+        case ButtonRelease:
+        {
+            if(event->xbutton.button == Button1)
+            {
+                TGuiEvent mouse_event = {0};
+                mouse_event.type = event->type == ButtonPress ? TGUI_EVENT_MOUSEDOWN : TGUI_EVENT_MOUSEUP;
+                tgui_push_event(mouse_event);
+            }
+        } break;
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    // NOTE: same arguments as tgui_win32.c, and tgui -textview file.txt open a file in a textview
+    char *record_path = 0;
+    char *timeline_path = 0;
+    char *textview_path = 0;
+    for(i32 arg = 1; arg + 1 < argc; arg += 2)
+    {
+        if(strcmp(argv[arg], "-record") == 0) record_path = argv[arg + 1];
+        if(strcmp(argv[arg], "-timeline") == 0) timeline_path = argv[arg + 1];
+        if(strcmp(argv[arg], "-textview") == 0) textview_path = argv[arg + 1];
+    }
+
+    XInitThreads();
+    Display *display = XOpenDisplay(0);
+    if(!display)
+    {
+        printf("[ERROR]: cannot open the X display\n");
+        return -1;
+    }
+    i32 screen = DefaultScreen(display);
+    if(DefaultDepth(display, screen) < 24)
+    {
+        printf("[ERROR]: the X display need a 24 or 32 bits visual\n");
+        return -1;
+    }
+    Window window = XCreateSimpleWindow(display, RootWindow(display, screen), 100, 100, WINDOW_WIDTH, WINDOW_HEIGHT,
+                                        0, BlackPixel(display, screen), BlackPixel(display, screen));
+    XStoreName(display, window, "tgui");
+    XSelectInput(display, window, ExposureMask|KeyPressMask|KeyReleaseMask|PointerMotionMask|ButtonPressMask|ButtonReleaseMask);
+    Atom wm_delete_window = XInternAtom(display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(display, window, &wm_delete_window, 1);
+    XMapWindow(display, window);
+    GC gc = DefaultGC(display, screen);
+
+    global_wake_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if(global_wake_fd < 0)
+    {
+        printf("[ERROR]: cannot create the eventfd\n");
+        return -1;
+    }
+    global_running = true;
+
+    // NOTE: backbuffer for tgui to draw all the elements, the XImage use the same pixels
+    TGuiBitmap tgui_backbuffer = {0};
+    tgui_backbuffer.width = WINDOW_WIDTH;
+    tgui_backbuffer.height = WINDOW_HEIGHT;
+    tgui_backbuffer.pitch = tgui_backbuffer.width * sizeof(u32);
+    tgui_backbuffer.pixels = (u32 *)malloc(WINDOW_WIDTH*WINDOW_HEIGHT*sizeof(u32));
+    XImage *image = XCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen), ZPixmap, 0,
+                                 (char *)tgui_backbuffer.pixels, WINDOW_WIDTH, WINDOW_HEIGHT, 32, tgui_backbuffer.pitch);
+
+    // NOTE: load bitmap for testing
+    TGuiImage test_image = {0};
+    tgui_load_bmp(&test_image, "data/font.bmp");
+    TGuiBitmap test_bitmap = test_image.bitmap;
+    // NOTE: create a font for testing
+    TGuiFont test_font = tgui_create_font(&test_bitmap, 7, 9, 18, 6);
+
+    // NOTE: init TGUI lib
+    tgui_init(&tgui_backbuffer, &test_font);
+    tgui_damage_enable(true);
+    tgui_optimizer_enable(true);
+    tgui_hit_batch_enable(true);
+    LinuxPresent linux_present_data = {display, window, gc, image};
+    tgui_pipeline_begin(linux_present, &linux_present_data);
+    // NOTE: the roots are lay out in the other cores (the render thread and this one take one each)
+    u32 cpu_count = tgui_platform_cpu_count();
+    if(cpu_count > 2) tgui_jobs_begin(cpu_count - 2);
+
+    TGuiHandle frame1 = tgui_create_container(100, 100, 0, 0, TGUI_CONTAINER_DYNAMIC|TGUI_CONTAINER_DRAGGABLE|TGUI_CONTAINER_CACHED, TGUI_LAYOUT_VERTICAL, true, 10);
+    tgui_widget_to_root(frame1);
+    TGuiHandle button_box = tgui_create_container(0, 0, 0, 0, TGUI_CONTAINER_DYNAMIC, TGUI_LAYOUT_HORIZONTAL, false, 15);
+    tgui_container_add_widget(frame1, button_box);
+    tgui_container_add_widget(button_box, tgui_create_button("button 1"));
+    tgui_container_add_widget(button_box, tgui_create_button("button 2"));
+    tgui_container_add_widget(frame1, tgui_create_slider());
+    tgui_container_add_widget(frame1, tgui_create_checkbox("box 1"));
+    tgui_container_add_widget(frame1, tgui_create_textbox(200, 200));
+
+    if(textview_path)
+    {
+        TGuiHandle frame2 = tgui_create_container(400, 100, 0, 0, TGUI_CONTAINER_DYNAMIC|TGUI_CONTAINER_DRAGGABLE, TGUI_LAYOUT_VERTICAL, true, 10);
+        tgui_widget_to_root(frame2);
+        tgui_container_add_widget(frame2, tgui_create_textview(textview_path, 300, 300));
+    }
+
+    if(record_path && !tgui_record_begin(record_path))
+    {
+        printf("[ERROR]: cannot record to %s\n", record_path);
+    }
+    if(timeline_path && !tgui_timeline_begin(timeline_path))
+    {
+        printf("[ERROR]: cannot write the timeline to %s (build with TGUI_PROFILE)\n", timeline_path);
+    }
+
+    struct pollfd poll_fds[2];
+    poll_fds[0].fd = ConnectionNumber(display);
+    poll_fds[0].events = POLLIN;
+    poll_fds[1].fd = global_wake_fd;
+    poll_fds[1].events = POLLIN;
+
+    b32 present = false;
+    TGuiFence last_fence = 0;
+    while(global_running)
+    {
+        while(XPending(display))
+        {
+            XEvent event;
+            XNextEvent(display, &event);
+            if(linux_process_event(&event, wm_delete_window)) present = true;
+        }
+        u64 wake_count;
+        while(read(global_wake_fd, &wake_count, sizeof(u64)) > 0);
+
+        // NOTE: Update TGUI lib
+        TGuiUpdateResult result = tgui_update();
+
+        // NOTE: the backbuffer is not clear, only the dirty rects are draw again
+        char debug_str[256];
+        u32 font_height = 9;
+        sprintf(debug_str, "mouse pos (x:%d, y:%d)", tgui_global_state.mouse_x, tgui_global_state.mouse_y);
+        TGuiDrawCommand debug_text_command = {0};
+        debug_text_command.type = TGUI_DRAWCMD_TEXT;
+        debug_text_command.descriptor = tgui_rect_xywh(0, tgui_backbuffer.height - font_height, 0, font_height);
+        debug_text_command.text = debug_str;
+        debug_text_command.text_size = strlen(debug_str);
+        tgui_push_draw_command(debug_text_command);
+
+        // NOTE: frame time and profile counters (build with TGUI_PROFILE)
+        tgui_draw_frame_stats(0, 0);
+
+        // NOTE: submit only draw the frame if it change (the debug text too), only the rects that change
+        // are send to the X server by linux_present
+        last_fence = tgui_submit_frame();
+        if(present)
+        {
+            // NOTE: the render thread dont write the backbuffer after the fence of the last frame
+            tgui_fence_wait(last_fence);
+            TGUI_PROFILE_BEGIN(present);
+            XPutImage(display, window, gc, image, 0, 0, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+            XFlush(display);
+            TGUI_PROFILE_END(present, timers[TGUI_TIMER_PRESENT]);
+            present = false;
+        }
+
+        // NOTE: sleep until something happen, without deadline the wait has no timeout
+        i32 timeout_ms = -1;
+        if(result.deadline > 0)
+        {
+            f64 wait = result.deadline - tgui_platform_get_time();
+            timeout_ms = wait > 0 ? (i32)(wait*1000.0) + 1 : 0;
+        }
+        XFlush(display);
+        if(!XPending(display))
+        {
+            poll(poll_fds, 2, timeout_ms);
+        }
+    }
+
+    tgui_terminate();
+    tgui_free_bmp(&test_image);
+    // NOTE: the pixels are free by us, not by XDestroyImage
+    image->data = 0;
+    XDestroyImage(image);
+    free(tgui_backbuffer.pixels);
+    close(global_wake_fd);
+    XDestroyWindow(display, window);
+    XCloseDisplay(display);
+
+    return 0;
+}
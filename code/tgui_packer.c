@@ -0,0 +1,309 @@
+#include "tgui.h"
+#include "tgui.c"
+
+#include <stdio.h>
+
+// NOTE: offline tool to build an asset pack
+// usage: tgui_packer output.pack [-bitmap name path] [-font name path char_width char_height num_rows num_cols [heights]]
+// heights is a list of pixel heights separated by ',' (example 9,18) the font is pre scaled to that sizes
+
+#define TGUI_PACKER_MAX_BITMAPS 1024
+#define TGUI_PACKER_MAX_FONTS TGUI_ASSET_PACK_MAX_FONTS
+#define TGUI_PACKER_ATLAS_WIDTH 1024
+
+typedef struct TGuiPackerBitmap
+{
+    char *name;
+    TGuiImage image;
+    // NOTE: pre scaled fonts dont come from a file
+    u32 *scaled_pixels;
+    TGuiBitmap bitmap;
+    TGuiAssetPackBitmap rect;
+} TGuiPackerBitmap;
+
+typedef struct TGuiPackerFont
+{
+    char *name;
+    TGuiAssetPackFont font;
+} TGuiPackerFont;
+
+static TGuiPackerBitmap packer_bitmaps[TGUI_PACKER_MAX_BITMAPS];
+static u32 packer_bitmap_count;
+static TGuiPackerFont packer_fonts[TGUI_PACKER_MAX_FONTS];
+static u32 packer_font_count;
+
+static TGuiPackerBitmap *tgui_packer_push_bitmap(char *name)
+{
+    if(packer_bitmap_count >= TGUI_PACKER_MAX_BITMAPS)
+    {
+        printf("[ERROR]: too many bitmaps\n");
+        exit(1);
+    }
+    TGuiPackerBitmap *result = packer_bitmaps + packer_bitmap_count++;
+    memset(result, 0, sizeof(TGuiPackerBitmap));
+    result->name = name;
+    return result;
+}
+
+static TGuiPackerFont *tgui_packer_push_font(char *name)
+{
+    if(packer_font_count >= TGUI_PACKER_MAX_FONTS)
+    {
+        printf("[ERROR]: too many fonts\n");
+        exit(1);
+    }
+    TGuiPackerFont *result = packer_fonts + packer_font_count++;
+    memset(result, 0, sizeof(TGuiPackerFont));
+    result->name = name;
+    return result;
+}
+
+static TGuiPackerBitmap *tgui_packer_load_bitmap(char *name, char *path)
+{
+    TGuiPackerBitmap *bitmap = tgui_packer_push_bitmap(name);
+    if(!tgui_load_bmp(&bitmap->image, path))
+    {
+        printf("[ERROR]: cannot load bitmap %s\n", path);
+        exit(1);
+    }
+    bitmap->bitmap = bitmap->image.bitmap;
+    return bitmap;
+}
+
+static void tgui_packer_add_scaled_font(TGuiPackerFont *original, TGuiPackerBitmap *original_bitmap, u32 height)
+{
+    // NOTE: scale every glyph with the same sampler used at runtime, so the runtime can draw them 1:1
+    TGuiAssetPackFont *src = &original->font;
+    TGuiFont font = tgui_create_font(&original_bitmap->bitmap, src->char_width, src->char_height, src->num_rows, src->num_cols);
+    f32 w_ration = (f32)src->char_width / (f32)src->char_height;
+    u32 char_width = (u32)(w_ration * (f32)height + 0.5f);
+
+    TGuiPackerBitmap *bitmap = tgui_packer_push_bitmap(0);
+    bitmap->bitmap.width = char_width * src->num_rows;
+    bitmap->bitmap.height = height * src->num_cols;
+    bitmap->bitmap.pitch = bitmap->bitmap.width * sizeof(u32);
+    bitmap->scaled_pixels = (u32 *)calloc(bitmap->bitmap.width * bitmap->bitmap.height, sizeof(u32));
+    bitmap->bitmap.pixels = bitmap->scaled_pixels;
+
+    tgui_clipping_stack_push(&global_clipping_stack, tgui_rect_xywh(0, 0, bitmap->bitmap.width, bitmap->bitmap.height));
+    for(u32 index = 0; index < src->num_rows * src->num_cols; ++index)
+    {
+        i32 x = (index % src->num_rows) * char_width;
+        i32 y = (index / src->num_rows) * height;
+        tgui_draw_char(&bitmap->bitmap, &font, height, x, y, (char)(' ' + index));
+    }
+    tgui_clipping_stack_pop(&global_clipping_stack);
+
+    TGuiPackerFont *scaled = tgui_packer_push_font(original->name);
+    scaled->font = *src;
+    scaled->font.bitmap_index = (u32)(bitmap - packer_bitmaps);
+    scaled->font.char_width = char_width;
+    scaled->font.char_height = height;
+    scaled->font.height = height;
+}
+
+static u32 tgui_packer_build_atlas(void)
+{
+    // NOTE: simple shelf packing, the bitmaps are place from the tallest to the shortest
+    u32 order[TGUI_PACKER_MAX_BITMAPS];
+    for(u32 index = 0; index < packer_bitmap_count; ++index)
+    {
+        order[index] = index;
+    }
+    for(u32 i = 1; i < packer_bitmap_count; ++i)
+    {
+        u32 value = order[i];
+        u32 j = i;
+        while(j > 0 && packer_bitmaps[order[j - 1]].bitmap.height < packer_bitmaps[value].bitmap.height)
+        {
+            order[j] = order[j - 1];
+            --j;
+        }
+        order[j] = value;
+    }
+
+    u32 atlas_width = TGUI_PACKER_ATLAS_WIDTH;
+    for(u32 index = 0; index < packer_bitmap_count; ++index)
+    {
+        if(packer_bitmaps[index].bitmap.width > atlas_width) atlas_width = packer_bitmaps[index].bitmap.width;
+    }
+
+    u32 shelf_x = 0;
+    u32 shelf_y = 0;
+    u32 shelf_height = 0;
+    for(u32 index = 0; index < packer_bitmap_count; ++index)
+    {
+        TGuiPackerBitmap *bitmap = packer_bitmaps + order[index];
+        if(shelf_x + bitmap->bitmap.width > atlas_width)
+        {
+            shelf_y += shelf_height;
+            shelf_x = 0;
+            shelf_height = 0;
+        }
+        bitmap->rect.x = shelf_x;
+        bitmap->rect.y = shelf_y;
+        bitmap->rect.width = bitmap->bitmap.width;
+        bitmap->rect.height = bitmap->bitmap.height;
+        shelf_x += bitmap->bitmap.width;
+        if(bitmap->bitmap.height > shelf_height) shelf_height = bitmap->bitmap.height;
+    }
+    return atlas_width;
+}
+
+inline static u64 tgui_packer_align(u64 value, u64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        printf("usage: %s output.pack [-bitmap name path] [-font name path char_width char_height num_rows num_cols [heights]]\n", argv[0]);
+        return 1;
+    }
+
+    tgui_clipping_stack_create(&global_clipping_stack);
+
+    for(i32 arg = 2; arg < argc; ++arg)
+    {
+        if(strcmp(argv[arg], "-bitmap") == 0 && arg + 2 < argc)
+        {
+            tgui_packer_load_bitmap(argv[arg + 1], argv[arg + 2]);
+            arg += 2;
+        }
+        else if(strcmp(argv[arg], "-font") == 0 && arg + 6 < argc)
+        {
+            TGuiPackerBitmap *bitmap = tgui_packer_load_bitmap(0, argv[arg + 2]);
+            TGuiPackerFont *font = tgui_packer_push_font(argv[arg + 1]);
+            font->font.bitmap_index = (u32)(bitmap - packer_bitmaps);
+            font->font.char_width = (u32)atoi(argv[arg + 3]);
+            font->font.char_height = (u32)atoi(argv[arg + 4]);
+            font->font.num_rows = (u32)atoi(argv[arg + 5]);
+            font->font.num_cols = (u32)atoi(argv[arg + 6]);
+            arg += 6;
+            if(arg + 1 < argc && argv[arg + 1][0] != '-')
+            {
+                char *heights = argv[++arg];
+                while(*heights)
+                {
+                    u32 height = (u32)strtoul(heights, &heights, 10);
+                    if(height) tgui_packer_add_scaled_font(font, bitmap, height);
+                    if(*heights == ',') ++heights;
+                    else if(*heights) break;
+                }
+            }
+        }
+        else
+        {
+            printf("[ERROR]: invalid argument %s\n", argv[arg]);
+            return 1;
+        }
+    }
+
+    u32 atlas_width = tgui_packer_build_atlas();
+    u32 atlas_height = 0;
+    for(u32 index = 0; index < packer_bitmap_count; ++index)
+    {
+        TGuiAssetPackBitmap *rect = &packer_bitmaps[index].rect;
+        if(rect->y + rect->height > atlas_height) atlas_height = rect->y + rect->height;
+    }
+
+    // NOTE: name table with at least half of the slots empty
+    u32 name_count = 1;
+    u32 used_names = packer_font_count;
+    for(u32 index = 0; index < packer_bitmap_count; ++index)
+    {
+        if(packer_bitmaps[index].name) ++used_names;
+    }
+    while(name_count < used_names * 2) name_count *= 2;
+
+    TGuiAssetPackHeader header = {0};
+    header.magic = TGUI_ASSET_PACK_MAGIC;
+    header.version = TGUI_ASSET_PACK_VERSION;
+    header.bitmap_count = packer_bitmap_count;
+    header.font_count = packer_font_count;
+    header.name_count = name_count;
+    header.atlas_width = atlas_width;
+    header.atlas_height = atlas_height;
+    header.atlas_pitch = atlas_width * sizeof(u32);
+    header.bitmaps_offset = tgui_packer_align(sizeof(TGuiAssetPackHeader), 16);
+    header.fonts_offset = tgui_packer_align(header.bitmaps_offset + packer_bitmap_count*sizeof(TGuiAssetPackBitmap), 16);
+    header.names_offset = tgui_packer_align(header.fonts_offset + packer_font_count*sizeof(TGuiAssetPackFont), 16);
+    header.strings_offset = tgui_packer_align(header.names_offset + name_count*sizeof(TGuiAssetPackName), 16);
+
+    TGuiAssetPackName *names = (TGuiAssetPackName *)calloc(name_count, sizeof(TGuiAssetPackName));
+    u64 strings_size = 0;
+    for(u32 index = 0; index < packer_bitmap_count + packer_font_count; ++index)
+    {
+        b32 is_bitmap = index < packer_bitmap_count;
+        char *name = is_bitmap ? packer_bitmaps[index].name : packer_fonts[index - packer_bitmap_count].name;
+        if(!name) continue;
+        u32 height = is_bitmap ? 0 : packer_fonts[index - packer_bitmap_count].font.height;
+        u32 hash = tgui_asset_name_hash(name, height);
+        u32 slot = hash & (name_count - 1);
+        while(names[slot].type != TGUI_ASSET_NONE)
+        {
+            slot = (slot + 1) & (name_count - 1);
+        }
+        names[slot].hash = hash;
+        names[slot].type = is_bitmap ? TGUI_ASSET_BITMAP : TGUI_ASSET_FONT;
+        names[slot].index = is_bitmap ? index : index - packer_bitmap_count;
+        names[slot].string_offset = (u32)strings_size;
+        strings_size += strlen(name) + 1;
+    }
+
+    // NOTE: the atlas is aligned to a page so the rows can be use directly from the mapping
+    header.atlas_offset = tgui_packer_align(header.strings_offset + strings_size, 4096);
+    header.file_size = header.atlas_offset + (u64)header.atlas_pitch * atlas_height;
+
+    u8 *file_data = (u8 *)calloc(header.file_size, 1);
+    memcpy(file_data, &header, sizeof(TGuiAssetPackHeader));
+    TGuiAssetPackBitmap *pack_bitmaps = (TGuiAssetPackBitmap *)(file_data + header.bitmaps_offset);
+    for(u32 index = 0; index < packer_bitmap_count; ++index)
+    {
+        TGuiPackerBitmap *bitmap = packer_bitmaps + index;
+        pack_bitmaps[index] = bitmap->rect;
+        u8 *src_row = (u8 *)bitmap->bitmap.pixels;
+        u8 *dst_row = file_data + header.atlas_offset + (u64)bitmap->rect.y * header.atlas_pitch + bitmap->rect.x * sizeof(u32);
+        for(u32 y = 0; y < bitmap->rect.height; ++y)
+        {
+            memcpy(dst_row, src_row, bitmap->rect.width * sizeof(u32));
+            src_row += bitmap->bitmap.pitch;
+            dst_row += header.atlas_pitch;
+        }
+    }
+    TGuiAssetPackFont *pack_fonts = (TGuiAssetPackFont *)(file_data + header.fonts_offset);
+    for(u32 index = 0; index < packer_font_count; ++index)
+    {
+        pack_fonts[index] = packer_fonts[index].font;
+    }
+    memcpy(file_data + header.names_offset, names, name_count*sizeof(TGuiAssetPackName));
+    for(u32 index = 0; index < name_count; ++index)
+    {
+        if(names[index].type == TGUI_ASSET_NONE) continue;
+        char *name = names[index].type == TGUI_ASSET_BITMAP ? packer_bitmaps[names[index].index].name : packer_fonts[names[index].index].name;
+        memcpy(file_data + header.strings_offset + names[index].string_offset, name, strlen(name) + 1);
+    }
+
+    FILE *file = fopen(argv[1], "wb");
+    if(!file)
+    {
+        printf("[ERROR]: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    fwrite(file_data, header.file_size, 1, file);
+    fclose(file);
+
+    printf("[INFO]: %u bitmaps %u fonts, atlas %ux%u, %llu bytes\n", packer_bitmap_count, packer_font_count, atlas_width, atlas_height, (unsigned long long)header.file_size);
+
+    for(u32 index = 0; index < packer_bitmap_count; ++index)
+    {
+        tgui_free_bmp(&packer_bitmaps[index].image);
+        free(packer_bitmaps[index].scaled_pixels);
+    }
+    free(names);
+    free(file_data);
+    tgui_clipping_stack_destoy(&global_clipping_stack);
+    return 0;
+}
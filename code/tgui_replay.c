@@ -0,0 +1,289 @@
+#include "tgui.h"
+#include "tgui.c"
+
+#include <stdio.h>
+
+// NOTE: headless tool to play a trace recorded with tgui_record_begin at full speed
+// usage: tgui_replay trace.tgtr [font.bmp]
+// for every frame print the time of tgui_update, the time of the rasterizer and a hash of the backbuffer.
+// The commands created by tgui_update are compared with the recorded ones, the recorded commands
+// are the ones that are rasterized so the hash only change if the rasterizer change
+
+typedef struct TGuiReplayReader
+{
+    u8 *data;
+    u64 size;
+    u64 offset;
+} TGuiReplayReader;
+
+typedef struct TGuiReplayStats
+{
+    f64 total;
+    f64 max;
+} TGuiReplayStats;
+
+static TGuiBitmap replay_bitmaps[TGUI_TRACE_MAX_BITMAPS + 1];
+
+static b32 tgui_replay_read(TGuiReplayReader *reader, void *dst, u64 size)
+{
+    if(size > reader->size - reader->offset) return false;
+    if(dst) memcpy(dst, reader->data + reader->offset, size);
+    reader->offset += size;
+    return true;
+}
+
+static void tgui_replay_error(char *message)
+{
+    printf("[ERROR]: %s\n", message);
+    exit(1);
+}
+
+static u64 tgui_replay_hash_backbuffer(TGuiBitmap *backbuffer)
+{
+    // NOTE: FNV-1a
+    u64 hash = 0xCBF29CE484222325ull;
+    u8 *row = (u8 *)backbuffer->pixels;
+    for(u32 y = 0; y < backbuffer->height; ++y)
+    {
+        for(u32 x = 0; x < backbuffer->width*sizeof(u32); ++x)
+        {
+            hash ^= row[x];
+            hash *= 0x100000001B3ull;
+        }
+        row += backbuffer->pitch;
+    }
+    return hash;
+}
+
+static void tgui_replay_stats_add(TGuiReplayStats *stats, f64 ms)
+{
+    stats->total += ms;
+    if(ms > stats->max) stats->max = ms;
+}
+
+static b32 tgui_replay_command_equal(TGuiDrawCommand *a, TGuiDrawCommand *b)
+{
+    if(a->type != b->type) return false;
+    if(memcmp(&a->descriptor, &b->descriptor, sizeof(TGuiRect)) != 0) return false;
+    if(a->color != b->color || a->ratio != b->ratio || a->character != b->character) return false;
+    u32 a_text_size = a->text ? a->text_size : 0;
+    u32 b_text_size = b->text ? b->text_size : 0;
+    if(a_text_size != b_text_size) return false;
+    if(a_text_size && memcmp(a->text, b->text, a_text_size) != 0) return false;
+    return (a->bitmap != 0) == (b->bitmap != 0);
+}
+
+// NOTE: read the recorded commands and replace the ones in the buffer with them,
+// return if the commands created by the update are the same as the recorded
+static b32 tgui_replay_commands(TGuiReplayReader *reader, TGuiDrawCommandBuffer *buffer)
+{
+    u32 command_count = 0;
+    u32 host_count = 0;
+    if(!tgui_replay_read(reader, &command_count, sizeof(u32)) ||
+       !tgui_replay_read(reader, &host_count, sizeof(u32)))
+    {
+        tgui_replay_error("invalid commands chunk");
+    }
+    if(command_count > TGUI_DRAW_COMMANDS_MAX) tgui_replay_error("too many commands");
+    if(host_count > command_count) tgui_replay_error("invalid commands chunk");
+
+    // NOTE: the commands after the ones of the update are push by the host (debug text, stats), the
+    // replay dont push them so the update must create exactly the rest
+    u32 update_count = buffer->count;
+    b32 equal = update_count == command_count - host_count;
+    buffer->count = 0;
+    buffer->head = 0;
+    // NOTE: the occlusion of the update is for its commands, the recorded ones are draw without culling
+    TGuiOcclusion *occlusion = &buffer->occlusion;
+    occlusion->root_count = 0;
+    memset(occlusion->culled, 0, sizeof(occlusion->culled));
+    for(u32 command_index = 0; command_index < command_count; ++command_index)
+    {
+        TGuiTraceCommand command;
+        if(!tgui_replay_read(reader, &command, sizeof(TGuiTraceCommand)) ||
+           command.type >= TGUI_DRAWCMD_COUNT || command.bitmap_id > TGUI_TRACE_MAX_BITMAPS)
+        {
+            tgui_replay_error("invalid command");
+        }
+        TGuiDrawCommand draw_cmd = {0};
+        draw_cmd.type = (TGuiDrawCommandType)command.type;
+        draw_cmd.descriptor = command.descriptor;
+        draw_cmd.ratio = command.ratio;
+        draw_cmd.color = command.color;
+        draw_cmd.character = (u8)command.character;
+        draw_cmd.text_size = command.text_size;
+        draw_cmd.text = (char *)(reader->data + reader->offset);
+        if(!tgui_replay_read(reader, 0, command.text_size)) tgui_replay_error("invalid command text");
+        if(command.text_size == 0) draw_cmd.text = 0;
+        if(command.bitmap_id)
+        {
+            draw_cmd.bitmap = replay_bitmaps + command.bitmap_id;
+            if(!draw_cmd.bitmap->pixels) tgui_replay_error("command use a bitmap that is not in the trace");
+        }
+
+        // NOTE: the commands of the update are still in the buffer, compare before overwrite them
+        if(equal && command_index < update_count)
+        {
+            equal = tgui_replay_command_equal(buffer->buffer + command_index, &draw_cmd);
+        }
+        // NOTE: the text is copy again to the arena, the update text is not used any more
+        buffer->buffer[buffer->count++] = draw_cmd;
+        if(draw_cmd.text)
+        {
+            buffer->buffer[buffer->count - 1].text = (char *)tgui_arena_push_copy(&buffer->arena, draw_cmd.text, draw_cmd.text_size);
+        }
+    }
+    return equal;
+}
+
+static void tgui_replay_bitmap(TGuiReplayReader *reader)
+{
+    u32 id, width, height;
+    if(!tgui_replay_read(reader, &id, sizeof(u32)) ||
+       !tgui_replay_read(reader, &width, sizeof(u32)) ||
+       !tgui_replay_read(reader, &height, sizeof(u32)) ||
+       id == 0 || id > TGUI_TRACE_MAX_BITMAPS)
+    {
+        tgui_replay_error("invalid bitmap chunk");
+    }
+    TGuiBitmap *bitmap = replay_bitmaps + id;
+    free(bitmap->pixels);
+    bitmap->width = width;
+    bitmap->height = height;
+    bitmap->pitch = width*sizeof(u32);
+    bitmap->pixels = (u32 *)malloc((u64)width*height*sizeof(u32));
+    if(!tgui_replay_read(reader, bitmap->pixels, (u64)width*height*sizeof(u32))) tgui_replay_error("invalid bitmap chunk");
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        printf("usage: %s trace.tgtr [font.bmp]\n", argv[0]);
+        return 1;
+    }
+    char *font_path = argc > 2 ? argv[2] : "data/font.bmp";
+
+    TGuiMappedFile trace;
+    if(!tgui_platform_map_file(&trace, argv[1]))
+    {
+        printf("[ERROR]: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    TGuiReplayReader reader = {0};
+    reader.data = trace.data;
+    reader.size = trace.size;
+
+    TGuiTraceHeader header;
+    if(!tgui_replay_read(&reader, &header, sizeof(TGuiTraceHeader)) ||
+       header.magic != TGUI_TRACE_MAGIC || header.version != TGUI_TRACE_VERSION)
+    {
+        tgui_replay_error("invalid trace or version");
+    }
+
+    TGuiImage font_image = {0};
+    if(!tgui_load_bmp(&font_image, font_path))
+    {
+        printf("[ERROR]: cannot load font %s\n", font_path);
+        return 1;
+    }
+    // NOTE: same font than tgui_win32.c
+    TGuiFont font = tgui_create_font(&font_image.bitmap, 7, 9, 18, 6);
+
+    TGuiBitmap backbuffer = {0};
+    backbuffer.width = header.backbuffer_width;
+    backbuffer.height = header.backbuffer_height;
+    backbuffer.pitch = backbuffer.width*sizeof(u32);
+    backbuffer.pixels = (u32 *)malloc((u64)backbuffer.width*backbuffer.height*sizeof(u32));
+    tgui_init(&backbuffer, &font);
+    tgui_optimizer_enable(header.optimizer);
+
+    // NOTE: the snapshot is read in place, the restore copy everything it needs
+    TGuiSnapshot snapshot;
+    snapshot.data = reader.data + reader.offset;
+    snapshot.size = header.snapshot_size;
+    if(!tgui_replay_read(&reader, 0, header.snapshot_size) || !tgui_snapshot_restore(snapshot))
+    {
+        tgui_replay_error("cannot restore the snapshot, the trace is from other version of the library or has widgets of the application");
+    }
+    TGuiState *state = &tgui_global_state;
+    state->mouse_x = header.mouse_x;
+    state->mouse_y = header.mouse_y;
+    state->mouse_is_down = header.mouse_is_down;
+
+    TGuiReplayStats update_stats = {0};
+    TGuiReplayStats raster_stats = {0};
+    u32 frame_count = 0;
+    u32 diverged_count = 0;
+    f64 update_ms = 0;
+    while(reader.offset < reader.size)
+    {
+        u32 chunk_type;
+        if(!tgui_replay_read(&reader, &chunk_type, sizeof(u32))) tgui_replay_error("invalid chunk");
+        switch(chunk_type)
+        {
+            case TGUI_TRACE_EVENTS:
+            {
+                // NOTE: the frame use the recorded time, so the cursor blink is the same
+                f64 frame_time = 0;
+                u32 event_count = 0;
+                if(!tgui_replay_read(&reader, &frame_time, sizeof(f64)) ||
+                   !tgui_replay_read(&reader, &event_count, sizeof(u32)) || event_count > TGUI_EVENT_QUEUE_MAX)
+                {
+                    tgui_replay_error("invalid events chunk");
+                }
+                for(u32 event_index = 0; event_index < event_count; ++event_index)
+                {
+                    TGuiEvent event;
+                    if(!tgui_replay_read(&reader, &event, sizeof(TGuiEvent))) tgui_replay_error("invalid event");
+                    tgui_push_event(event);
+                }
+                state->fixed_time = frame_time;
+                f64 start = tgui_platform_get_time();
+                tgui_update();
+                update_ms = (tgui_platform_get_time() - start)*1000.0;
+            } break;
+            case TGUI_TRACE_COMMANDS:
+            {
+                b32 equal = tgui_replay_commands(&reader, &state->draw_command_buffer);
+                f64 start = tgui_platform_get_time();
+                tgui_clear_backbuffer(&backbuffer);
+                tgui_draw_command_buffer();
+                f64 raster_ms = (tgui_platform_get_time() - start)*1000.0;
+                u64 hash = tgui_replay_hash_backbuffer(&backbuffer);
+
+                printf("frame %u update %.3fms raster %.3fms hash %016llx%s\n", frame_count, update_ms, raster_ms,
+                       (unsigned long long)hash, equal ? "" : " (update diverged)");
+                tgui_replay_stats_add(&update_stats, update_ms);
+                tgui_replay_stats_add(&raster_stats, raster_ms);
+                if(!equal) ++diverged_count;
+                ++frame_count;
+            } break;
+            case TGUI_TRACE_BITMAP:
+            {
+                tgui_replay_bitmap(&reader);
+            } break;
+            default:
+            {
+                tgui_replay_error("invalid chunk");
+            } break;
+        }
+    }
+
+    if(frame_count)
+    {
+        printf("[INFO]: %u frames, update avg %.3fms max %.3fms, raster avg %.3fms max %.3fms, %u diverged\n",
+               frame_count, update_stats.total/frame_count, update_stats.max,
+               raster_stats.total/frame_count, raster_stats.max, diverged_count);
+    }
+
+    tgui_terminate();
+    for(u32 bitmap_index = 0; bitmap_index <= TGUI_TRACE_MAX_BITMAPS; ++bitmap_index)
+    {
+        free(replay_bitmaps[bitmap_index].pixels);
+    }
+    free(backbuffer.pixels);
+    tgui_free_bmp(&font_image);
+    tgui_platform_unmap_file(&trace);
+    return diverged_count ? 2 : 0;
+}
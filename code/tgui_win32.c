@@ -15,6 +15,8 @@ static BITMAPINFO global_bitmap_info;
 static HBITMAP global_bitmap;
 static HDC global_backbuffer_dc;
 static void *global_backbuffer_data;
+// NOTE: fence of the last frame submit, the backbuffer is only read after it is done
+static TGuiFence global_last_fence = 0;
 
 static void win32_create_backbuffer(HDC device)
 {
@@ -40,6 +42,18 @@ static void win32_destroy_backbuffer(void)
     VirtualFree(global_backbuffer_data, 0, MEM_RELEASE);
 }
 
+// NOTE: call from the render thread of tgui with the rects that change
+static void win32_present(TGuiRect *rects, u32 rect_count, void *data)
+{
+    UNUSED_VAR(data);
+    for(u32 rect_index = 0; rect_index < rect_count; ++rect_index)
+    {
+        TGuiRect rect = rects[rect_index];
+        BitBlt(global_device_context, rect.x, rect.y, rect.width, rect.height, global_backbuffer_dc, rect.x, rect.y, SRCCOPY);
+    }
+    GdiFlush();
+}
+
 static LRESULT win32_window_proc(HWND window, UINT message, WPARAM w_param, LPARAM l_param)
 {
     LRESULT result = 0;
@@ -52,6 +66,15 @@ static LRESULT win32_window_proc(HWND window, UINT message, WPARAM w_param, LPAR
         {
             global_running = false;
         }break;
+        case WM_PAINT:
+        {
+            // NOTE: the frames are only draw when they change, the window is repaint from the backbuffer
+            PAINTSTRUCT paint;
+            HDC device = BeginPaint(window, &paint);
+            tgui_fence_wait(global_last_fence);
+            BitBlt(device, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, global_backbuffer_dc, 0, 0, SRCCOPY);
+            EndPaint(window, &paint);
+        }break;
         case WM_KEYDOWN:
         {
             TGuiEventKey key_event = {0};
@@ -104,8 +127,15 @@ static LRESULT win32_window_proc(HWND window, UINT message, WPARAM w_param, LPAR
 
 int main(int argc, char** argv)
 {
-    UNUSED_VAR(argc);
-    UNUSED_VAR(argv);
+    // NOTE: tgui.exe -record session.tgtr save the session to replay it with tgui_replay
+    // and tgui.exe -timeline timeline.json write a chrome trace of every frame
+    char *record_path = 0;
+    char *timeline_path = 0;
+    for(i32 arg = 1; arg + 1 < argc; arg += 2)
+    {
+        if(strcmp(argv[arg], "-record") == 0) record_path = argv[arg + 1];
+        if(strcmp(argv[arg], "-timeline") == 0) timeline_path = argv[arg + 1];
+    }
  
     WNDCLASSA window_class = {0};
     window_class.style = CS_HREDRAW|CS_VREDRAW|CS_OWNDC;
@@ -141,17 +171,6 @@ int main(int argc, char** argv)
     global_running = true;
     win32_create_backbuffer(global_device_context);
    
-    u32 frames_per_second = 30;
-    u32 ms_per_frame = 1000 / frames_per_second;
-    f32 delta_time = 1.0f / (f32)frames_per_second;
-    LARGE_INTEGER large_frequency;
-    LARGE_INTEGER large_last_time;
-    QueryPerformanceFrequency(&large_frequency);
-    QueryPerformanceCounter(&large_last_time);
-    u64 last_time = large_last_time.QuadPart;
-    
-    UNUSED_VAR(delta_time);
-    
     // NOTE: backbuffer for tgui to draw all the elements
     TGuiBitmap tgui_backbuffer = {0};
     tgui_backbuffer.width = WINDOW_WIDTH;
@@ -160,12 +179,22 @@ int main(int argc, char** argv)
     tgui_backbuffer.pitch = tgui_backbuffer.width * sizeof(u32);
     
     // NOTE: load bitmap for testing
-    TGuiBitmap test_bitmap = tgui_debug_load_bmp("data/font.bmp");
+    TGuiImage test_image = {0};
+    tgui_load_bmp(&test_image, "data/font.bmp");
+    TGuiBitmap test_bitmap = test_image.bitmap;
     // NOTE: create a font for testing 
     TGuiFont test_font = tgui_create_font(&test_bitmap, 7, 9, 18, 6);
     
     // NOTE: init TGUI lib
     tgui_init(&tgui_backbuffer, &test_font);
+    tgui_damage_enable(true);
+    tgui_optimizer_enable(true);
+    tgui_hit_batch_enable(true);
+    // NOTE: the frames are draw and present in other thread while the next one is update
+    tgui_pipeline_begin(win32_present, 0);
+    // NOTE: the roots are lay out in the other cores (the render thread and this one take one each)
+    u32 cpu_count = tgui_platform_cpu_count();
+    if(cpu_count > 2) tgui_jobs_begin(cpu_count - 2);
     
     TGuiHandle frame1 = tgui_create_container(100, 100, 150, 200, TGUI_CONTAINER_DYNAMIC, TGUI_LAYOUT_VERTICAL, true, 5);
     TGuiHandle frame2 = tgui_create_container(450, 120, 100, 240, TGUI_CONTAINER_V_SCROLL|TGUI_CONTAINER_H_SCROLL, TGUI_LAYOUT_VERTICAL, true, 20);
@@ -215,7 +244,7 @@ int main(int argc, char** argv)
         tgui_container_add_widget(frame4, buttons2[i]);
     }
     
-    TGuiHandle frame5 = tgui_create_container(400, 20, 0, 0, TGUI_CONTAINER_DYNAMIC|TGUI_CONTAINER_DRAGGABLE, TGUI_LAYOUT_HORIZONTAL, true, 10);
+    TGuiHandle frame5 = tgui_create_container(400, 20, 0, 0, TGUI_CONTAINER_DYNAMIC|TGUI_CONTAINER_DRAGGABLE|TGUI_CONTAINER_CACHED, TGUI_LAYOUT_HORIZONTAL, true, 10);
     tgui_widget_to_root(frame5);
     
     TGuiHandle textbox = tgui_create_textbox(200, 200);
@@ -228,60 +257,63 @@ int main(int argc, char** argv)
     printf("[INFO]: total allocated used %llu (bytes)\n", tgui_global_state.widget_allocator.count*sizeof(TGuiWidget));
     printf("[INFO]: total allocated size %llu (bytes)\n", tgui_global_state.widget_allocator.buffer_size*sizeof(TGuiWidget));
 
-    while(global_running)
+    if(record_path && !tgui_record_begin(record_path))
     {
-        LARGE_INTEGER large_current_time;
-        QueryPerformanceCounter(&large_current_time);
-        u64 current_time = large_current_time.QuadPart;
-        f32 curret_sec_per_frame = (f32)(current_time - last_time) / (f32)large_frequency.QuadPart;
-        u64 current_ms_per_frame = (u64)(curret_sec_per_frame * 1000.0f); 
-        if(current_ms_per_frame < ms_per_frame)
-        {
-            i32 ms_to_sleep = ms_per_frame - current_ms_per_frame;
-            Sleep(ms_to_sleep);
-        }
-        QueryPerformanceCounter(&large_current_time);
-        current_time = large_current_time.QuadPart;
-        f32 debug_current_ms = (f32)(current_time - last_time) / (f32)large_frequency.QuadPart;
-        last_time = current_time;
+        printf("[ERROR]: cannot record to %s\n", record_path);
+    }
+    if(timeline_path && !tgui_timeline_begin(timeline_path))
+    {
+        printf("[ERROR]: cannot write the timeline to %s (build with TGUI_PROFILE)\n", timeline_path);
+    }
 
+    while(global_running)
+    {
         MSG message;
-        while(PeekMessageA(&message, window, 0, 0, PM_REMOVE))
+        while(PeekMessageA(&message, 0, 0, 0, PM_REMOVE))
         {
             TranslateMessage(&message);
             DispatchMessageA(&message);
         }
         
         // NOTE: Update TGUI lib
-        tgui_update();
-        // NOTE: clear the screen
-        tgui_clear_backbuffer(&tgui_backbuffer);
-         
+        TGuiUpdateResult result = tgui_update();
+
+        // NOTE: the backbuffer is not clear, only the dirty rects are draw again
         char debug_str[256];
         u32 font_height = 9;
         sprintf(debug_str, "mouse pos (x:%d, y:%d)", tgui_global_state.mouse_x, tgui_global_state.mouse_y);
-        tgui_draw_text(&tgui_backbuffer, &test_font, font_height, 0, tgui_backbuffer.height - font_height, debug_str, strlen(debug_str));
-        
-        sprintf(debug_str, "ms:%.3f", debug_current_ms);
-        tgui_draw_text(&tgui_backbuffer, &test_font, font_height, 0, 0, debug_str, strlen(debug_str));
-        sprintf(debug_str, "fps:%d", (u32)(1.0f/debug_current_ms+0.5f));
-        tgui_draw_text(&tgui_backbuffer, &test_font, font_height, 0, font_height, debug_str, strlen(debug_str));
+        TGuiDrawCommand debug_text_command = {0};
+        debug_text_command.type = TGUI_DRAWCMD_TEXT;
+        debug_text_command.descriptor = tgui_rect_xywh(0, tgui_backbuffer.height - font_height, 0, font_height);
+        debug_text_command.text = debug_str;
+        debug_text_command.text_size = strlen(debug_str);
+        tgui_push_draw_command(debug_text_command);
 
-        tgui_draw_bitmap(&tgui_backbuffer, &test_bitmap, tgui_backbuffer.width - test_bitmap.width, 0, test_bitmap.width, test_bitmap.height);
-        TGuiDrawCommand test_draw_bitmap_command; 
+        // NOTE: frame time and profile counters (build with TGUI_PROFILE)
+        tgui_draw_frame_stats(0, 0);
+
+        TGuiDrawCommand test_draw_bitmap_command = {0};
         test_draw_bitmap_command.type = TGUI_DRAWCMD_BITMAP;
         test_draw_bitmap_command.descriptor = tgui_rect_xywh(tgui_backbuffer.width - test_bitmap.width, 0, test_bitmap.width, test_bitmap.height);
         test_draw_bitmap_command.bitmap = &test_bitmap;
         tgui_push_draw_command(test_draw_bitmap_command);
-        
-        tgui_draw_command_buffer();
-        
-        // NOTE: Blt the backbuffer on to the destination window
-        BitBlt(global_device_context, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, global_backbuffer_dc, 0, 0, SRCCOPY);
+
+        // NOTE: submit only draw the frame if it change (the debug text too), only the rects that
+        // change are Blt by win32_present
+        global_last_fence = tgui_submit_frame();
+
+        // NOTE: sleep until a message arrive or the deadline of tgui_update pass
+        DWORD timeout = INFINITE;
+        if(result.deadline > 0)
+        {
+            f64 wait = result.deadline - tgui_platform_get_time();
+            timeout = wait > 0 ? (DWORD)(wait*1000.0) + 1 : 0;
+        }
+        MsgWaitForMultipleObjects(0, 0, FALSE, timeout, QS_ALLINPUT);
     }
     
     tgui_terminate();
-    tgui_debug_free_bmp(&test_bitmap);
+    tgui_free_bmp(&test_image);
     win32_destroy_backbuffer();
 
     return 0;